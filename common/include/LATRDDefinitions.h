@@ -77,6 +77,8 @@ namespace LATRD
   static const uint64_t fine_timestamp_mask             = 0x00000000007FFFFF;
   static const uint64_t energy_mask                     = 0x0000000000003FFF;
   static const uint64_t position_mask                   = 0x0000000003FFFFFF;
+  static const uint32_t position_y_mask                 = 0x00001FFF;
+  static const uint32_t position_x_shift                = 13;
   static const uint64_t timestamp_match_mask            = 0x000FFFFFFF800000;
 
   static const uint64_t course_timestamp_rollover       = 0x00000000001FFFFF;
@@ -124,6 +126,18 @@ namespace LATRD
     return (uint32_t )(headerWord2 & header_packet_count_mask);
   }
 
+  static uint32_t get_position_x(uint32_t position_id)
+  {
+    // The upper bits of the position ID hold the x coordinate
+    return position_id >> position_x_shift;
+  }
+
+  static uint32_t get_position_y(uint32_t position_id)
+  {
+    // The lower bits of the position ID hold the y coordinate
+    return position_id & position_y_mask;
+  }
+
   static bool is_control_word(uint64_t data_word)
   {
     bool ctrlWord = false;
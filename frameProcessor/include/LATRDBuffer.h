@@ -6,7 +6,18 @@
  *
  *  The LATRD Buffer class is responsible for keeping track of data points
  *  and producing full frames whenever one is available.
- *  Internally a block of memory is allocated that can store a full frame.
+ *  Internally a block of memory is allocated that can store a full frame,
+ *  optionally backed by huge pages.
+ *  Frame numbers are either calculated from the process rank or taken from
+ *  a shared frame counter when the frame is started.  Buffers that always
+ *  fill in step (for example the event columns) can follow the frame
+ *  numbers of a leading buffer, provided the same points are appended to
+ *  the leader first.  A follower that has not received any points since its
+ *  frame numbers were reset is not written, so columns unused by the output
+ *  format do not produce empty frames.
+ *  A frame that already holds a complete block of points can be numbered
+ *  and forwarded in place of the buffer's own frame, so that data already
+ *  laid out in full frames is passed on without being copied.
  */
 
 #ifndef FRAMEPROCESSOR_SRC_LATRDBUFFER_H_
@@ -19,13 +30,15 @@
 #include <string>
 #include "Frame.h"
 #include "LATRDExceptions.h"
+#include "LATRDFrameCounter.h"
+#include "LATRDMemoryBlock.h"
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
 
 namespace FrameProcessor
 {
-enum LATRDBufferType {UINT64_TYPE, UINT32_TYPE, UINT16_TYPE};
+enum LATRDBufferType {UINT64_TYPE, UINT32_TYPE, UINT16_TYPE, UINT8_TYPE};
 
 class LATRDBuffer {
 
@@ -33,11 +46,24 @@ public:
 	LATRDBuffer(size_t numberOfDataPoints, const std::string& frame, LATRDBufferType type);
 	virtual ~LATRDBuffer();
 	boost::shared_ptr<Frame> appendData(void *data_ptr, size_t qty_pts);
+	boost::shared_ptr<Frame> forwardFrame(boost::shared_ptr<Frame> frame);
 	boost::shared_ptr<Frame> retrieveCurrentFrame();
+	size_t remaining();
+	uint64_t position();
+	uint64_t currentFrameNumber();
 	void configureProcess(size_t processes, size_t rank);
+	void setFrameCounter(boost::shared_ptr<LATRDFrameCounter> counter, LATRDFrameCounterSlot slot);
+	void followFrameNumbers(boost::shared_ptr<LATRDBuffer> leader);
+	void allocate(bool huge_pages);
+	bool hugePages();
   void resetFrameNumber();
 
 private:
+	void startFrame();
+	bool claimed();
+	boost::shared_ptr<Frame> fullFrame();
+
+	boost::shared_ptr<LATRDMemoryBlock> block_;
 	void *rawDataPtr_;
 	size_t numberOfPoints_;
 	size_t currentPoint_;
@@ -47,6 +73,12 @@ private:
 	uint64_t frameNumber_;
 	size_t concurrent_processes_;
 	size_t concurrent_rank_;
+	bool frameStarted_;
+	bool used_;
+	uint64_t currentFrameNumber_;
+	boost::shared_ptr<LATRDFrameCounter> frameCounter_;
+	LATRDFrameCounterSlot counterSlot_;
+	boost::shared_ptr<LATRDBuffer> leader_;
 
 	/** Pointer to logger */
 	LoggerPtr logger_;
@@ -0,0 +1,88 @@
+// The LATRDClusterer class groups events from neighbouring pixels that
+// arrive within a time window of each other into clusters, and reduces each
+// cluster to its centroid, total energy, size and first timestamp.
+//
+// Released jobs are split into partitions of consecutive time slices that
+// are clustered in parallel, each partition keeping its own clusters so no
+// locking is required.  Clusters that may continue into another partition,
+// because their time range comes within the window of that partition, are
+// stitched together afterwards.  Clusters that may still grow with the next
+// released data are held back and stitched again on the next release, until
+// the data is purged.
+//
+// Pixels are taken from the position IDs of the events within the sensor
+// image, which are the mapped IDs when a geometry is applied.  Centroids are weighted by the
+// event energies.  Cluster energies are in keV once a calibration is applied, whether the
+// events are written as float or fixed point values, otherwise they are raw energies.
+//
+
+#ifndef LATRD_LATRDCLUSTERER_H
+#define LATRD_LATRDCLUSTERER_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#include "LATRDProcessJob.h"
+#include "LATRDTaskPool.h"
+
+namespace FrameProcessor {
+
+  class LATRDCluster
+  {
+  public:
+    LATRDCluster();
+    void add_event(uint64_t ts, uint32_t position_id, float energy);
+    void merge(const LATRDCluster& other);
+    bool touches(const LATRDCluster& other, uint64_t window) const;
+    float centroid_x() const;
+    float centroid_y() const;
+
+    uint64_t first_ts;
+    uint64_t last_ts;
+    float energy;
+    double sum_x;
+    double sum_y;
+    double sum_weight;
+    /** Position IDs of the events in the cluster */
+    std::vector<uint32_t> pixels;
+  };
+
+  class LATRDClusterer
+  {
+  public:
+    LATRDClusterer(uint64_t window, size_t partitions);
+    virtual ~LATRDClusterer();
+    size_t partitions();
+    uint64_t window();
+    void cluster_events(size_t partition, const std::vector<boost::shared_ptr<LATRDProcessJob> >& jobs);
+    std::vector<LATRDCluster> stitch(bool purge);
+
+  private:
+    uint64_t window_;
+
+    /** Clusters found in each partition along with the time range of the partition */
+    std::vector<std::vector<LATRDCluster> > partials_;
+    std::vector<uint64_t> partial_min_;
+    std::vector<uint64_t> partial_max_;
+
+    /** Clusters from earlier releases that may still grow */
+    std::vector<LATRDCluster> pending_;
+  };
+
+  class LATRDClusterTask : public LATRDTask
+  {
+  public:
+    LATRDClusterTask(LATRDClusterer *clusterer, size_t partition);
+    void execute();
+
+    LATRDClusterer *clusterer;
+    size_t partition;
+    std::vector<boost::shared_ptr<LATRDProcessJob> > jobs;
+  };
+
+}
+
+#endif //LATRD_LATRDCLUSTERER_H
@@ -0,0 +1,58 @@
+// The LATRDCompressor class compresses output frames so that they can be
+// written with a direct chunk write.  The compressed layout is identical
+// to that produced by the HDF5 bitshuffle filter with LZ4 compression, so
+// the resulting datasets are readable by any HDF5 application with the
+// bitshuffle filter plugin installed.  Timestamp datasets can optionally
+// be delta encoded before shuffling, in which case readers must apply
+// delta_decode to the decompressed values.
+
+#ifndef LATRD_LATRDCOMPRESSOR_H
+#define LATRD_LATRDCOMPRESSOR_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Frame.h"
+#include "LATRDExceptions.h"
+#include "LATRDTaskPool.h"
+
+namespace FrameProcessor {
+
+  enum LATRDCompressionType {NO_COMPRESSION, BSLZ4_COMPRESSION};
+
+  /** Compression type tag understood by the file writer for bitshuffle/LZ4 chunks */
+  static const int bslz4_frame_compression = 2;
+
+  class LATRDCompressor
+  {
+  public:
+    static bool available();
+    static size_t element_size(int data_type);
+    static boost::shared_ptr<Frame> compress(boost::shared_ptr<Frame> frame, bool delta);
+    static void delta_encode(uint64_t *data, size_t qty_pts);
+    static void delta_decode(uint64_t *data, size_t qty_pts);
+    static void bitshuffle(const void *in, void *out, size_t size, size_t elem_size);
+    static void bitunshuffle(const void *in, void *out, size_t size, size_t elem_size);
+    static size_t bslz4_bound(size_t size, size_t elem_size);
+    static size_t compress_bslz4(const void *in, void *out, size_t size, size_t elem_size);
+    static size_t decompress_bslz4(const void *in, size_t in_bytes, void *out, size_t out_bytes, size_t elem_size);
+  };
+
+  class LATRDCompressionTask : public LATRDTask
+  {
+  public:
+    LATRDCompressionTask(boost::shared_ptr<Frame> frame, bool delta);
+    void execute();
+
+    boost::shared_ptr<Frame> in_frame;
+    boost::shared_ptr<Frame> out_frame;
+    bool delta;
+  };
+
+}
+
+#endif //LATRD_LATRDCOMPRESSOR_H
@@ -0,0 +1,66 @@
+// The LATRDEnergyCalibration class converts the raw time over threshold
+// energies of events into calibrated energies in keV, using the surrogate
+// function of each pixel:
+//   ToT = a * E + b - c / (E - t)
+// which is inverted for E.  Calibration files are binary files holding the
+// four float32 coefficients a, b, c and t for each pixel of the sensor, in
+// row order.  Pixels with a zero gradient are treated as uncalibrated and
+// produce an energy of zero.
+//
+// Calibrated energies are written in place of the raw energies, either as
+// float32 values or as unsigned fixed point values with a configurable
+// number of fractional bits.  A calibration is not modified once it has
+// been loaded, a new calibration is created whenever the settings change.
+//
+
+#ifndef LATRD_LATRDENERGYCALIBRATION_H
+#define LATRD_LATRDENERGYCALIBRATION_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  /** Representation of the energies written to the output datasets */
+  enum LATRDEnergyOutput {RAW_ENERGY, FLOAT_ENERGY, FIXED_ENERGY};
+
+  /** Number of surrogate function coefficients stored for each pixel */
+  static const size_t calibration_coefficients = 4;
+
+  class LATRDEnergyCalibration
+  {
+  public:
+    LATRDEnergyCalibration(uint32_t width, uint32_t height, LATRDEnergyOutput output, uint32_t fraction_bits);
+    virtual ~LATRDEnergyCalibration();
+    void set_coefficients(const std::vector<float>& coefficients);
+    void load_coefficients(const std::string& filename);
+    LATRDEnergyOutput output();
+    uint32_t fraction_bits();
+    float energy(uint32_t position_id, uint32_t tot);
+    void calibrate(const uint32_t *event_id, uint32_t *event_energy, uint16_t qty_events);
+
+  private:
+    /** Terms of the inverted surrogate function, precomputed so that each event reads one entry */
+    struct PixelTerms
+    {
+      float offset;
+      float centre;
+      float four_ac;
+      float inv_two_a;
+    };
+
+    uint32_t width_;
+    uint32_t height_;
+    LATRDEnergyOutput output_;
+    uint32_t fraction_bits_;
+    float fixed_scale_;
+    std::vector<PixelTerms> terms_;
+  };
+
+}
+
+#endif //LATRD_LATRDENERGYCALIBRATION_H
@@ -0,0 +1,50 @@
+// The LATRDEventCodec class converts between the three column event
+// representation (time, position ID, energy) and the compact output formats.
+//
+// Packed records are three little endian 32 bit words per event:
+//   word 0 - time bits 0..31
+//   word 1 - time bits 32..51, energy bits 0..11 in bits 20..31
+//   word 2 - energy bits 12..13 in bits 0..1, position ID in bits 2..27
+//
+// Varint blocks start with the number of events in the block, followed by
+// the zigzag encoded time difference from the previous event in the block
+// (the first event is relative to zero), the position ID and the energy for
+// each event.  Blocks are independent, so a stream is decoded block by block.
+//
+
+#ifndef LATRD_LATRDEVENTCODEC_H
+#define LATRD_LATRDEVENTCODEC_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+namespace FrameProcessor {
+
+  enum LATRDEventFormat {COLUMN_EVENT_FORMAT, PACKED_EVENT_FORMAT, VARINT_EVENT_FORMAT};
+
+  /** Number of 32 bit words in a packed event record */
+  static const size_t packed_event_words = 3;
+
+  /** Maximum number of bytes in a varint encoded event */
+  static const size_t varint_event_max_bytes = 16;
+
+  class LATRDEventCodec
+  {
+  public:
+    static void pack_record(uint64_t ts, uint32_t id, uint32_t energy, uint32_t *record);
+    static void unpack_record(const uint32_t *record, uint64_t *ts, uint32_t *id, uint32_t *energy);
+    static size_t pack_records(const uint64_t *ts, const uint32_t *id, const uint32_t *energy, size_t qty_pts, uint32_t *out);
+    static size_t unpack_records(const uint32_t *in, size_t qty_pts, uint64_t *ts, uint32_t *id, uint32_t *energy);
+    static size_t varint_bound(size_t qty_pts);
+    static size_t encode_varint_block(const uint64_t *ts, const uint32_t *id, const uint32_t *energy, size_t qty_pts, uint8_t *out);
+    static size_t decode_varint_stream(const uint8_t *in,
+                                       size_t bytes,
+                                       std::vector<uint64_t>& ts,
+                                       std::vector<uint32_t>& id,
+                                       std::vector<uint32_t>& energy);
+  };
+
+}
+
+#endif //LATRD_LATRDEVENTCODEC_H
@@ -0,0 +1,66 @@
+// The LATRDEventFilter class removes unwanted events from the decoded event
+// arrays of a job.  Events can be rejected when their energy is outside of
+// a window, when their pixel is outside of a rectangular or bitmap region
+// of interest, or when their pixel is set in a dead/hot pixel mask.
+//
+// Pixels are tested using a separate array of position IDs, which is the
+// event_id array itself or the IDs of the mapped image pixels when a
+// geometry is applied.  The regions are given in sensor image coordinates.
+//
+// Bitmaps are binary files of width x height bytes in row order, any non
+// zero byte selects the pixel.  A filter is not modified once it has been
+// configured, so a new filter is created whenever the settings change.
+//
+
+#ifndef LATRD_LATRDEVENTFILTER_H
+#define LATRD_LATRDEVENTFILTER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  class LATRDEventFilter
+  {
+  public:
+    LATRDEventFilter(uint32_t width, uint32_t height);
+    virtual ~LATRDEventFilter();
+    void set_energy_window(uint32_t min, uint32_t max);
+    void set_roi(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void set_roi_map(const std::vector<uint8_t>& map);
+    void set_mask(const std::vector<uint8_t>& mask);
+    std::vector<uint8_t> load_map(const std::string& filename);
+    bool enabled();
+    uint16_t filter(uint64_t *event_ts,
+                    uint32_t *event_id,
+                    uint32_t *event_pixel,
+                    uint32_t *event_energy,
+                    uint16_t qty_events,
+                    uint32_t *ctrl_index,
+                    uint16_t qty_ctrl,
+                    uint32_t *energy_rejects,
+                    uint32_t *roi_rejects,
+                    uint32_t *mask_rejects);
+
+  private:
+    uint32_t width_;
+    uint32_t height_;
+    bool energy_enabled_;
+    uint32_t energy_min_;
+    uint32_t energy_max_;
+    bool roi_enabled_;
+    uint32_t roi_x_;
+    uint32_t roi_y_;
+    uint32_t roi_width_;
+    uint32_t roi_height_;
+    std::vector<uint8_t> roi_map_;
+    std::vector<uint8_t> mask_;
+  };
+
+}
+
+#endif //LATRD_LATRDEVENTFILTER_H
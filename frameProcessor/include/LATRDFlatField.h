@@ -0,0 +1,72 @@
+// The LATRDFlatField class corrects count mode images for the response of
+// each pixel.  Every pixel count is multiplied by the gain of the pixel
+// from a flat field gain map, and pixels set in a dead/hot pixel mask are
+// written as zero.  Gain files are binary files holding one float32 gain
+// for each pixel of the sensor in row order, and mask files hold one byte
+// for each pixel with any non zero byte masking the pixel.  Gains that are
+// negative or not finite are treated as masked.
+//
+// Gains and the mask are combined into a single factor for each pixel when
+// they are set, so correcting an image is one multiply per pixel in a loop
+// the compiler can vectorise.  Corrected images are written as float32
+// values or as unsigned fixed point values with a configurable number of
+// fractional bits, saturating at the largest value.  A flat field is not
+// modified once it has been loaded, a new one is created whenever the
+// settings change.
+//
+
+#ifndef LATRD_LATRDFLATFIELD_H
+#define LATRD_LATRDFLATFIELD_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Frame.h"
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  /** Representation of the corrected images */
+  enum LATRDFlatFieldOutput {FLOAT_FLAT_FIELD, FIXED_FLAT_FIELD};
+
+  class LATRDFlatField
+  {
+  public:
+    LATRDFlatField(uint32_t width, uint32_t height, LATRDFlatFieldOutput output, uint32_t fraction_bits);
+    virtual ~LATRDFlatField();
+    void set_gain(const std::vector<float>& gain);
+    void load_gain(const std::string& filename);
+    void set_mask(const std::vector<uint8_t>& mask);
+    void load_mask(const std::string& filename);
+    uint32_t width();
+    uint32_t height();
+    LATRDFlatFieldOutput output();
+    boost::shared_ptr<Frame> correct(const void *image, uint32_t depth, uint32_t number);
+
+  private:
+    void update_factors();
+    template <typename T> void correct_float(const T *image, float *output);
+    template <typename T> void correct_fixed(const T *image, uint32_t *output);
+
+    uint32_t width_;
+    uint32_t height_;
+    LATRDFlatFieldOutput output_;
+    float fixed_scale_;
+    std::vector<float> gain_;
+    std::vector<uint8_t> mask_;
+
+    /** Combined gain and mask of each pixel, scaled for fixed point output */
+    std::vector<float> factors_;
+
+    /** Corrected image, reused for each image */
+    std::vector<float> float_image_;
+    std::vector<uint32_t> fixed_image_;
+  };
+
+}
+
+#endif //LATRD_LATRDFLATFIELD_H
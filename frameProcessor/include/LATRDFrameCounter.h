@@ -0,0 +1,46 @@
+// The LATRDFrameCounter class hands out global output frame numbers from a
+// counter held in POSIX shared memory.  Every processor rank on the host
+// opens the same named segment, so ranks can produce frames at their own
+// rate while the frame numbers across all ranks remain dense.  Each type of
+// output frame has its own counter slot.  The segment outlives the ranks
+// that open it until it is unlinked, which is left to a single designated
+// rank so that a new acquisition starts from a fresh counter.
+
+#ifndef LATRD_LATRDFRAMECOUNTER_H
+#define LATRD_LATRDFRAMECOUNTER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  enum LATRDFrameCounterSlot {EVENT_FRAME_SLOT, CUE_FRAME_SLOT, RAW_FRAME_SLOT, CLUSTER_FRAME_SLOT, RAW_INDEX_FRAME_SLOT, NUMBER_OF_FRAME_SLOTS};
+
+  class LATRDFrameCounter
+  {
+  public:
+    LATRDFrameCounter(const std::string& name);
+    virtual ~LATRDFrameCounter();
+    static std::string segment_name(const std::string& name);
+    const std::string& name();
+    uint64_t next(LATRDFrameCounterSlot slot);
+    void reset();
+    void unlink();
+
+  private:
+    /** Name of the shared memory segment */
+    std::string name_;
+
+    /** File descriptor of the shared memory segment */
+    int fd_;
+
+    /** Counters mapped from the shared memory segment */
+    uint64_t *counters_;
+  };
+
+}
+
+#endif //LATRD_LATRDFRAMECOUNTER_H
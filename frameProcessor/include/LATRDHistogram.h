@@ -0,0 +1,71 @@
+// The LATRDHistogramSet class accumulates online diagnostics from decoded
+// jobs: a global energy spectrum, the number of events in each time slice
+// and optionally an energy spectrum for each producing module.
+//
+// Each worker thread owns a LATRDHistogramExchange holding two sets.  The
+// worker always writes into the active set and the collecting thread swaps
+// the sets over before merging the inactive one, so the worker is never
+// blocked.  The collector only waits for a job that started writing into a
+// set before the swap to complete.
+//
+
+#ifndef LATRD_LATRDHISTOGRAM_H
+#define LATRD_LATRDHISTOGRAM_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "LATRDProcessJob.h"
+
+namespace FrameProcessor {
+
+  /** Number of bins in an energy spectrum, one for each possible energy value */
+  static const size_t energy_spectrum_bins = 16384;
+
+  class LATRDHistogramSet
+  {
+  public:
+    LATRDHistogramSet();
+    virtual ~LATRDHistogramSet();
+    void add_job(LATRDProcessJob *job, bool modules);
+    void merge(LATRDHistogramSet& other);
+    void clear();
+    bool empty();
+
+    /** Number of events added to the set */
+    uint64_t events;
+
+    /** Global energy spectrum */
+    std::vector<uint64_t> energy;
+
+    /** Event counts indexed by time slice ID */
+    std::map<uint32_t, uint64_t> time_slices;
+
+    /** Energy spectra indexed by producer ID */
+    std::map<uint8_t, std::vector<uint64_t> > modules;
+  };
+
+  class LATRDHistogramExchange
+  {
+  public:
+    LATRDHistogramExchange();
+    virtual ~LATRDHistogramExchange();
+    LATRDHistogramSet *begin_job();
+    void end_job();
+    void collect(LATRDHistogramSet& total);
+
+  private:
+    /** Set currently written by the worker */
+    volatile uint32_t write_index_;
+
+    /** One more than the index of the set in use by a job, zero if no job is running */
+    volatile uint32_t busy_;
+
+    LATRDHistogramSet sets_[2];
+  };
+
+}
+
+#endif //LATRD_LATRDHISTOGRAM_H
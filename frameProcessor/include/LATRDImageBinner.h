@@ -0,0 +1,78 @@
+// The LATRDImageBinner class builds a sequence of 2D count images from
+// decoded events, each image covering a fixed width of event time.
+//
+// Released jobs are split into partitions that are binned in parallel, each
+// partition keeping its own partial images so no locking is required.  When
+// the time of released data passes the end of a bin the partial images for
+// that bin are merged and the image is emitted.  Only bins containing
+// events are emitted, so the bin of each image is returned alongside it.
+// Events that arrive for a bin that has already been closed are counted as
+// late and discarded.
+//
+
+#ifndef LATRD_LATRDIMAGEBINNER_H
+#define LATRD_LATRDIMAGEBINNER_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "Frame.h"
+#include "LATRDProcessJob.h"
+#include "LATRDTaskPool.h"
+
+namespace FrameProcessor {
+
+  class LATRDImageBinner
+  {
+  public:
+    LATRDImageBinner(uint32_t width, uint32_t height, uint64_t bin_width, size_t partitions);
+    virtual ~LATRDImageBinner();
+    void configure_process(size_t processes, size_t rank);
+    size_t partitions();
+    void bin_events(size_t partition, LATRDProcessJob *job);
+    std::vector<boost::shared_ptr<Frame> > close_bins(uint64_t watermark, std::vector<uint64_t>& bins);
+    std::vector<boost::shared_ptr<Frame> > close_all(std::vector<uint64_t>& bins);
+    uint64_t bin_width();
+    uint64_t late_events();
+
+  private:
+    std::vector<boost::shared_ptr<Frame> > close_before(uint64_t end_bin, std::vector<uint64_t>& bins);
+    boost::shared_ptr<Frame> create_image(uint64_t bin);
+
+    uint32_t width_;
+    uint32_t height_;
+    uint64_t bin_width_;
+    size_t processes_;
+    size_t rank_;
+
+    /** Partial images for each partition, indexed by bin */
+    std::vector<std::map<uint64_t, std::vector<uint32_t> > > partials_;
+
+    /** Late event count for each partition */
+    std::vector<uint64_t> late_;
+
+    /** Bins below this have been closed */
+    uint64_t next_bin_;
+
+    /** Number of images emitted */
+    uint64_t images_;
+  };
+
+  class LATRDImageBinTask : public LATRDTask
+  {
+  public:
+    LATRDImageBinTask(LATRDImageBinner *binner, size_t partition);
+    void execute();
+
+    LATRDImageBinner *binner;
+    size_t partition;
+    std::vector<boost::shared_ptr<LATRDProcessJob> > jobs;
+  };
+
+}
+
+#endif //LATRD_LATRDIMAGEBINNER_H
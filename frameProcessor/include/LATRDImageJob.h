@@ -8,20 +8,34 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <vector>
+#include <limits>
 #include <boost/shared_ptr.hpp>
 
 #include "Frame.h"
+#include "LATRDMemoryBlock.h"
 
 namespace FrameProcessor {
 
+    /** Add a count to a pixel, holding the pixel at the largest value of its type instead of wrapping */
+    template <typename T> inline void saturating_add(T& pixel, uint32_t count)
+    {
+      uint64_t sum = (uint64_t)pixel + count;
+      uint64_t limit = std::numeric_limits<T>::max();
+      pixel = (T)(sum < limit ? sum : limit);
+    }
+
     class LATRDImageJob
     {
     public:
-      LATRDImageJob(uint32_t width, uint32_t height, uint32_t number);
+      LATRDImageJob(uint32_t width, uint32_t height, uint32_t number, uint32_t depth, bool huge_pages);
+      LATRDImageJob(uint32_t width, uint32_t height, uint32_t number, uint32_t depth,
+                    boost::shared_ptr<LATRDMemoryBlock> pool, size_t offset);
       virtual ~LATRDImageJob();
       void set_eoi(uint32_t packet_id);
       uint32_t get_frame_number();
-      void add_pixel(uint32_t packet_id, uint32_t x, uint32_t y, uint32_t event_count);
+      void set_frame_number(uint32_t number);
+      void add_packet(uint32_t packet_id);
+      void add_pixel(uint32_t x, uint32_t y, uint32_t event_count);
       bool verify_image();
       boost::shared_ptr<Frame> to_frame();
       void reset();
@@ -30,11 +44,16 @@ namespace FrameProcessor {
 
       uint32_t width_;
       uint32_t height_;
+      /** Bits per pixel of the image, 16 or 32 */
+      uint32_t depth_;
       uint32_t frame_number_;
-      uint16_t *image_ptr_;
+      /** Memory holding the image, either owned by this job or a pool shared between jobs */
+      boost::shared_ptr<LATRDMemoryBlock> image_block_;
+      void *image_ptr_;
       uint64_t timestamp_;
       bool sent_;
-      std::map<uint32_t, uint32_t> packet_ids_;
+      /** One bit for each packet ID received for the image */
+      std::vector<uint64_t> packet_bits_;
       int32_t eoi_packet_id_;
     };
 
@@ -0,0 +1,62 @@
+// The LATRDImageReducer class produces the reduced count mode image
+// streams from the full resolution images as they are completed.
+//
+// Consecutive images are summed in groups of a fixed size, and a live view
+// image is taken from the stream no more often than a fixed interval.  Both
+// streams can be spatially binned, with each output pixel holding the sum
+// of a square of sensor pixels.  Binning is applied while the sum is
+// accumulated so only the binned sum is stored.  Reduced images are 32 bit
+// and saturate rather than wrap.
+//
+
+#ifndef LATRD_LATRDIMAGEREDUCER_H
+#define LATRD_LATRDIMAGEREDUCER_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Frame.h"
+
+namespace FrameProcessor {
+
+  class LATRDImageReducer
+  {
+  public:
+    LATRDImageReducer(uint32_t width, uint32_t height, uint32_t depth,
+                      uint32_t sum_images, uint32_t bin, uint64_t live_interval);
+    virtual ~LATRDImageReducer();
+    std::vector<boost::shared_ptr<Frame> > add_image(const void *image, uint32_t image_number, uint64_t now);
+    std::vector<boost::shared_ptr<Frame> > flush();
+    uint32_t binned_width();
+    uint32_t binned_height();
+
+  private:
+    template <typename T> void bin_image(const T *image, uint32_t *output);
+    boost::shared_ptr<Frame> create_frame(const std::vector<uint32_t>& image, const std::string& name, uint32_t number);
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t depth_;
+    uint32_t sum_images_;
+    uint32_t bin_;
+    uint32_t binned_width_;
+    uint32_t binned_height_;
+
+    /** Binned sum of the images added since the last sum was emitted */
+    std::vector<uint32_t> sum_;
+    uint32_t summed_;
+    uint64_t sums_emitted_;
+
+    /** Binned live view image, and the time in microseconds it was last emitted */
+    std::vector<uint32_t> live_;
+    uint64_t live_interval_;
+    uint64_t last_live_;
+    bool live_started_;
+  };
+
+}
+
+#endif //LATRD_LATRDIMAGEREDUCER_H
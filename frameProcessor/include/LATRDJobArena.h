@@ -0,0 +1,44 @@
+// The LATRDJobArena class provides the storage for a fixed pool of
+// processing jobs from a single contiguous block of memory.  Each job's
+// arrays occupy one cache line aligned region of the block, so creating
+// jobs makes no further allocations.  The block can optionally be backed
+// by huge pages (see LATRDMemoryBlock) and is faulted in when the arena is
+// created so that no page faults occur while processing.
+//
+// The arena must outlive every job created from it.
+//
+
+#ifndef LATRD_LATRDJOBARENA_H
+#define LATRD_LATRDJOBARENA_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#include "LATRDMemoryBlock.h"
+#include "LATRDProcessJob.h"
+
+namespace FrameProcessor {
+
+  class LATRDJobArena
+  {
+  public:
+    LATRDJobArena(size_t jobs, size_t job_size, bool huge_pages);
+    virtual ~LATRDJobArena();
+    size_t jobs();
+    size_t bytes();
+    bool huge_pages();
+    std::vector<boost::shared_ptr<LATRDProcessJob> > create_jobs();
+
+  private:
+    size_t jobs_;
+    size_t job_size_;
+    size_t job_stride_;
+    LATRDMemoryBlock block_;
+  };
+
+}
+
+#endif //LATRD_LATRDJOBARENA_H
@@ -0,0 +1,39 @@
+// The LATRDMemoryBlock class owns a single block of memory used for staging
+// data.  The block can optionally be backed by 2 MB huge pages to reduce
+// TLB misses.  Explicitly reserved huge pages (MAP_HUGETLB) are tried
+// first, then transparent huge pages are requested with madvise on a huge
+// page aligned block, and if neither is available normal pages are used.
+// Only a block of reserved huge pages reports huge_pages() as true.
+// The whole block is zeroed when it is created so that every page is
+// faulted in before processing starts.
+
+#ifndef LATRD_LATRDMEMORYBLOCK_H
+#define LATRD_LATRDMEMORYBLOCK_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+namespace FrameProcessor {
+
+  /** Size of the huge pages requested for memory blocks */
+  static const size_t huge_page_size = 2 * 1024 * 1024;
+
+  class LATRDMemoryBlock
+  {
+  public:
+    LATRDMemoryBlock(size_t bytes, bool huge_pages, size_t alignment);
+    virtual ~LATRDMemoryBlock();
+    void *data();
+    size_t bytes();
+    bool huge_pages();
+
+  private:
+    void *data_;
+    size_t bytes_;
+    bool mapped_;
+    bool huge_pages_;
+  };
+
+}
+
+#endif //LATRD_LATRDMEMORYBLOCK_H
@@ -0,0 +1,44 @@
+// The LATRDNumaTopology class describes the NUMA nodes of the host and the
+// CPUs that belong to each of them, read from sysfs.  It can pin the
+// calling thread to the CPUs of a node, and report the node that holds the
+// page containing an address.  The kernel interfaces are used directly so
+// no NUMA library is required.  A host without NUMA information is treated
+// as a single node holding every CPU.
+
+#ifndef LATRD_LATRDNUMATOPOLOGY_H
+#define LATRD_LATRDNUMATOPOLOGY_H
+
+#include <sched.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace FrameProcessor {
+
+  /** Location of the NUMA node descriptions in sysfs */
+  static const std::string numa_sysfs_root = "/sys/devices/system/node";
+
+  class LATRDNumaTopology
+  {
+  public:
+    LATRDNumaTopology();
+    LATRDNumaTopology(const std::string& sysfs_root);
+    virtual ~LATRDNumaTopology();
+    size_t nodes();
+    std::vector<int> cpus(size_t node);
+    bool bind_thread(size_t node, cpu_set_t *previous);
+    void restore_thread(const cpu_set_t *previous);
+    int node_of(const void *ptr);
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+  private:
+    void load(const std::string& sysfs_root);
+
+    /** CPUs of each node, an empty list for a node that places no restriction */
+    std::vector<std::vector<int> > cpus_;
+  };
+
+}
+
+#endif //LATRD_LATRDNUMATOPOLOGY_H
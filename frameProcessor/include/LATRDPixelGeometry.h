@@ -0,0 +1,95 @@
+// The LATRDPixelGeometry class maps the raw position IDs produced by the
+// detector onto pixels of the assembled sensor image.  A module layout is
+// described as a list of chips, each occupying a rectangle of raw chip
+// coordinates that is placed (and optionally rotated) at a position within
+// the image.  Pixels not covered by any chip, such as the gaps between
+// chips, are unmapped.
+//
+// Layout files are text files with one chip per line:
+//   raw_x raw_y width height x y rotation
+// where rotation is one of 0, 90, 180 or 270 degrees clockwise.  Lines
+// starting with # are ignored.
+//
+// Events can also be given the position ID of their image pixel, so that
+// code working from position IDs uses image coordinates once a geometry is
+// applied.  The image must then fit within the range of the position IDs.
+//
+// The layout is reduced to a flat lookup table when it is built so that
+// mapping an event costs a single gather.  A geometry is not modified once
+// it has been built, a new geometry is created whenever the layout changes.
+//
+
+#ifndef LATRD_LATRDPIXELGEOMETRY_H
+#define LATRD_LATRDPIXELGEOMETRY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  /** Form of the mapped pixel written to the output datasets */
+  enum LATRDGeometryOutput {NO_GEOMETRY, GEOMETRY_INDEX, GEOMETRY_XY};
+
+  /** Index of a position ID that does not map onto the image */
+  static const uint32_t unmapped_pixel_index = 0xFFFFFFFF;
+  /** Coordinate of a position ID that does not map onto the image */
+  static const uint16_t unmapped_pixel_coordinate = 0xFFFF;
+  /** Image position ID of a position ID that does not map onto the image */
+  static const uint32_t unmapped_position_id = 0xFFFFFFFF;
+
+  class LATRDPixelGeometry
+  {
+  public:
+    LATRDPixelGeometry(uint32_t width, uint32_t height, LATRDGeometryOutput output);
+    virtual ~LATRDPixelGeometry();
+    void add_chip(uint32_t raw_x,
+                  uint32_t raw_y,
+                  uint32_t chip_width,
+                  uint32_t chip_height,
+                  uint32_t x,
+                  uint32_t y,
+                  uint32_t rotation);
+    void load_layout(const std::string& filename);
+    void build();
+    LATRDGeometryOutput output();
+    uint32_t map_index(uint32_t position_id);
+    void map_indexes(const uint32_t *position_id, uint32_t *index, uint16_t qty_events);
+    void map_coordinates(const uint32_t *position_id, uint16_t *x, uint16_t *y, uint16_t qty_events);
+    void map_positions(const uint32_t *position_id, uint32_t *image_id, uint16_t qty_events);
+
+  private:
+    struct Chip
+    {
+      uint32_t raw_x;
+      uint32_t raw_y;
+      uint32_t width;
+      uint32_t height;
+      uint32_t x;
+      uint32_t y;
+      uint32_t rotation;
+    };
+
+    uint32_t lookup(uint32_t position_id);
+
+    uint32_t width_;
+    uint32_t height_;
+    LATRDGeometryOutput output_;
+    std::vector<Chip> chips_;
+    /** Extent of the raw chip coordinates covered by the lookup tables */
+    uint32_t raw_width_;
+    uint32_t raw_height_;
+    /** Image index of each raw pixel, stored column by column to match the position ID */
+    std::vector<uint32_t> index_table_;
+    /** Image coordinates of each raw pixel, x in the upper and y in the lower 16 bits */
+    std::vector<uint32_t> xy_table_;
+    /** Image position ID of each raw pixel */
+    std::vector<uint32_t> id_table_;
+  };
+
+}
+
+#endif //LATRD_LATRDPIXELGEOMETRY_H
@@ -25,10 +25,23 @@ using namespace log4cxx::helpers;
 #include "MetaMessagePublisher.h"
 #include "WorkQueue.h"
 #include "LATRDBuffer.h"
+#include "LATRDClusterer.h"
+#include "LATRDCompressor.h"
 #include "LATRDDefinitions.h"
+#include "LATRDEnergyCalibration.h"
+#include "LATRDEventCodec.h"
+#include "LATRDEventFilter.h"
+#include "LATRDFrameCounter.h"
+#include "LATRDHistogram.h"
+#include "LATRDJobArena.h"
+#include "LATRDImageBinner.h"
+#include "LATRDNumaTopology.h"
+#include "LATRDPixelGeometry.h"
 #include "LATRDProcessJob.h"
+#include "LATRDRoiIntegrator.h"
+#include "LATRDTaskPool.h"
 #include "LATRDTimeSliceWrap.h"
-#include "LATRDTimestampManager.h"
+#include "LATRDTimestampTracker.h"
 
 namespace FrameProcessor {
 
@@ -48,14 +61,57 @@ namespace FrameProcessor {
 
     void reset_statistics();
 
+    void get_filter_statistics(uint64_t *energy_rejects, uint64_t *roi_rejects, uint64_t *mask_rejects);
+
+    void configure_filter(boost::shared_ptr<LATRDEventFilter> filter);
+    void configure_geometry(boost::shared_ptr<LATRDPixelGeometry> geometry);
+    void configure_calibration(boost::shared_ptr<LATRDEnergyCalibration> calibration);
+    void configure_rois(boost::shared_ptr<LATRDRoiIntegrator> rois);
+
+    void configure_job_pool(size_t jobs);
+    void configure_huge_pages(bool huge_pages);
+    void configure_numa(bool enable);
+    boost::shared_ptr<LATRDTaskPool> get_task_pool();
+    void get_numa_statistics(uint32_t *groups, uint64_t *local_jobs, uint64_t *remote_jobs);
+    void get_job_pool_statistics(uint32_t *size, uint32_t *free_jobs, uint64_t *exhausted, uint64_t *forced_releases,
+                                 uint64_t *dropped_packets);
     void configure_process(size_t processes, size_t rank);
 
+    void configure_frame_counter(const std::string& name);
+
+    boost::shared_ptr<LATRDFrameCounter> get_frame_counter();
+
+    void reset_frame_counter();
+
+    void release_frame_counter();
+
+    void configure_histograms(bool enable, bool modules, uint32_t cadence);
+
+    void configure_image_binning(bool enable, uint32_t width, uint32_t height, uint64_t bin_width);
+
+    uint64_t get_image_late_events();
+    void configure_clustering(bool enable, uint64_t window);
+    uint64_t get_cluster_count();
+    uint64_t get_timestamp_delta_mismatches();
+    uint64_t get_compression_failures();
+
+    void configure_compression(LATRDCompressionType type, bool delta);
+
+    void configure_event_format(LATRDEventFormat format);
+
     std::vector<boost::shared_ptr<Frame> > process_frame(boost::shared_ptr<Frame> frame);
 
     std::vector<boost::shared_ptr<Frame> > add_jobs_to_buffer(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs);
 
     std::vector<boost::shared_ptr<Frame> > purge_remaining_buffers();
 
+    void add_output_frame(std::vector<boost::shared_ptr<Frame> >& frames,
+                          boost::shared_ptr<Frame> frame,
+                          const std::string& name,
+                          int data_type);
+
+    std::vector<boost::shared_ptr<Frame> > compress_frames(std::vector<boost::shared_ptr<Frame> > frames);
+
     void frame_to_jobs(boost::shared_ptr<Frame> frame);
 
     std::vector<boost::shared_ptr<LATRDProcessJob> > check_for_data_to_write();
@@ -66,20 +122,47 @@ namespace FrameProcessor {
 
     void publish_time_slice_meta_data(const std::string& acq_id, uint32_t qty_of_ts);
 
+    void collect_histograms(bool publish);
+
+    std::vector<boost::shared_ptr<Frame> > bin_images(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs, bool purge);
+
+    void publish_image_bin_meta_data(uint64_t frame_number, uint64_t bin_start, uint64_t bin_width);
+    void publish_roi_bin_meta_data(boost::shared_ptr<LATRDRoiIntegrator> rois,
+                                   boost::shared_ptr<Frame> frame,
+                                   uint64_t bin_start);
+    std::vector<boost::shared_ptr<Frame> > cluster_events(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs, bool purge);
+
+    void publish_histogram_meta_data();
+
+    void update_time_range(boost::shared_ptr<Frame> frame,
+                           boost::shared_ptr<LATRDProcessJob> job,
+                           size_t events_before_spill);
+
+    void publish_time_range_meta_data(uint64_t frame_number, uint64_t ts_min, uint64_t ts_max);
+
     std::vector<boost::shared_ptr<LATRDProcessJob> > purge_remaining_jobs();
 
-    void processTask();
+    void processTask(size_t thread_index);
+
+    boost::shared_ptr<LATRDProcessJob> getJob(size_t group, uint32_t ts_wrap);
+
+    size_t free_jobs();
 
-    boost::shared_ptr<LATRDProcessJob> getJob();
+    void start_workers();
+
+    void stop_workers();
 
     void releaseJob(boost::shared_ptr<LATRDProcessJob> job);
 
+    void release_wraps_before(uint32_t ts_wrap);
+
     bool processDataWord(uint64_t data_word,
                          uint64_t *previous_course_timestamp,
                          uint64_t *current_course_timestamp,
                          uint32_t packet_number,
                          uint32_t time_slice_wrap,
                          uint32_t time_slice_buffer,
+                         uint8_t producer_id,
                          uint64_t *event_ts,
                          uint32_t *event_id,
                          uint32_t *event_energy);
@@ -103,16 +186,45 @@ namespace FrameProcessor {
 
     /** Rank of this process coordinator */
     size_t rank_;
+    size_t processes_;
 
     /** Pointer to worker queue thread */
     boost::thread *thread_[LATRD::number_of_processing_threads];
 
-    /** Pointers to job queues for processing packets and results notification */
-    boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > > jobQueue_;
+    /** Pointers to job queues for processing packets, one for each worker group, and results notification */
+    std::vector<boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > > > jobQueues_;
     boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > > resultsQueue_;
 
-    /** Stack of processing job objects **/
-    std::stack<boost::shared_ptr<LATRDProcessJob> > jobStack_;
+    /** Pool of threads for work carried out on whole output frames */
+    boost::shared_ptr<LATRDTaskPool> taskPool_;
+
+    /** Compression applied to output frames */
+    LATRDCompressionType compression_;
+    bool compression_delta_;
+
+    /** Format of the event output datasets */
+    LATRDEventFormat event_format_;
+
+    /** Stacks of processing job objects, one for each worker group **/
+    std::vector<std::stack<boost::shared_ptr<LATRDProcessJob> > > jobStacks_;
+
+    /** Storage for the bounded pool of jobs, the number of times it has run dry and the packets dropped as a result */
+    std::vector<boost::shared_ptr<LATRDJobArena> > arenas_;
+    size_t job_pool_size_;
+    uint64_t pool_exhausted_;
+    uint64_t forced_releases_;
+    uint64_t pool_dropped_packets_;
+
+    /** Back the job pool and output buffers with huge pages when available */
+    bool huge_pages_;
+
+    /** NUMA placement, worker groups are pinned to a node and use jobs allocated on it */
+    LATRDNumaTopology numa_;
+    bool numa_enabled_;
+    size_t numa_groups_;
+    uint64_t numa_local_jobs_;
+    uint64_t numa_remote_jobs_;
+    std::vector<boost::shared_ptr<Frame> > forced_frames_;
 
     /** Current time slice wrap number */
     uint32_t current_ts_wrap_;
@@ -123,15 +235,26 @@ namespace FrameProcessor {
     /** Map to store active time slice buffers */
     std::map<uint32_t, boost::shared_ptr<LATRDTimeSliceWrap> > ts_store_;
 
-    /** Object to record extended timestamps and caculate the deltas */
-    LATRDTimestampManager ts_manager_;
+    /** Object to record the extended timestamp deltas of each producer */
+    LATRDTimestampTracker ts_tracker_;
 
       /** Pointer to LATRD buffer and frame manager */
     boost::shared_ptr<LATRDBuffer> timeStampBuffer_;
     boost::shared_ptr<LATRDBuffer> idBuffer_;
     boost::shared_ptr<LATRDBuffer> energyBuffer_;
+    boost::shared_ptr<LATRDBuffer> xBuffer_;
+    boost::shared_ptr<LATRDBuffer> yBuffer_;
     boost::shared_ptr<LATRDBuffer> ctrlWordBuffer_;
     boost::shared_ptr<LATRDBuffer> ctrlTimeStampBuffer_;
+    boost::shared_ptr<LATRDBuffer> packedBuffer_;
+    boost::shared_ptr<LATRDBuffer> varintBuffer_;
+    boost::shared_ptr<LATRDBuffer> cueIndexBuffer_;
+    boost::shared_ptr<LATRDBuffer> cueOffsetBuffer_;
+    boost::shared_ptr<LATRDBuffer> clusterTimeBuffer_;
+    boost::shared_ptr<LATRDBuffer> clusterXBuffer_;
+    boost::shared_ptr<LATRDBuffer> clusterYBuffer_;
+    boost::shared_ptr<LATRDBuffer> clusterEnergyBuffer_;
+    boost::shared_ptr<LATRDBuffer> clusterSizeBuffer_;
     uint64_t headerWord1;
     uint64_t headerWord2;
 
@@ -139,6 +262,36 @@ namespace FrameProcessor {
     uint32_t last_written_ts_index_;
     std::vector<uint32_t> ts_index_array_;
 
+    /** Range of timestamps appended to the current event frame */
+    uint64_t frame_ts_min_;
+    uint64_t frame_ts_max_;
+
+    /** Shared counter for global frame numbers, null when numbered by rank */
+    boost::shared_ptr<LATRDFrameCounter> frameCounter_;
+
+    /** Online histograms, one exchange for each worker thread and the merged total */
+    std::vector<boost::shared_ptr<LATRDHistogramExchange> > histograms_;
+    LATRDHistogramSet histogram_total_;
+    volatile bool histograms_enabled_;
+    volatile bool histogram_modules_;
+    uint32_t histogram_cadence_;
+    uint32_t histogram_collections_;
+
+    /** Time binned image builder, null when images are not required */
+    boost::shared_ptr<LATRDImageBinner> binner_;
+    /** Also guards the regions of interest, which are replaced by configuration while images are binned */
+    boost::mutex binner_mutex_;
+    /** Regions of interest integrated over each binned image */
+    boost::shared_ptr<LATRDRoiIntegrator> rois_;
+
+    /** Event clustering stage, null when clusters are not required */
+    boost::shared_ptr<LATRDClusterer> clusterer_;
+    boost::mutex clusterer_mutex_;
+    uint64_t clusters_;
+
+    /** Event frame numbers written since the time slice meta data was last published */
+    std::vector<uint64_t> frame_numbers_;
+
     /** Meta data publisher */
     MetaMessagePublisher *metaPtr_;
 
@@ -146,6 +299,25 @@ namespace FrameProcessor {
     uint32_t processed_jobs_;
     uint32_t processed_frames_;
     uint32_t output_frames_;
+    uint64_t energy_rejects_;
+    uint64_t roi_rejects_;
+    uint64_t mask_rejects_;
+    /** Output frames dropped because they could not be compressed */
+    uint64_t compression_failures_;
+
+    /** Event filter applied by the worker threads, null when no filtering is required */
+    boost::shared_ptr<LATRDEventFilter> filter_;
+    boost::mutex filter_mutex_;
+
+    /** Pixel geometry applied by the worker threads, null when raw position IDs are written */
+    boost::shared_ptr<LATRDPixelGeometry> geometry_;
+    boost::mutex geometry_mutex_;
+
+    /** Energy calibration applied by the worker threads, null when raw energies are written */
+    boost::shared_ptr<LATRDEnergyCalibration> calibration_;
+    boost::mutex calibration_mutex_;
+    /** Data type of the energy dataset, set with the calibration */
+    int energy_data_type_;
 
   };
 
@@ -14,6 +14,7 @@ using namespace log4cxx;
 using namespace log4cxx::helpers;
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -21,7 +22,13 @@ using namespace log4cxx::helpers;
 #include <map>
 
 #include "Frame.h"
+#include "MetaMessagePublisher.h"
 #include "LATRDImageJob.h"
+#include "LATRDImageReducer.h"
+#include "LATRDFlatField.h"
+#include "LATRDRoiIntegrator.h"
+#include "LATRDMemoryBlock.h"
+#include "LATRDTaskPool.h"
 
 namespace FrameProcessor {
 
@@ -36,12 +43,38 @@ namespace FrameProcessor {
   static const uint64_t integral_final_packet_mask    = 0xF000FFFF00000000;
   static const uint64_t integral_final_packet_value   = 0xC00071B000000000;
 
+  /** Number of images that can be in flight, a power of two so slots stay fixed when image numbers wrap */
+  static const size_t integral_image_slots            = 32;
+  /** Image numbers are 24 bits, numbers more than half the range behind the oldest image are late */
+  static const uint32_t integral_image_number_mask    = 0x00FFFFFF;
+  static const uint32_t integral_image_number_late    = 0x00800000;
+  /** Images within the pool start on cache line boundaries */
+  static const size_t integral_image_alignment        = 64;
+
+  /** A received packet waiting for its data words to be added to an image */
+  struct LATRDIntegralPacket
+  {
+    const uint64_t *data_ptr;
+    uint16_t data_words;
+    uint16_t slot;
+    uint32_t packet_id;
+    bool eoi;
+  };
+
+  /** A decoded event count and the ring slot and pixel it is added to */
+  struct LATRDIntegralCount
+  {
+    uint32_t pixel;
+    uint16_t slot;
+    uint16_t count;
+  };
+
   class LATRDProcessIntegral
   {
   public:
     LATRDProcessIntegral();
     virtual ~LATRDProcessIntegral();
-    void init(uint32_t width, uint32_t height);
+    void init(uint32_t width, uint32_t height, uint32_t depth, bool huge_pages);
     void reset_image();
     std::vector<boost::shared_ptr<Frame> > process_frame(boost::shared_ptr<Frame> frame);
     std::vector<boost::shared_ptr<Frame> > frame_to_image(boost::shared_ptr <Frame> frame);
@@ -54,20 +87,97 @@ namespace FrameProcessor {
     uint64_t get_course_timestamp(uint64_t data_word);
     bool check_for_final_packet_word(uint64_t data_word);
     bool check_for_integral_data_word(uint64_t data_word);
+    void get_statistics(uint64_t *late_packets, uint64_t *forced_images, uint64_t *dropped_words);
+    void set_task_pool(boost::shared_ptr<LATRDTaskPool> pool);
+    void configure_output(bool full, uint32_t sum_images, uint32_t bin, uint32_t live_rate);
+    void configure_flat_field(boost::shared_ptr<LATRDFlatField> flat_field);
+    void register_meta_message_publisher(MetaMessagePublisher *ptr);
+    void configure_rois(boost::shared_ptr<LATRDRoiIntegrator> rois);
+    void decode_packets(size_t partition, size_t begin, size_t end);
+    void accumulate_band(size_t band);
 
   private:
+    boost::shared_ptr<LATRDImageJob> image_slot(uint32_t image_number, std::vector<boost::shared_ptr<Frame> >& frames);
+    void send_image(boost::shared_ptr<LATRDImageJob> image, std::vector<boost::shared_ptr<Frame> >& frames);
+    void release_oldest_image();
+    void release_images(std::vector<boost::shared_ptr<Frame> >& frames);
+    bool image_forces_send(uint32_t image_number);
+    void accumulate_pending();
+    void assign_bands();
+    void publish_roi_meta_data(boost::shared_ptr<LATRDRoiIntegrator> rois, boost::shared_ptr<LATRDImageJob> image);
+    template <typename T> void accumulate_counts(size_t band);
+
     /** Pointer to logger */
     LoggerPtr logger_;
 
     uint32_t width_;
     uint32_t height_;
-    uint32_t base_image_counter_;
+    /** Bits per pixel of the count images */
+    uint32_t depth_;
     uint32_t total_count_;
     uint32_t next_frame_id_;
     uint32_t next_packet_id_;
-    uint16_t *image_ptr_;
+    bool huge_pages_;
     std::map<uint32_t, boost::shared_ptr<Frame> > frame_store_;
-    std::map<uint64_t, boost::shared_ptr<LATRDImageJob> > image_store_;
+    /** Ring of in-flight images indexed by image number, from the oldest image up to the newest */
+    std::vector<boost::shared_ptr<LATRDImageJob> > image_ring_;
+    /** Preallocated memory shared by the images of the ring, one image after another */
+    boost::shared_ptr<LATRDMemoryBlock> image_pool_;
+    std::vector<bool> slot_active_;
+    bool ring_started_;
+    uint32_t oldest_image_;
+    uint32_t end_image_;
+    uint64_t late_packets_;
+    uint64_t forced_images_;
+    /** Data words with a position outside the sensor */
+    uint64_t dropped_words_;
+
+    /** Output of full resolution images, and the summed, binned and live images made from them */
+    bool output_full_;
+    uint32_t output_sum_;
+    uint32_t output_bin_;
+    uint32_t output_live_rate_;
+    boost::shared_ptr<LATRDImageReducer> reducer_;
+    /** Guards the output stages, which are replaced by configuration while images are being sent */
+    boost::mutex outputs_mutex_;
+    /** Flat field and dead pixel correction, written to the image_corrected dataset */
+    boost::shared_ptr<LATRDFlatField> flat_field_;
+    /** Regions of interest integrated as each image completes, published with the image number */
+    MetaMessagePublisher *metaPtr_;
+    boost::shared_ptr<LATRDRoiIntegrator> rois_;
+
+    /** Pool shared with the coordinator, count mode frames are decoded by its workers */
+    boost::shared_ptr<LATRDTaskPool> task_pool_;
+    /** Packets placed into images but not yet decoded */
+    std::vector<LATRDIntegralPacket> pending_;
+    /** Decoded counts for each partition of the packets, split into bands of rows */
+    std::vector<std::vector<std::vector<LATRDIntegralCount> > > counts_;
+    std::vector<uint64_t> partition_totals_;
+    std::vector<uint64_t> partition_dropped_;
+    /** Band of each sensor row */
+    std::vector<uint16_t> row_band_;
+  };
+
+  class LATRDIntegralDecodeTask : public LATRDTask
+  {
+  public:
+    LATRDIntegralDecodeTask(LATRDProcessIntegral *integral, size_t partition, size_t begin, size_t end);
+    void execute();
+
+    LATRDProcessIntegral *integral;
+    size_t partition;
+    size_t begin;
+    size_t end;
+  };
+
+  class LATRDIntegralAccumulateTask : public LATRDTask
+  {
+  public:
+    LATRDIntegralAccumulateTask(LATRDProcessIntegral *integral, size_t band);
+    void execute();
+
+    LATRDProcessIntegral *integral;
+    size_t band;
   };
 
 
@@ -10,15 +10,27 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <boost/shared_ptr.hpp>
+
+#include "LATRDMemoryBlock.h"
 
 namespace FrameProcessor {
 
+/** Minimum timestamp of a job containing no events, any real timestamp is lower */
+static const uint64_t empty_ts_min = 0xFFFFFFFFFFFFFFFFULL;
+
+/** Alignment of each of the job arrays, so that no two arrays share a cache line */
+static const size_t job_array_alignment = 64;
+
 class LATRDProcessJob
 {
 public:
 	LATRDProcessJob(size_t size);
+	LATRDProcessJob(size_t size, uint8_t *storage);
 	virtual ~LATRDProcessJob();
 	void reset();
+	static size_t storage_size(size_t size);
+	uint32_t *pixel_ids();
 
 	uint32_t job_id;
 	uint32_t packet_number;
@@ -26,16 +38,41 @@ public:
 	uint32_t time_slice;
 	uint32_t time_slice_wrap;
 	uint32_t time_slice_buffer;
+	uint8_t producer_id;
+	uint8_t pool_group;
+	uint8_t geometry_output;
+	uint8_t energy_output;
+	/** Fractional bits of fixed point calibrated energies */
+	uint8_t energy_fraction_bits;
 	uint16_t valid_results;
 	uint16_t valid_control_words;
 	uint16_t timestamp_mismatches;
+	uint32_t energy_rejects;
+	uint32_t roi_rejects;
+	uint32_t mask_rejects;
+	uint32_t packed_size;
+	uint64_t ts_min;
+	uint64_t ts_max;
 	uint64_t *data_ptr;
 	uint64_t *event_ts_ptr;
 	uint32_t *event_id_ptr;
 	uint32_t *event_energy_ptr;
+	uint32_t *event_pixel_ptr;
+	/** Position IDs of the pixels within the sensor image once a geometry has been applied */
+	uint32_t *event_image_id_ptr;
+	uint16_t *event_x_ptr;
+	uint16_t *event_y_ptr;
 	uint64_t *ctrl_word_ts_ptr;
 	uint16_t *ctrl_word_id_ptr;
 	uint32_t *ctrl_index_ptr;
+	uint64_t *ctrl_event_index_ptr;
+	uint8_t *event_packed_ptr;
+
+private:
+	void assign_storage(size_t size, uint8_t *storage);
+
+	/** Region holding all of the job arrays, null when the region is owned by the caller */
+	boost::shared_ptr<LATRDMemoryBlock> block_;
 };
 
 } /* namespace FrameProcessor */
@@ -49,6 +49,25 @@ namespace FrameProcessor {
 
         void configureSensor(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
 
+        void configureCompression(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void configureHistograms(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void configureImageBins(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyImageBins();
+        void configureImageOutput(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void configureClustering(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void configureJobPool(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void configureHugePages(uint32_t huge_pages);
+        void configureFilter(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyFilter();
+        void configureGeometry(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyGeometry();
+        void configureCalibration(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyCalibration();
+        void configureFlatField(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyFlatField();
+        void configureRoi(OdinData::IpcMessage &config, OdinData::IpcMessage &reply);
+        void applyRoi();
+
         void createMetaHeader();
 
         bool reset_statistics(void);
@@ -74,13 +93,91 @@ namespace FrameProcessor {
         static const std::string CONFIG_SENSOR;
         static const std::string CONFIG_SENSOR_WIDTH;
         static const std::string CONFIG_SENSOR_HEIGHT;
+        static const std::string CONFIG_SENSOR_DEPTH;
+
+        /** Configuration constant for compression related items */
+        static const std::string CONFIG_COMPRESSION;
+        static const std::string CONFIG_COMPRESSION_TYPE;
+        static const std::string CONFIG_COMPRESSION_NONE;
+        static const std::string CONFIG_COMPRESSION_BSLZ4;
+        static const std::string CONFIG_COMPRESSION_DELTA;
+        /** Configuration constant for online histogram related items */
+        static const std::string CONFIG_HISTOGRAMS;
+        static const std::string CONFIG_HISTOGRAMS_ENABLE;
+        static const std::string CONFIG_HISTOGRAMS_MODULES;
+        static const std::string CONFIG_HISTOGRAMS_CADENCE;
+        /** Configuration constant for time binned image related items */
+        static const std::string CONFIG_IMAGE_BINS;
+        static const std::string CONFIG_IMAGE_BINS_ENABLE;
+        static const std::string CONFIG_IMAGE_BINS_WIDTH;
+        /** Configuration constant for count mode image output related items */
+        static const std::string CONFIG_IMAGE_OUTPUT;
+        static const std::string CONFIG_IMAGE_OUTPUT_FULL;
+        static const std::string CONFIG_IMAGE_OUTPUT_SUM;
+        static const std::string CONFIG_IMAGE_OUTPUT_BIN;
+        static const std::string CONFIG_IMAGE_OUTPUT_LIVE_RATE;
+        /** Configuration constant for event clustering related items */
+        static const std::string CONFIG_CLUSTERING;
+        static const std::string CONFIG_CLUSTERING_ENABLE;
+        static const std::string CONFIG_CLUSTERING_WINDOW;
+        /** Configuration constant for job pool related items */
+        static const std::string CONFIG_JOB_POOL;
+        static const std::string CONFIG_JOB_POOL_SIZE;
+        /** Configuration constant for event filter related items */
+        static const std::string CONFIG_FILTER;
+        static const std::string CONFIG_FILTER_ENERGY_MIN;
+        static const std::string CONFIG_FILTER_ENERGY_MAX;
+        static const std::string CONFIG_FILTER_ROI_X;
+        static const std::string CONFIG_FILTER_ROI_Y;
+        static const std::string CONFIG_FILTER_ROI_WIDTH;
+        static const std::string CONFIG_FILTER_ROI_HEIGHT;
+        static const std::string CONFIG_FILTER_ROI_FILE;
+        static const std::string CONFIG_FILTER_MASK_FILE;
+        /** Configuration constant for pixel geometry related items */
+        static const std::string CONFIG_GEOMETRY;
+        static const std::string CONFIG_GEOMETRY_FILE;
+        static const std::string CONFIG_GEOMETRY_OUTPUT;
+        static const std::string CONFIG_GEOMETRY_INDEX;
+        static const std::string CONFIG_GEOMETRY_XY;
+        /** Configuration constant for energy calibration related items */
+        static const std::string CONFIG_CALIBRATION;
+        static const std::string CONFIG_CALIBRATION_FILE;
+        static const std::string CONFIG_CALIBRATION_OUTPUT;
+        static const std::string CONFIG_CALIBRATION_FLOAT;
+        static const std::string CONFIG_CALIBRATION_FIXED;
+        static const std::string CONFIG_CALIBRATION_FRACTION_BITS;
+        /** Configuration constant for count mode flat field correction related items */
+        static const std::string CONFIG_FLAT_FIELD;
+        static const std::string CONFIG_FLAT_FIELD_GAIN_FILE;
+        static const std::string CONFIG_FLAT_FIELD_MASK_FILE;
+        static const std::string CONFIG_FLAT_FIELD_OUTPUT;
+        static const std::string CONFIG_FLAT_FIELD_FLOAT;
+        static const std::string CONFIG_FLAT_FIELD_FIXED;
+        static const std::string CONFIG_FLAT_FIELD_FRACTION_BITS;
+        /** Configuration constant for region of interest intensity related items */
+        static const std::string CONFIG_ROI;
+        static const std::string CONFIG_ROI_REGIONS;
+        /** Configuration constant for the event output format */
+        static const std::string CONFIG_EVENT_FORMAT;
+        static const std::string CONFIG_EVENT_FORMAT_COLUMNS;
+        static const std::string CONFIG_EVENT_FORMAT_PACKED;
+        static const std::string CONFIG_EVENT_FORMAT_VARINT;
 
       /** Configuration constant for setting raw mode */
         static const std::string CONFIG_RAW_MODE;
 
+        /** Configuration constant for backing buffers and jobs with huge pages */
+        static const std::string CONFIG_HUGE_PAGES;
+
+        /** Configuration constant for NUMA placement of worker threads and jobs */
+        static const std::string CONFIG_NUMA;
+
         /** Configuration constant for resetting the frame counter */
         static const std::string CONFIG_RESET_FRAME;
 
+        /** Configuration constant for the name of a shared frame counter */
+        static const std::string CONFIG_FRAME_COUNTER;
+
         /** Configuration constant for process related items */
         static const std::string CONFIG_PROCESS;
         /** Configuration constant for number of processes */
@@ -114,6 +211,9 @@ namespace FrameProcessor {
 
         /** Pointer to LATRD buffer and frame manager */
         boost::shared_ptr<LATRDBuffer> rawBuffer_;
+        /** Index of the position and header words of each packet within the forwarded raw frames */
+        boost::shared_ptr<LATRDBuffer> rawOffsetBuffer_;
+        boost::shared_ptr<LATRDBuffer> rawHeaderBuffer_;
 //        boost::shared_ptr<LATRDBuffer> timeStampBuffer_;
 //        boost::shared_ptr<LATRDBuffer> idBuffer_;
 //        boost::shared_ptr<LATRDBuffer> energyBuffer_;
@@ -122,11 +222,49 @@ namespace FrameProcessor {
 
         size_t sensor_width_;
         size_t sensor_height_;
+        uint32_t sensor_depth_;
 
         std::string mode_;
 
+        std::string compression_type_;
+        uint32_t compression_delta_;
+        std::string event_format_;
+        uint32_t histograms_enable_;
+        uint32_t histograms_modules_;
+        uint32_t histograms_cadence_;
+        uint32_t image_bins_enable_;
+        uint64_t image_bins_width_;
+        uint32_t image_output_full_;
+        uint32_t image_output_sum_;
+        uint32_t image_output_bin_;
+        uint32_t image_output_live_rate_;
+        uint32_t clustering_enable_;
+        uint64_t clustering_window_;
+        uint32_t job_pool_size_;
+        uint32_t huge_pages_;
+        uint32_t numa_;
+        uint32_t filter_energy_min_;
+        uint32_t filter_energy_max_;
+        uint32_t filter_roi_x_;
+        uint32_t filter_roi_y_;
+        uint32_t filter_roi_width_;
+        uint32_t filter_roi_height_;
+        std::string filter_roi_file_;
+        std::string filter_mask_file_;
+        std::string geometry_file_;
+        std::string geometry_output_;
+        std::string calibration_file_;
+        std::string calibration_output_;
+        uint32_t calibration_fraction_bits_;
+        std::string flat_field_gain_file_;
+        std::string flat_field_mask_file_;
+        std::string flat_field_output_;
+        uint32_t flat_field_fraction_bits_;
+        std::string roi_regions_;
+
         size_t concurrent_processes_;
         size_t concurrent_rank_;
+        std::string frame_counter_;
 
         /** Last processed information */
 //        uint32_t last_processed_ts_wrap_;
@@ -138,7 +276,7 @@ namespace FrameProcessor {
         uint64_t current_point_index_;
         uint32_t current_time_slice_;
 
-        /** Process raw mode **/
+        /** Process raw mode, 0 for processed output only, 1 for raw packets only and 2 for both **/
         uint32_t raw_mode_;
 
 //        boost::shared_ptr<LATRDProcessJob> getJob();
@@ -151,7 +289,7 @@ namespace FrameProcessor {
 
         void process_raw(boost::shared_ptr<Frame> frame);
 
-        void publishControlMetaData(boost::shared_ptr<LATRDProcessJob> job);
+        void push_raw_frame(boost::shared_ptr<Frame> frame, const std::string& name, int data_type);
 
     };
 
@@ -0,0 +1,55 @@
+// The LATRDRoiIntegrator class sums the counts of an image within a set of
+// rectangular regions of interest, giving a few scalars per image that can
+// be published at a high rate in place of the full image.
+//
+// Regions are described by a string of semicolon separated regions, each
+// region being the comma separated x, y, width and height of the rectangle
+// in pixels, for example "0,0,16,16;100,20,8,4".  Regions may overlap and
+// must lie within the sensor.  An integrator is not modified once it has
+// been configured, a new one is created whenever the regions change.
+//
+
+#ifndef LATRD_LATRDROIINTEGRATOR_H
+#define LATRD_LATRDROIINTEGRATOR_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  /** Rectangular region of interest in pixels */
+  struct LATRDRoi
+  {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+  };
+
+  class LATRDRoiIntegrator
+  {
+  public:
+    LATRDRoiIntegrator(uint32_t width, uint32_t height);
+    virtual ~LATRDRoiIntegrator();
+    void add_roi(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void add_regions(const std::string& regions);
+    size_t rois();
+    uint32_t width();
+    uint32_t height();
+    void integrate(const void *image, uint32_t depth, uint64_t *sums);
+
+  private:
+    template <typename T> void integrate_image(const T *image, uint64_t *sums);
+
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<LATRDRoi> rois_;
+  };
+
+}
+
+#endif //LATRD_LATRDROIINTEGRATOR_H
@@ -0,0 +1,58 @@
+// The LATRDTaskPool class maintains a set of worker threads that execute
+// independent tasks on behalf of the processing classes.  A batch of tasks
+// is submitted with run, which blocks until every task in the batch has
+// completed.
+
+#ifndef LATRD_LATRDTASKPOOL_H
+#define LATRD_LATRDTASKPOOL_H
+
+#include <log4cxx/logger.h>
+#include <log4cxx/basicconfigurator.h>
+#include <log4cxx/propertyconfigurator.h>
+#include <log4cxx/helpers/exception.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#include "WorkQueue.h"
+
+namespace FrameProcessor {
+
+  class LATRDTask
+  {
+  public:
+    virtual ~LATRDTask() {};
+    virtual void execute() = 0;
+  };
+
+  class LATRDTaskPool
+  {
+  public:
+    LATRDTaskPool(size_t threads);
+    virtual ~LATRDTaskPool();
+    size_t size();
+    void run(std::vector<boost::shared_ptr<LATRDTask> > tasks);
+    void workerTask();
+
+  private:
+    /** Pointer to logger */
+    LoggerPtr logger_;
+
+    /** Worker threads */
+    std::vector<boost::thread *> threads_;
+
+    /** Queues for outstanding and completed tasks */
+    boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDTask> > > taskQueue_;
+    boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDTask> > > doneQueue_;
+  };
+
+}
+
+#endif //LATRD_LATRDTASKPOOL_H
@@ -0,0 +1,49 @@
+// The LATRDTimestampTracker class records the interval between consecutive
+// extended timestamps for each data producer, so that the worker threads
+// can recover the course timestamp that preceded the first extended
+// timestamp of a packet.
+//
+// The interval is learnt from any packet holding two or more extended
+// timestamps.  Workers read and update the tracker concurrently without
+// locking, each producer slot is a single word updated with atomic
+// operations.  Intervals that disagree with the recorded value are counted,
+// and once enough of them agree in a row they replace it, so a wrong first
+// interval (for example after a lost extended timestamp) does not persist
+// until the next reset.  Until an interval is known for a producer the
+// course timestamp rollover is assumed.
+//
+
+#ifndef LATRD_LATRDTIMESTAMPTRACKER_H
+#define LATRD_LATRDTIMESTAMPTRACKER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+namespace FrameProcessor {
+
+  /** Number of producers that can be tracked, one for each possible producer ID */
+  static const size_t timestamp_tracker_producers = 256;
+  /** Number of consecutive agreeing intervals that replace a recorded delta */
+  static const uint64_t timestamp_tracker_run_length = 4;
+
+  class LATRDTimestampTracker
+  {
+  public:
+    LATRDTimestampTracker();
+    virtual ~LATRDTimestampTracker();
+    void reset();
+    void record(uint8_t producer_id, uint64_t previous_timestamp, uint64_t current_timestamp);
+    uint64_t delta(uint8_t producer_id);
+    uint64_t previous(uint8_t producer_id, uint64_t current_timestamp);
+    uint64_t mismatches();
+
+  private:
+    volatile uint64_t delta_[timestamp_tracker_producers];
+    /** Interval of the current run of disagreeing intervals in the upper bits, run length in the lowest byte */
+    volatile uint64_t run_[timestamp_tracker_producers];
+    volatile uint64_t mismatches_;
+  };
+
+}
+
+#endif //LATRD_LATRDTIMESTAMPTRACKER_H
@@ -16,7 +16,11 @@ LATRDBuffer::LATRDBuffer(size_t numberOfDataPoints, const std::string& frame, LA
 		type_(type),
 		frameNumber_(0),
 		concurrent_processes_(1),
-		concurrent_rank_(0)
+		concurrent_rank_(0),
+		frameStarted_(false),
+		used_(false),
+		currentFrameNumber_(0),
+		counterSlot_(EVENT_FRAME_SLOT)
 {
     // Setup logging for the class
     logger_ = Logger::getLogger("FP.LATRDBuffer");
@@ -40,20 +44,19 @@ LATRDBuffer::LATRDBuffer(size_t numberOfDataPoints, const std::string& frame, LA
 		bytes_to_allocate = bytes_to_allocate * sizeof(uint16_t);
 		dataSize_ = sizeof(uint16_t);
 		break;
+	case UINT8_TYPE:
+		bytes_to_allocate = bytes_to_allocate * sizeof(uint8_t);
+		dataSize_ = sizeof(uint8_t);
+		break;
     default:
     	throw LATRDProcessingException("Unknown datatype specified");
     }
     LOG4CXX_DEBUG(logger_, "Total bytes to allocate [" << bytes_to_allocate << "]");
-	rawDataPtr_ = malloc(bytes_to_allocate);
-    LOG4CXX_DEBUG(logger_, "Allocated memory block with base address [" << std::hex << rawDataPtr_ << "]");
+	allocate(false);
 }
 
 LATRDBuffer::~LATRDBuffer()
 {
-	// Free the allocated memory block
-	if (rawDataPtr_){
-		free(rawDataPtr_);
-	}
 }
 
 boost::shared_ptr<Frame> LATRDBuffer::appendData(void *data_ptr, size_t qty_pts)
@@ -66,6 +69,10 @@ boost::shared_ptr<Frame> LATRDBuffer::appendData(void *data_ptr, size_t qty_pts)
 	char *char_data_ptr = (char *)rawDataPtr_;
 
     LOG4CXX_DEBUG(logger_, "Quantity of points to append [" << qty_pts << "]");
+	if (qty_pts > 0){
+		startFrame();
+		used_ = true;
+	}
     char_data_ptr += (currentPoint_ * dataSize_);
 	if (qty_pts < (numberOfPoints_ - currentPoint_)){
 		// The whole block can be added without filling a buffer
@@ -78,16 +85,7 @@ boost::shared_ptr<Frame> LATRDBuffer::appendData(void *data_ptr, size_t qty_pts)
 		memcpy(char_data_ptr, data_ptr, qty_to_fill * dataSize_);
 
 		// The buffer should now be full so create the frame and copy the buffer in
-	    LOG4CXX_DEBUG(logger_, "Creating a new frame for [" << frameName_ << "]");
-		frame = boost::shared_ptr<Frame>(new Frame(frameName_));
-	    LOG4CXX_DEBUG(logger_, "Copying data [" << numberOfPoints_ << " points] into " << frameName_);
-		frame->copy_data(rawDataPtr_, numberOfPoints_ * dataSize_);
-		frame->set_frame_number(concurrent_rank_ + (frameNumber_ * concurrent_processes_));
-		frameNumber_++;
-
-		// Reset the buffer
-		memset(rawDataPtr_, 0, numberOfPoints_ * dataSize_);
-		currentPoint_ = 0;
+		frame = fullFrame();
 
 		// Calculate the remaining points left to fill
 		qty_pts -= qty_to_fill;
@@ -95,41 +93,153 @@ boost::shared_ptr<Frame> LATRDBuffer::appendData(void *data_ptr, size_t qty_pts)
 		char_data_ptr = (char *)data_ptr;
 		char_data_ptr += (qty_to_fill * dataSize_);
 		// Fill from the beginning of the buffer with the remaining points
+		if (qty_pts > 0){
+			startFrame();
+		}
 		memcpy(rawDataPtr_, char_data_ptr, qty_pts * dataSize_);
 		currentPoint_ += qty_pts;
 	}
 	return frame;
 }
 
+boost::shared_ptr<Frame> LATRDBuffer::forwardFrame(boost::shared_ptr<Frame> frame)
+{
+	// The frame takes the place of a complete block, so nothing may be held in the buffer
+	if (currentPoint_ > 0){
+		throw LATRDProcessingException("A frame cannot be forwarded while the buffer holds data");
+	}
+	if (frame->get_data_size() != numberOfPoints_ * dataSize_){
+		throw LATRDProcessingException("A forwarded frame must hold a complete block of points");
+	}
+	startFrame();
+	used_ = true;
+	frame->set_frame_number(currentFrameNumber_);
+	frameNumber_++;
+	frameStarted_ = false;
+	return frame;
+}
+
 boost::shared_ptr<Frame> LATRDBuffer::retrieveCurrentFrame()
 {
   boost::shared_ptr<Frame> frame;
-	if (currentPoint_ > 0) {
+	// A frame number claimed from a shared counter must be used even if there are no points
+	if (currentPoint_ > 0 || claimed()) {
+		startFrame();
 		// The buffer should now be full so create the frame and copy the buffer in
 		LOG4CXX_DEBUG(logger_, "Creating a new frame for [" << frameName_ << "]");
 		frame = boost::shared_ptr<Frame>(new Frame(frameName_));
 		LOG4CXX_DEBUG(logger_, "Copying data [" << currentPoint_ << " points] into " << frameName_);
+		// Frames are always written full size, so clear the unused tail of the buffer
+		memset((char *)rawDataPtr_ + (currentPoint_ * dataSize_), 0, (numberOfPoints_ - currentPoint_) * dataSize_);
 		frame->copy_data(rawDataPtr_, numberOfPoints_ * dataSize_);
-		frame->set_frame_number(concurrent_rank_ + (frameNumber_ * concurrent_processes_));
+		frame->set_frame_number(currentFrameNumber_);
 		frameNumber_++;
-    // Reset the buffer
-    memset(rawDataPtr_, 0, numberOfPoints_ * dataSize_);
-    currentPoint_ = 0;
+		currentPoint_ = 0;
 	} else {
 		LOG4CXX_DEBUG(logger_, "No frame created from Idle buffer as there were no data points");
 	}
+	frameStarted_ = false;
 	return frame;
 }
 
+size_t LATRDBuffer::remaining()
+{
+	// Number of points that can be appended before a frame is produced
+	return numberOfPoints_ - currentPoint_;
+}
+
+uint64_t LATRDBuffer::position()
+{
+	// Index within the complete dataset of the next point to be appended.  Frames are
+	// always written full size, so this accounts for frames from concurrent processes
+	return (currentFrameNumber() * numberOfPoints_) + currentPoint_;
+}
+
+uint64_t LATRDBuffer::currentFrameNumber()
+{
+	startFrame();
+	return currentFrameNumber_;
+}
+
 void LATRDBuffer::configureProcess(size_t processes, size_t rank)
 {
 	concurrent_processes_ = processes;
 	concurrent_rank_ = rank;
 }
 
+void LATRDBuffer::setFrameCounter(boost::shared_ptr<LATRDFrameCounter> counter, LATRDFrameCounterSlot slot)
+{
+	frameCounter_ = counter;
+	counterSlot_ = slot;
+}
+
+void LATRDBuffer::followFrameNumbers(boost::shared_ptr<LATRDBuffer> leader)
+{
+	leader_ = leader;
+}
+
+void LATRDBuffer::allocate(bool huge_pages)
+{
+	// Points held in the current block would be lost, so only an empty buffer can be reallocated
+	if (currentPoint_ > 0){
+		throw LATRDProcessingException("Buffer cannot be reallocated while it holds data");
+	}
+	block_.reset();
+	rawDataPtr_ = 0;
+	block_ = boost::shared_ptr<LATRDMemoryBlock>(new LATRDMemoryBlock(numberOfPoints_ * dataSize_, huge_pages, sizeof(uint64_t)));
+	rawDataPtr_ = block_->data();
+	LOG4CXX_DEBUG(logger_, "Allocated memory block with base address [" << std::hex << rawDataPtr_ << "]"
+	                       << (block_->huge_pages() ? " of huge pages" : (huge_pages ? " with huge pages requested" : "")));
+}
+
+bool LATRDBuffer::hugePages()
+{
+	return block_->huge_pages();
+}
+
 void LATRDBuffer::resetFrameNumber()
 {
   frameNumber_ = 0;
+  frameStarted_ = false;
+  used_ = false;
+}
+
+void LATRDBuffer::startFrame()
+{
+	// The frame number is fixed when the first point of a frame arrives
+	if (!frameStarted_){
+		if (leader_){
+			currentFrameNumber_ = leader_->currentFrameNumber();
+		} else if (frameCounter_){
+			currentFrameNumber_ = frameCounter_->next(counterSlot_);
+		} else {
+			currentFrameNumber_ = concurrent_rank_ + (frameNumber_ * concurrent_processes_);
+		}
+		frameStarted_ = true;
+	}
+}
+
+boost::shared_ptr<Frame> LATRDBuffer::fullFrame()
+{
+	LOG4CXX_DEBUG(logger_, "Creating a new frame for [" << frameName_ << "]");
+	boost::shared_ptr<Frame> frame = boost::shared_ptr<Frame>(new Frame(frameName_));
+	LOG4CXX_DEBUG(logger_, "Copying data [" << numberOfPoints_ << " points] into " << frameName_);
+	frame->copy_data(rawDataPtr_, numberOfPoints_ * dataSize_);
+	frame->set_frame_number(currentFrameNumber_);
+	frameNumber_++;
+	frameStarted_ = false;
+
+	// Every point of the buffer has been overwritten so it is reused without clearing
+	currentPoint_ = 0;
+	return frame;
+}
+
+bool LATRDBuffer::claimed()
+{
+	if (leader_){
+		return used_ && leader_->claimed();
+	}
+	return frameStarted_ && frameCounter_;
 }
 
 } /* namespace FrameProcessor */
@@ -0,0 +1,351 @@
+#include <string.h>
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+
+#include "LATRDDefinitions.h"
+#include "LATRDEnergyCalibration.h"
+#include "LATRDPixelGeometry.h"
+#include "LATRDClusterer.h"
+
+namespace FrameProcessor {
+
+  /** Decoded event copied out of a job so that the events of a partition can be sorted by time */
+  struct LATRDClusterEvent
+  {
+    uint64_t ts;
+    uint32_t position_id;
+    float energy;
+  };
+
+  static bool event_before(const LATRDClusterEvent& a, const LATRDClusterEvent& b)
+  {
+    return a.ts < b.ts;
+  }
+
+  /** Cluster that may need stitching with a cluster from another partition */
+  struct LATRDStitchCandidate
+  {
+    LATRDCluster *cluster;
+    size_t group;
+  };
+
+  static bool candidate_before(const LATRDStitchCandidate& a, const LATRDStitchCandidate& b)
+  {
+    return a.cluster->first_ts < b.cluster->first_ts;
+  }
+
+  static bool cluster_before(const LATRDCluster& a, const LATRDCluster& b)
+  {
+    return a.first_ts < b.first_ts;
+  }
+
+  static size_t find_root(std::vector<size_t>& parent, size_t index)
+  {
+    // Path halving keeps the trees shallow without recursion
+    while (parent[index] != index){
+      parent[index] = parent[parent[index]];
+      index = parent[index];
+    }
+    return index;
+  }
+
+  static void join(std::vector<size_t>& parent, size_t a, size_t b)
+  {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a != b){
+      parent[std::max(a, b)] = std::min(a, b);
+    }
+  }
+
+  LATRDCluster::LATRDCluster() :
+      first_ts(0),
+      last_ts(0),
+      energy(0.0f),
+      sum_x(0.0),
+      sum_y(0.0),
+      sum_weight(0.0)
+  {
+  }
+
+  void LATRDCluster::add_event(uint64_t ts, uint32_t position_id, float event_energy)
+  {
+    if (pixels.empty() || ts < first_ts){
+      first_ts = ts;
+    }
+    if (pixels.empty() || ts > last_ts){
+      last_ts = ts;
+    }
+    energy += event_energy;
+    double weight = std::max(event_energy, 0.0f);
+    sum_x += weight * LATRD::get_position_x(position_id);
+    sum_y += weight * LATRD::get_position_y(position_id);
+    sum_weight += weight;
+    pixels.push_back(position_id);
+  }
+
+  void LATRDCluster::merge(const LATRDCluster& other)
+  {
+    if (other.pixels.empty()){
+      return;
+    }
+    if (pixels.empty() || other.first_ts < first_ts){
+      first_ts = other.first_ts;
+    }
+    if (pixels.empty() || other.last_ts > last_ts){
+      last_ts = other.last_ts;
+    }
+    energy += other.energy;
+    sum_x += other.sum_x;
+    sum_y += other.sum_y;
+    sum_weight += other.sum_weight;
+    pixels.insert(pixels.end(), other.pixels.begin(), other.pixels.end());
+  }
+
+  bool LATRDCluster::touches(const LATRDCluster& other, uint64_t window) const
+  {
+    if (first_ts > other.last_ts + window || other.first_ts > last_ts + window){
+      return false;
+    }
+    std::vector<uint32_t>::const_iterator a;
+    std::vector<uint32_t>::const_iterator b;
+    for (a = pixels.begin(); a != pixels.end(); ++a){
+      int32_t ax = LATRD::get_position_x(*a);
+      int32_t ay = LATRD::get_position_y(*a);
+      for (b = other.pixels.begin(); b != other.pixels.end(); ++b){
+        int32_t dx = ax - (int32_t)LATRD::get_position_x(*b);
+        int32_t dy = ay - (int32_t)LATRD::get_position_y(*b);
+        if (dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1){
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  float LATRDCluster::centroid_x() const
+  {
+    if (sum_weight > 0.0){
+      return (float)(sum_x / sum_weight);
+    }
+    // Without any energy the centroid is the mean pixel position
+    double sum = 0.0;
+    for (size_t index = 0; index < pixels.size(); index++){
+      sum += LATRD::get_position_x(pixels[index]);
+    }
+    return pixels.empty() ? 0.0f : (float)(sum / pixels.size());
+  }
+
+  float LATRDCluster::centroid_y() const
+  {
+    if (sum_weight > 0.0){
+      return (float)(sum_y / sum_weight);
+    }
+    double sum = 0.0;
+    for (size_t index = 0; index < pixels.size(); index++){
+      sum += LATRD::get_position_y(pixels[index]);
+    }
+    return pixels.empty() ? 0.0f : (float)(sum / pixels.size());
+  }
+
+  LATRDClusterer::LATRDClusterer(uint64_t window, size_t partitions) :
+      window_(window),
+      partials_(partitions),
+      partial_min_(partitions, empty_ts_min),
+      partial_max_(partitions, 0)
+  {
+  }
+
+  LATRDClusterer::~LATRDClusterer()
+  {
+  }
+
+  size_t LATRDClusterer::partitions()
+  {
+    return partials_.size();
+  }
+
+  uint64_t LATRDClusterer::window()
+  {
+    return window_;
+  }
+
+  void LATRDClusterer::cluster_events(size_t partition, const std::vector<boost::shared_ptr<LATRDProcessJob> >& jobs)
+  {
+    // Copy the events of the partition and put them into time order
+    std::vector<LATRDClusterEvent> events;
+    std::vector<boost::shared_ptr<LATRDProcessJob> >::const_iterator iter;
+    for (iter = jobs.begin(); iter != jobs.end(); ++iter){
+      LATRDProcessJob *job = iter->get();
+      const uint32_t *pixel_ids = job->pixel_ids();
+      for (uint16_t index = 0; index < job->valid_results; index++){
+        // Events that the geometry does not place on the image have no neighbours
+        if (pixel_ids[index] == unmapped_position_id){
+          continue;
+        }
+        LATRDClusterEvent event;
+        event.ts = job->event_ts_ptr[index];
+        event.position_id = pixel_ids[index];
+        if (job->energy_output == FLOAT_ENERGY){
+          memcpy(&event.energy, &job->event_energy_ptr[index], sizeof(float));
+        } else {
+          // Fixed point energies are scaled back to keV, raw energies have no fractional bits
+          event.energy = (float)job->event_energy_ptr[index] / (float)(1 << job->energy_fraction_bits);
+        }
+        events.push_back(event);
+      }
+    }
+    std::sort(events.begin(), events.end(), event_before);
+
+    // Join each event to the most recent events on the same and neighbouring pixels within the window
+    std::vector<size_t> parent(events.size());
+    boost::unordered_map<uint32_t, size_t> last_hit;
+    for (size_t index = 0; index < events.size(); index++){
+      parent[index] = index;
+      int32_t x = LATRD::get_position_x(events[index].position_id);
+      int32_t y = LATRD::get_position_y(events[index].position_id);
+      for (int32_t nx = x - 1; nx <= x + 1; nx++){
+        for (int32_t ny = y - 1; ny <= y + 1; ny++){
+          if (nx < 0 || ny < 0 || ny > (int32_t)LATRD::position_y_mask){
+            continue;
+          }
+          uint32_t neighbour = ((uint32_t)nx << LATRD::position_x_shift) | (uint32_t)ny;
+          boost::unordered_map<uint32_t, size_t>::iterator hit = last_hit.find(neighbour);
+          if (hit != last_hit.end() && events[index].ts - events[hit->second].ts <= window_){
+            join(parent, index, hit->second);
+          }
+        }
+      }
+      last_hit[events[index].position_id] = index;
+    }
+
+    // Reduce each set of joined events into a cluster
+    std::vector<LATRDCluster>& clusters = partials_[partition];
+    clusters.clear();
+    std::vector<size_t> cluster_index(events.size());
+    for (size_t index = 0; index < events.size(); index++){
+      size_t root = find_root(parent, index);
+      if (root == index){
+        cluster_index[index] = clusters.size();
+        clusters.push_back(LATRDCluster());
+      }
+      clusters[cluster_index[root]].add_event(events[index].ts, events[index].position_id, events[index].energy);
+    }
+    partial_min_[partition] = events.empty() ? empty_ts_min : events.front().ts;
+    partial_max_[partition] = events.empty() ? 0 : events.back().ts;
+  }
+
+  std::vector<LATRDCluster> LATRDClusterer::stitch(bool purge)
+  {
+    // Held back clusters are treated as one more partition
+    std::vector<std::vector<LATRDCluster> *> groups;
+    std::vector<uint64_t> group_min;
+    std::vector<uint64_t> group_max;
+    uint64_t release_max = 0;
+    for (size_t partition = 0; partition < partials_.size(); partition++){
+      if (!partials_[partition].empty()){
+        groups.push_back(&partials_[partition]);
+        group_min.push_back(partial_min_[partition]);
+        group_max.push_back(partial_max_[partition]);
+        release_max = std::max(release_max, partial_max_[partition]);
+      }
+    }
+    std::vector<LATRDCluster> pending;
+    pending.swap(pending_);
+    if (!pending.empty()){
+      uint64_t pending_min = empty_ts_min;
+      uint64_t pending_max = 0;
+      for (size_t index = 0; index < pending.size(); index++){
+        pending_min = std::min(pending_min, pending[index].first_ts);
+        pending_max = std::max(pending_max, pending[index].last_ts);
+      }
+      groups.push_back(&pending);
+      group_min.push_back(pending_min);
+      group_max.push_back(pending_max);
+    }
+
+    // Only clusters that come within the window of another partition can need stitching
+    std::vector<LATRDStitchCandidate> candidates;
+    std::vector<LATRDCluster> complete;
+    for (size_t group = 0; group < groups.size(); group++){
+      std::vector<LATRDCluster>::iterator cluster;
+      for (cluster = groups[group]->begin(); cluster != groups[group]->end(); ++cluster){
+        bool boundary = false;
+        for (size_t other = 0; other < groups.size() && !boundary; other++){
+          boundary = other != group &&
+                     cluster->first_ts <= group_max[other] + window_ &&
+                     cluster->last_ts + window_ >= group_min[other];
+        }
+        if (boundary){
+          LATRDStitchCandidate candidate = {&(*cluster), group};
+          candidates.push_back(candidate);
+        } else {
+          complete.push_back(*cluster);
+        }
+      }
+    }
+
+    // Candidates are ordered by time so each is only compared with those starting within its window
+    std::sort(candidates.begin(), candidates.end(), candidate_before);
+    std::vector<size_t> parent(candidates.size());
+    for (size_t index = 0; index < parent.size(); index++){
+      parent[index] = index;
+    }
+    for (size_t first = 0; first < candidates.size(); first++){
+      LATRDCluster *a = candidates[first].cluster;
+      for (size_t second = first + 1; second < candidates.size(); second++){
+        LATRDCluster *b = candidates[second].cluster;
+        if (b->first_ts > a->last_ts + window_){
+          break;
+        }
+        if (candidates[first].group != candidates[second].group && a->touches(*b, window_)){
+          join(parent, first, second);
+        }
+      }
+    }
+    std::vector<LATRDCluster> stitched;
+    std::vector<size_t> stitched_index(candidates.size());
+    for (size_t index = 0; index < candidates.size(); index++){
+      size_t root = find_root(parent, index);
+      if (root == index){
+        stitched_index[index] = stitched.size();
+        stitched.push_back(LATRDCluster());
+      }
+    }
+    for (size_t index = 0; index < candidates.size(); index++){
+      stitched[stitched_index[find_root(parent, index)]].merge(*candidates[index].cluster);
+    }
+    complete.insert(complete.end(), stitched.begin(), stitched.end());
+
+    // Clusters that could still be joined by the next released events are held back
+    std::vector<LATRDCluster> clusters;
+    std::vector<LATRDCluster>::iterator cluster;
+    for (cluster = complete.begin(); cluster != complete.end(); ++cluster){
+      if (!purge && cluster->last_ts + window_ > release_max){
+        pending_.push_back(*cluster);
+      } else {
+        clusters.push_back(*cluster);
+      }
+    }
+    std::sort(clusters.begin(), clusters.end(), cluster_before);
+
+    for (size_t partition = 0; partition < partials_.size(); partition++){
+      partials_[partition].clear();
+      partial_min_[partition] = empty_ts_min;
+      partial_max_[partition] = 0;
+    }
+    return clusters;
+  }
+
+  LATRDClusterTask::LATRDClusterTask(LATRDClusterer *clusterer, size_t partition) :
+      clusterer(clusterer),
+      partition(partition)
+  {
+  }
+
+  void LATRDClusterTask::execute()
+  {
+    clusterer->cluster_events(partition, jobs);
+  }
+
+}
@@ -0,0 +1,300 @@
+#include <string.h>
+#ifdef LATRD_LZ4_SUPPORT
+#include <lz4.h>
+#endif
+#include "LATRDCompressor.h"
+
+namespace FrameProcessor {
+
+  /** Target size of a bitshuffle block in bytes, matching the HDF5 bitshuffle filter */
+  static const size_t bshuf_target_block_size = 8192;
+  static const size_t bshuf_blocked_mult = 8;
+  static const size_t bshuf_min_block = 128;
+
+  static void write_uint64_be(char *ptr, uint64_t value)
+  {
+    for (int index = 7; index >= 0; index--){
+      ptr[index] = (char)(value & 0xFF);
+      value >>= 8;
+    }
+  }
+
+  static void write_uint32_be(char *ptr, uint32_t value)
+  {
+    for (int index = 3; index >= 0; index--){
+      ptr[index] = (char)(value & 0xFF);
+      value >>= 8;
+    }
+  }
+
+  static uint64_t read_uint64_be(const char *ptr)
+  {
+    uint64_t value = 0;
+    for (int index = 0; index < 8; index++){
+      value = (value << 8) | (uint8_t)ptr[index];
+    }
+    return value;
+  }
+
+  static uint32_t read_uint32_be(const char *ptr)
+  {
+    uint32_t value = 0;
+    for (int index = 0; index < 4; index++){
+      value = (value << 8) | (uint8_t)ptr[index];
+    }
+    return value;
+  }
+
+  static size_t default_block_size(size_t elem_size)
+  {
+    size_t block_size = bshuf_target_block_size / elem_size;
+    block_size = (block_size / bshuf_blocked_mult) * bshuf_blocked_mult;
+    if (block_size < bshuf_min_block){
+      block_size = bshuf_min_block;
+    }
+    return block_size;
+  }
+
+  static void bitshuffle_block(const char *in, char *out, char *tmp, size_t size, size_t elem_size)
+  {
+    size_t nbyte = size * elem_size;
+    size_t nbyte_bitrow = nbyte / 8;
+    size_t nbyte_row = size / 8;
+
+    // Transpose bytes so that byte j of every element is contiguous
+    for (size_t ii = 0; ii < size; ii++){
+      for (size_t jj = 0; jj < elem_size; jj++){
+        out[jj * size + ii] = in[ii * elem_size + jj];
+      }
+    }
+    // Transpose the bits within each group of eight bytes
+    for (size_t ii = 0; ii < nbyte_bitrow; ii++){
+      uint64_t x;
+      uint64_t t;
+      memcpy(&x, out + ii * 8, sizeof(uint64_t));
+      t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+      x = x ^ t ^ (t << 7);
+      t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+      x = x ^ t ^ (t << 14);
+      t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+      x = x ^ t ^ (t << 28);
+      for (size_t kk = 0; kk < 8; kk++){
+        tmp[kk * nbyte_bitrow + ii] = (char)x;
+        x = x >> 8;
+      }
+    }
+    // Reorder the bit rows so that rows are grouped by source byte
+    for (size_t ii = 0; ii < 8; ii++){
+      for (size_t jj = 0; jj < elem_size; jj++){
+        memcpy(out + (jj * 8 + ii) * nbyte_row, tmp + (ii * elem_size + jj) * nbyte_row, nbyte_row);
+      }
+    }
+  }
+
+  bool LATRDCompressor::available()
+  {
+#ifdef LATRD_LZ4_SUPPORT
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  size_t LATRDCompressor::element_size(int data_type)
+  {
+    switch (data_type)
+    {
+    case 0:
+      return sizeof(uint8_t);
+    case 1:
+      return sizeof(uint16_t);
+    case 2:
+      return sizeof(uint32_t);
+    case 3:
+      return sizeof(uint64_t);
+    case 4:
+      return sizeof(float);
+    default:
+      throw LATRDProcessingException("Unknown datatype specified for compression");
+    }
+  }
+
+  boost::shared_ptr<Frame> LATRDCompressor::compress(boost::shared_ptr<Frame> frame, bool delta)
+  {
+    size_t elem_size = element_size(frame->get_data_type());
+    size_t size = frame->get_data_size() / elem_size;
+    const char *src_ptr = static_cast<const char *>(frame->get_data());
+
+    // Delta encoding is applied to a copy as the source frame must not be modified
+    std::vector<uint64_t> delta_values;
+    if (delta && elem_size == sizeof(uint64_t)){
+      delta_values.resize(size);
+      memcpy(&delta_values[0], src_ptr, size * elem_size);
+      delta_encode(&delta_values[0], size);
+      src_ptr = reinterpret_cast<const char *>(&delta_values[0]);
+    }
+
+    std::vector<char> compressed(bslz4_bound(size, elem_size));
+    size_t bytes = compress_bslz4(src_ptr, &compressed[0], size, elem_size);
+
+    boost::shared_ptr<Frame> out_frame = boost::shared_ptr<Frame>(new Frame(frame->get_dataset_name()));
+    out_frame->copy_data(&compressed[0], bytes);
+    out_frame->set_frame_number(frame->get_frame_number());
+    out_frame->set_dataset_name(frame->get_dataset_name());
+    out_frame->set_data_type(frame->get_data_type());
+    out_frame->set_dimensions(frame->get_dimensions());
+    out_frame->set_compression(bslz4_frame_compression);
+    return out_frame;
+  }
+
+  void LATRDCompressor::delta_encode(uint64_t *data, size_t qty_pts)
+  {
+    // Walk backwards so that each value is replaced by the difference from its predecessor
+    for (size_t index = qty_pts; index > 1; index--){
+      data[index-1] -= data[index-2];
+    }
+  }
+
+  void LATRDCompressor::delta_decode(uint64_t *data, size_t qty_pts)
+  {
+    for (size_t index = 1; index < qty_pts; index++){
+      data[index] += data[index-1];
+    }
+  }
+
+  void LATRDCompressor::bitshuffle(const void *in, void *out, size_t size, size_t elem_size)
+  {
+    if (size % bshuf_blocked_mult != 0){
+      throw LATRDProcessingException("Bitshuffle requires a multiple of eight elements");
+    }
+    std::vector<char> tmp(size * elem_size);
+    bitshuffle_block(static_cast<const char *>(in), static_cast<char *>(out), &tmp[0], size, elem_size);
+  }
+
+  void LATRDCompressor::bitunshuffle(const void *in, void *out, size_t size, size_t elem_size)
+  {
+    if (size % bshuf_blocked_mult != 0){
+      throw LATRDProcessingException("Bitshuffle requires a multiple of eight elements");
+    }
+    const uint8_t *in_ptr = static_cast<const uint8_t *>(in);
+    uint8_t *out_ptr = static_cast<uint8_t *>(out);
+    size_t nbyte_row = size / 8;
+    memset(out_ptr, 0, size * elem_size);
+    // Bit m of byte g in row (j*8 + k) holds bit k of byte j of element (g*8 + m)
+    for (size_t jj = 0; jj < elem_size; jj++){
+      for (size_t kk = 0; kk < 8; kk++){
+        const uint8_t *row_ptr = in_ptr + (jj * 8 + kk) * nbyte_row;
+        for (size_t gg = 0; gg < nbyte_row; gg++){
+          uint8_t bits = row_ptr[gg];
+          for (size_t mm = 0; mm < 8; mm++){
+            out_ptr[(gg * 8 + mm) * elem_size + jj] |= (uint8_t)(((bits >> mm) & 0x01) << kk);
+          }
+        }
+      }
+    }
+  }
+
+  size_t LATRDCompressor::bslz4_bound(size_t size, size_t elem_size)
+  {
+    size_t block_size = default_block_size(elem_size);
+    // Header plus a size word and worst case LZ4 expansion for each block
+    size_t blocks = (size / block_size) + 1;
+    size_t block_bytes = block_size * elem_size;
+    return 12 + blocks * (4 + block_bytes + (block_bytes / 255) + 16) + (size % bshuf_blocked_mult) * elem_size;
+  }
+
+  size_t LATRDCompressor::compress_bslz4(const void *in, void *out, size_t size, size_t elem_size)
+  {
+#ifdef LATRD_LZ4_SUPPORT
+    const char *in_ptr = static_cast<const char *>(in);
+    char *out_ptr = static_cast<char *>(out);
+    size_t block_size = default_block_size(elem_size);
+
+    // Write the header required by the bitshuffle filter
+    write_uint64_be(out_ptr, size * elem_size);
+    write_uint32_be(out_ptr + 8, block_size * elem_size);
+    size_t bytes = 12;
+
+    std::vector<char> shuffled(block_size * elem_size);
+    std::vector<char> tmp(block_size * elem_size);
+    size_t position = 0;
+    while (position < size){
+      size_t this_block = block_size;
+      if (size - position < block_size){
+        // Final partial block is truncated to a multiple of eight elements
+        this_block = (size - position) - ((size - position) % bshuf_blocked_mult);
+        if (this_block == 0){
+          break;
+        }
+      }
+      bitshuffle_block(in_ptr + position * elem_size, &shuffled[0], &tmp[0], this_block, elem_size);
+      int block_bytes = (int)(this_block * elem_size);
+      int compressed = LZ4_compress_default(&shuffled[0],
+                                            out_ptr + bytes + 4,
+                                            block_bytes,
+                                            LZ4_compressBound(block_bytes));
+      if (compressed <= 0){
+        throw LATRDProcessingException("LZ4 compression of block failed");
+      }
+      write_uint32_be(out_ptr + bytes, (uint32_t)compressed);
+      bytes += 4 + compressed;
+      position += this_block;
+    }
+    // Any remaining elements are stored without compression
+    size_t leftover = (size - position) * elem_size;
+    memcpy(out_ptr + bytes, in_ptr + position * elem_size, leftover);
+    bytes += leftover;
+    return bytes;
+#else
+    throw LATRDProcessingException("LZ4 compression support was not built");
+#endif
+  }
+
+  size_t LATRDCompressor::decompress_bslz4(const void *in, size_t in_bytes, void *out, size_t out_bytes, size_t elem_size)
+  {
+#ifdef LATRD_LZ4_SUPPORT
+    const char *in_ptr = static_cast<const char *>(in);
+    char *out_ptr = static_cast<char *>(out);
+    size_t total_bytes = read_uint64_be(in_ptr);
+    size_t block_bytes = read_uint32_be(in_ptr + 8);
+    if (total_bytes > out_bytes){
+      throw LATRDProcessingException("Decompression buffer is too small");
+    }
+    size_t position = 12;
+    size_t written = 0;
+    std::vector<char> shuffled(block_bytes);
+    size_t tail_bytes = (total_bytes / elem_size % bshuf_blocked_mult) * elem_size;
+    while (written + tail_bytes < total_bytes && position < in_bytes){
+      size_t this_block = block_bytes;
+      if (total_bytes - tail_bytes - written < block_bytes){
+        this_block = total_bytes - tail_bytes - written;
+      }
+      int compressed = (int)read_uint32_be(in_ptr + position);
+      position += 4;
+      if (LZ4_decompress_safe(in_ptr + position, &shuffled[0], compressed, (int)this_block) != (int)this_block){
+        throw LATRDProcessingException("LZ4 decompression of block failed");
+      }
+      position += compressed;
+      bitunshuffle(&shuffled[0], out_ptr + written, this_block / elem_size, elem_size);
+      written += this_block;
+    }
+    memcpy(out_ptr + written, in_ptr + position, tail_bytes);
+    written += tail_bytes;
+    return written;
+#else
+    throw LATRDProcessingException("LZ4 compression support was not built");
+#endif
+  }
+
+  LATRDCompressionTask::LATRDCompressionTask(boost::shared_ptr<Frame> frame, bool delta) :
+      in_frame(frame),
+      delta(delta)
+  {
+  }
+
+  void LATRDCompressionTask::execute()
+  {
+    out_frame = LATRDCompressor::compress(in_frame, delta);
+  }
+
+}
@@ -0,0 +1,112 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+
+#include "LATRDDefinitions.h"
+#include "LATRDEnergyCalibration.h"
+
+namespace FrameProcessor {
+
+  LATRDEnergyCalibration::LATRDEnergyCalibration(uint32_t width,
+                                                 uint32_t height,
+                                                 LATRDEnergyOutput output,
+                                                 uint32_t fraction_bits) :
+      width_(width),
+      height_(height),
+      output_(output),
+      fraction_bits_(fraction_bits),
+      fixed_scale_(1.0f),
+      terms_((size_t)width * height)
+  {
+    if (fraction_bits > 16){
+      throw LATRDProcessingException("Fixed point energies cannot have more than 16 fractional bits");
+    }
+    fixed_scale_ = (float)(1 << fraction_bits);
+    // Until coefficients are loaded every pixel is uncalibrated
+    PixelTerms uncalibrated = {0.0f, 0.0f, 0.0f, 0.0f};
+    terms_.assign(terms_.size(), uncalibrated);
+  }
+
+  LATRDEnergyCalibration::~LATRDEnergyCalibration()
+  {
+  }
+
+  void LATRDEnergyCalibration::set_coefficients(const std::vector<float>& coefficients)
+  {
+    if (coefficients.size() != terms_.size() * calibration_coefficients){
+      throw LATRDProcessingException("Calibration coefficients do not match the sensor size");
+    }
+    for (size_t pixel = 0; pixel < terms_.size(); pixel++){
+      float a = coefficients[pixel * calibration_coefficients];
+      float b = coefficients[pixel * calibration_coefficients + 1];
+      float c = coefficients[pixel * calibration_coefficients + 2];
+      float t = coefficients[pixel * calibration_coefficients + 3];
+      // E = (t*a - b + ToT + sqrt((ToT - (b + t*a))^2 + 4*a*c)) / 2a
+      PixelTerms terms = {0.0f, 0.0f, 0.0f, 0.0f};
+      if (a != 0.0f){
+        terms.offset = (t * a) - b;
+        terms.centre = b + (t * a);
+        terms.four_ac = 4.0f * a * c;
+        terms.inv_two_a = 1.0f / (2.0f * a);
+      }
+      terms_[pixel] = terms;
+    }
+  }
+
+  void LATRDEnergyCalibration::load_coefficients(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file){
+      throw LATRDProcessingException("Unable to open energy calibration file " + filename);
+    }
+    std::vector<float> coefficients(terms_.size() * calibration_coefficients);
+    size_t bytes = coefficients.size() * sizeof(float);
+    file.read((char *)&coefficients[0], bytes);
+    if ((size_t)file.gcount() != bytes || file.peek() != std::ifstream::traits_type::eof()){
+      throw LATRDProcessingException("Energy calibration file " + filename + " does not match the sensor size");
+    }
+    this->set_coefficients(coefficients);
+  }
+
+  LATRDEnergyOutput LATRDEnergyCalibration::output()
+  {
+    return output_;
+  }
+
+  uint32_t LATRDEnergyCalibration::fraction_bits()
+  {
+    return fraction_bits_;
+  }
+
+  float LATRDEnergyCalibration::energy(uint32_t position_id, uint32_t tot)
+  {
+    uint32_t x = LATRD::get_position_x(position_id);
+    uint32_t y = LATRD::get_position_y(position_id);
+    if (x >= width_ || y >= height_){
+      return 0.0f;
+    }
+    const PixelTerms& terms = terms_[(y * width_) + x];
+    float value = (float)tot;
+    float delta = value - terms.centre;
+    float root = sqrtf(std::max(0.0f, (delta * delta) + terms.four_ac));
+    return std::max(0.0f, (terms.offset + value + root) * terms.inv_two_a);
+  }
+
+  void LATRDEnergyCalibration::calibrate(const uint32_t *event_id, uint32_t *event_energy, uint16_t qty_events)
+  {
+    if (output_ == FLOAT_ENERGY){
+      for (uint16_t index = 0; index < qty_events; index++){
+        // The float is stored in the 32 bit energy slot without conversion
+        float value = this->energy(event_id[index], event_energy[index]);
+        memcpy(&event_energy[index], &value, sizeof(float));
+      }
+    } else if (output_ == FIXED_ENERGY){
+      for (uint16_t index = 0; index < qty_events; index++){
+        float value = this->energy(event_id[index], event_energy[index]);
+        event_energy[index] = (uint32_t)std::min((value * fixed_scale_) + 0.5f, 4294967040.0f);
+      }
+    }
+  }
+
+}
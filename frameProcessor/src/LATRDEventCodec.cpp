@@ -0,0 +1,112 @@
+#include "LATRDEventCodec.h"
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  static inline uint8_t *write_varint(uint64_t value, uint8_t *out)
+  {
+    while (value >= 0x80){
+      *out++ = (uint8_t)(value | 0x80);
+      value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+  }
+
+  static inline const uint8_t *read_varint(const uint8_t *in, const uint8_t *end, uint64_t *value)
+  {
+    uint64_t result = 0;
+    int shift = 0;
+    while (in < end && shift < 64){
+      uint8_t byte = *in++;
+      result |= (uint64_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0){
+        *value = result;
+        return in;
+      }
+      shift += 7;
+    }
+    throw LATRDProcessingException("Truncated varint in event stream");
+  }
+
+  void LATRDEventCodec::pack_record(uint64_t ts, uint32_t id, uint32_t energy, uint32_t *record)
+  {
+    record[0] = (uint32_t)(ts & 0xFFFFFFFF);
+    record[1] = (uint32_t)((ts >> 32) & 0x000FFFFF) | ((energy & 0x0FFF) << 20);
+    record[2] = ((energy >> 12) & 0x03) | ((id & 0x03FFFFFF) << 2);
+  }
+
+  void LATRDEventCodec::unpack_record(const uint32_t *record, uint64_t *ts, uint32_t *id, uint32_t *energy)
+  {
+    *ts = (uint64_t)record[0] | ((uint64_t)(record[1] & 0x000FFFFF) << 32);
+    *energy = (record[1] >> 20) | ((record[2] & 0x03) << 12);
+    *id = (record[2] >> 2) & 0x03FFFFFF;
+  }
+
+  size_t LATRDEventCodec::pack_records(const uint64_t *ts, const uint32_t *id, const uint32_t *energy, size_t qty_pts, uint32_t *out)
+  {
+    for (size_t index = 0; index < qty_pts; index++){
+      pack_record(ts[index], id[index], energy[index], out);
+      out += packed_event_words;
+    }
+    return qty_pts * packed_event_words;
+  }
+
+  size_t LATRDEventCodec::unpack_records(const uint32_t *in, size_t qty_pts, uint64_t *ts, uint32_t *id, uint32_t *energy)
+  {
+    for (size_t index = 0; index < qty_pts; index++){
+      unpack_record(in, &ts[index], &id[index], &energy[index]);
+      in += packed_event_words;
+    }
+    return qty_pts;
+  }
+
+  size_t LATRDEventCodec::varint_bound(size_t qty_pts)
+  {
+    // Block header is at most 10 bytes
+    return 10 + (qty_pts * varint_event_max_bytes);
+  }
+
+  size_t LATRDEventCodec::encode_varint_block(const uint64_t *ts, const uint32_t *id, const uint32_t *energy, size_t qty_pts, uint8_t *out)
+  {
+    uint8_t *ptr = write_varint(qty_pts, out);
+    uint64_t previous_ts = 0;
+    for (size_t index = 0; index < qty_pts; index++){
+      // Zigzag encode the signed difference so small negative steps stay short
+      int64_t delta = (int64_t)(ts[index] - previous_ts);
+      ptr = write_varint(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63), ptr);
+      ptr = write_varint(id[index], ptr);
+      ptr = write_varint(energy[index], ptr);
+      previous_ts = ts[index];
+    }
+    return ptr - out;
+  }
+
+  size_t LATRDEventCodec::decode_varint_stream(const uint8_t *in,
+                                               size_t bytes,
+                                               std::vector<uint64_t>& ts,
+                                               std::vector<uint32_t>& id,
+                                               std::vector<uint32_t>& energy)
+  {
+    const uint8_t *end = in + bytes;
+    size_t events = 0;
+    uint64_t value = 0;
+    while (in < end){
+      in = read_varint(in, end, &value);
+      size_t qty_pts = value;
+      uint64_t previous_ts = 0;
+      for (size_t index = 0; index < qty_pts; index++){
+        in = read_varint(in, end, &value);
+        previous_ts += (uint64_t)((int64_t)(value >> 1) ^ -(int64_t)(value & 1));
+        ts.push_back(previous_ts);
+        in = read_varint(in, end, &value);
+        id.push_back((uint32_t)value);
+        in = read_varint(in, end, &value);
+        energy.push_back((uint32_t)value);
+      }
+      events += qty_pts;
+    }
+    return events;
+  }
+
+}
@@ -0,0 +1,152 @@
+#include <fstream>
+#include <iterator>
+
+#include "LATRDDefinitions.h"
+#include "LATRDEventFilter.h"
+
+namespace FrameProcessor {
+
+  LATRDEventFilter::LATRDEventFilter(uint32_t width, uint32_t height) :
+      width_(width),
+      height_(height),
+      energy_enabled_(false),
+      energy_min_(0),
+      energy_max_(0),
+      roi_enabled_(false),
+      roi_x_(0),
+      roi_y_(0),
+      roi_width_(0),
+      roi_height_(0)
+  {
+  }
+
+  LATRDEventFilter::~LATRDEventFilter()
+  {
+  }
+
+  void LATRDEventFilter::set_energy_window(uint32_t min, uint32_t max)
+  {
+    if (min > max){
+      throw LATRDProcessingException("Energy window minimum is greater than the maximum");
+    }
+    energy_enabled_ = true;
+    energy_min_ = min;
+    energy_max_ = max;
+  }
+
+  void LATRDEventFilter::set_roi(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+  {
+    roi_enabled_ = true;
+    roi_x_ = x;
+    roi_y_ = y;
+    roi_width_ = width;
+    roi_height_ = height;
+  }
+
+  void LATRDEventFilter::set_roi_map(const std::vector<uint8_t>& map)
+  {
+    if (map.size() != (size_t)width_ * height_){
+      throw LATRDProcessingException("ROI map does not match the sensor size");
+    }
+    roi_map_ = map;
+  }
+
+  void LATRDEventFilter::set_mask(const std::vector<uint8_t>& mask)
+  {
+    if (mask.size() != (size_t)width_ * height_){
+      throw LATRDProcessingException("Pixel mask does not match the sensor size");
+    }
+    mask_ = mask;
+  }
+
+  std::vector<uint8_t> LATRDEventFilter::load_map(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file){
+      throw LATRDProcessingException("Unable to open pixel map file " + filename);
+    }
+    std::vector<uint8_t> map((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (map.size() != (size_t)width_ * height_){
+      throw LATRDProcessingException("Pixel map file " + filename + " does not match the sensor size");
+    }
+    return map;
+  }
+
+  bool LATRDEventFilter::enabled()
+  {
+    return energy_enabled_ || roi_enabled_ || !roi_map_.empty() || !mask_.empty();
+  }
+
+  uint16_t LATRDEventFilter::filter(uint64_t *event_ts,
+                                    uint32_t *event_id,
+                                    uint32_t *event_pixel,
+                                    uint32_t *event_energy,
+                                    uint16_t qty_events,
+                                    uint32_t *ctrl_index,
+                                    uint16_t qty_ctrl,
+                                    uint32_t *energy_rejects,
+                                    uint32_t *roi_rejects,
+                                    uint32_t *mask_rejects)
+  {
+    const uint8_t *roi_map = roi_map_.empty() ? 0 : &roi_map_[0];
+    const uint8_t *mask = mask_.empty() ? 0 : &mask_[0];
+    uint32_t energy_range = energy_max_ - energy_min_;
+    uint32_t energy_count = 0;
+    uint32_t roi_count = 0;
+    uint32_t mask_count = 0;
+    uint16_t kept = 0;
+    uint16_t ctrl = 0;
+
+    for (uint16_t index = 0; index < qty_events; index++){
+      // Control words index the next event, so move them to the next kept event
+      while (ctrl < qty_ctrl && ctrl_index[ctrl] == index){
+        ctrl_index[ctrl++] = kept;
+      }
+      uint32_t id = event_id[index];
+      uint32_t pixel_id = event_pixel[index];
+      uint32_t energy = event_energy[index];
+      uint32_t x = LATRD::get_position_x(pixel_id);
+      uint32_t y = LATRD::get_position_y(pixel_id);
+      uint32_t in_sensor = (x < width_) & (y < height_);
+      size_t pixel = in_sensor ? (y * width_) + x : 0;
+
+      // Each test is evaluated without branching on the event
+      uint32_t energy_ok = 1;
+      if (energy_enabled_){
+        energy_ok = (energy - energy_min_) <= energy_range;
+      }
+      uint32_t roi_ok = 1;
+      if (roi_enabled_){
+        roi_ok = ((x - roi_x_) < roi_width_) & ((y - roi_y_) < roi_height_);
+      }
+      if (roi_map){
+        roi_ok &= in_sensor & (roi_map[pixel] != 0);
+      }
+      uint32_t mask_ok = 1;
+      if (mask){
+        mask_ok = !(in_sensor & (mask[pixel] != 0));
+      }
+      uint32_t keep = energy_ok & roi_ok & mask_ok;
+
+      // Always copy and only advance the output position if the event is kept
+      event_ts[kept] = event_ts[index];
+      event_id[kept] = id;
+      event_pixel[kept] = pixel_id;
+      event_energy[kept] = energy;
+      kept += keep;
+
+      // Rejections are counted against the first test that failed
+      energy_count += !energy_ok;
+      roi_count += energy_ok & !roi_ok;
+      mask_count += energy_ok & roi_ok & !mask_ok;
+    }
+    while (ctrl < qty_ctrl){
+      ctrl_index[ctrl++] = kept;
+    }
+    *energy_rejects += energy_count;
+    *roi_rejects += roi_count;
+    *mask_rejects += mask_count;
+    return kept;
+  }
+
+}
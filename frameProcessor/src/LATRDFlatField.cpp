@@ -0,0 +1,162 @@
+#include <math.h>
+#include <fstream>
+
+#include "LATRDFlatField.h"
+
+namespace FrameProcessor {
+
+  LATRDFlatField::LATRDFlatField(uint32_t width,
+                                 uint32_t height,
+                                 LATRDFlatFieldOutput output,
+                                 uint32_t fraction_bits) :
+      width_(width),
+      height_(height),
+      output_(output),
+      fixed_scale_(1.0f),
+      gain_((size_t)width * height, 1.0f),
+      mask_((size_t)width * height, 0)
+  {
+    if (fraction_bits > 16){
+      throw LATRDProcessingException("Fixed point images cannot have more than 16 fractional bits");
+    }
+    fixed_scale_ = (float)(1 << fraction_bits);
+    if (output_ == FLOAT_FLAT_FIELD){
+      float_image_.resize(gain_.size());
+    } else {
+      fixed_image_.resize(gain_.size());
+    }
+    // Until a gain map or mask is loaded every pixel has unit gain
+    this->update_factors();
+  }
+
+  LATRDFlatField::~LATRDFlatField()
+  {
+  }
+
+  void LATRDFlatField::set_gain(const std::vector<float>& gain)
+  {
+    if (gain.size() != gain_.size()){
+      throw LATRDProcessingException("Flat field gain map does not match the sensor size");
+    }
+    gain_ = gain;
+    this->update_factors();
+  }
+
+  void LATRDFlatField::load_gain(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file){
+      throw LATRDProcessingException("Unable to open flat field gain file " + filename);
+    }
+    std::vector<float> gain(gain_.size());
+    size_t bytes = gain.size() * sizeof(float);
+    file.read((char *)&gain[0], bytes);
+    if ((size_t)file.gcount() != bytes || file.peek() != std::ifstream::traits_type::eof()){
+      throw LATRDProcessingException("Flat field gain file " + filename + " does not match the sensor size");
+    }
+    this->set_gain(gain);
+  }
+
+  void LATRDFlatField::set_mask(const std::vector<uint8_t>& mask)
+  {
+    if (mask.size() != mask_.size()){
+      throw LATRDProcessingException("Pixel mask does not match the sensor size");
+    }
+    mask_ = mask;
+    this->update_factors();
+  }
+
+  void LATRDFlatField::load_mask(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file){
+      throw LATRDProcessingException("Unable to open pixel mask file " + filename);
+    }
+    std::vector<uint8_t> mask((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (mask.size() != mask_.size()){
+      throw LATRDProcessingException("Pixel mask file " + filename + " does not match the sensor size");
+    }
+    this->set_mask(mask);
+  }
+
+  uint32_t LATRDFlatField::width()
+  {
+    return width_;
+  }
+
+  uint32_t LATRDFlatField::height()
+  {
+    return height_;
+  }
+
+  LATRDFlatFieldOutput LATRDFlatField::output()
+  {
+    return output_;
+  }
+
+  boost::shared_ptr<Frame> LATRDFlatField::correct(const void *image, uint32_t depth, uint32_t number)
+  {
+    if (depth != 16 && depth != 32){
+      throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+    }
+    boost::shared_ptr<Frame> frame = boost::shared_ptr<Frame>(new Frame("image_corrected"));
+    if (output_ == FLOAT_FLAT_FIELD){
+      if (depth == 32){
+        this->correct_float((const uint32_t *)image, &float_image_[0]);
+      } else {
+        this->correct_float((const uint16_t *)image, &float_image_[0]);
+      }
+      frame->copy_data(&float_image_[0], float_image_.size() * sizeof(float));
+      // Data type 4 is float32
+      frame->set_data_type(4);
+    } else {
+      if (depth == 32){
+        this->correct_fixed((const uint32_t *)image, &fixed_image_[0]);
+      } else {
+        this->correct_fixed((const uint16_t *)image, &fixed_image_[0]);
+      }
+      frame->copy_data(&fixed_image_[0], fixed_image_.size() * sizeof(uint32_t));
+      frame->set_data_type(2);
+    }
+    frame->set_frame_number(number);
+    std::vector<dimsize_t> dims(0);
+    dims.push_back(height_);
+    dims.push_back(width_);
+    frame->set_dataset_name("image_corrected");
+    frame->set_dimensions(dims);
+    return frame;
+  }
+
+  void LATRDFlatField::update_factors()
+  {
+    float scale = (output_ == FIXED_FLAT_FIELD) ? fixed_scale_ : 1.0f;
+    factors_.resize(gain_.size());
+    for (size_t pixel = 0; pixel < gain_.size(); pixel++){
+      float gain = gain_[pixel];
+      bool valid = (mask_[pixel] == 0) && (isfinite(gain) != 0) && (gain >= 0.0f);
+      factors_[pixel] = valid ? gain * scale : 0.0f;
+    }
+  }
+
+  template <typename T> void LATRDFlatField::correct_float(const T *image, float *output)
+  {
+    const float *factor_ptr = &factors_[0];
+    size_t pixels = factors_.size();
+    for (size_t pixel = 0; pixel < pixels; pixel++){
+      output[pixel] = (float)image[pixel] * factor_ptr[pixel];
+    }
+  }
+
+  template <typename T> void LATRDFlatField::correct_fixed(const T *image, uint32_t *output)
+  {
+    // Values are rounded to the nearest step, and held at the largest value that float to integer conversion keeps
+    static const float fixed_limit = 4294967040.0f;
+    const float *factor_ptr = &factors_[0];
+    size_t pixels = factors_.size();
+    for (size_t pixel = 0; pixel < pixels; pixel++){
+      float value = ((float)image[pixel] * factor_ptr[pixel]) + 0.5f;
+      output[pixel] = (uint32_t)(value < fixed_limit ? value : fixed_limit);
+    }
+  }
+
+}
@@ -0,0 +1,80 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <errno.h>
+
+#include "LATRDFrameCounter.h"
+
+namespace FrameProcessor {
+
+  LATRDFrameCounter::LATRDFrameCounter(const std::string& name) :
+      name_(segment_name(name)),
+      fd_(-1),
+      counters_(0)
+  {
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd_ == -1){
+      throw LATRDProcessingException("Unable to open frame counter " + name_ + ": " + strerror(errno));
+    }
+    // A newly created segment is zero filled by the resize
+    size_t bytes = NUMBER_OF_FRAME_SLOTS * sizeof(uint64_t);
+    if (ftruncate(fd_, bytes) == -1){
+      close(fd_);
+      throw LATRDProcessingException("Unable to size frame counter " + name_ + ": " + strerror(errno));
+    }
+    void *ptr = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (ptr == MAP_FAILED){
+      close(fd_);
+      throw LATRDProcessingException("Unable to map frame counter " + name_ + ": " + strerror(errno));
+    }
+    counters_ = static_cast<uint64_t *>(ptr);
+  }
+
+  LATRDFrameCounter::~LATRDFrameCounter()
+  {
+    // The segment is left in place as other ranks may still be using it
+    if (counters_){
+      munmap(counters_, NUMBER_OF_FRAME_SLOTS * sizeof(uint64_t));
+    }
+    if (fd_ != -1){
+      close(fd_);
+    }
+  }
+
+  std::string LATRDFrameCounter::segment_name(const std::string& name)
+  {
+    // Shared memory names must start with a single slash
+    if (name.empty() || name[0] != '/'){
+      return "/" + name;
+    }
+    return name;
+  }
+
+  const std::string& LATRDFrameCounter::name()
+  {
+    return name_;
+  }
+
+  uint64_t LATRDFrameCounter::next(LATRDFrameCounterSlot slot)
+  {
+    return __sync_fetch_and_add(&counters_[slot], (uint64_t)1);
+  }
+
+  void LATRDFrameCounter::reset()
+  {
+    for (int slot = 0; slot < NUMBER_OF_FRAME_SLOTS; slot++){
+      __sync_lock_test_and_set(&counters_[slot], (uint64_t)0);
+    }
+  }
+
+  void LATRDFrameCounter::unlink()
+  {
+    // Ranks that have the segment mapped keep using it, the next to open the name creates a new one
+    if (shm_unlink(name_.c_str()) == -1 && errno != ENOENT){
+      throw LATRDProcessingException("Unable to unlink frame counter " + name_ + ": " + strerror(errno));
+    }
+  }
+
+}
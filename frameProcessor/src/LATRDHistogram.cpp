@@ -0,0 +1,112 @@
+#include "LATRDHistogram.h"
+
+namespace FrameProcessor {
+
+  LATRDHistogramSet::LATRDHistogramSet() :
+      events(0),
+      energy(energy_spectrum_bins, 0)
+  {
+  }
+
+  LATRDHistogramSet::~LATRDHistogramSet()
+  {
+  }
+
+  void LATRDHistogramSet::add_job(LATRDProcessJob *job, bool per_module)
+  {
+    uint64_t *energy_ptr = &energy[0];
+    for (uint16_t index = 0; index < job->valid_results; index++){
+      energy_ptr[job->event_energy_ptr[index] & (energy_spectrum_bins - 1)]++;
+    }
+    if (per_module && job->valid_results > 0){
+      std::vector<uint64_t>& spectrum = modules[job->producer_id];
+      if (spectrum.empty()){
+        spectrum.assign(energy_spectrum_bins, 0);
+      }
+      uint64_t *module_ptr = &spectrum[0];
+      for (uint16_t index = 0; index < job->valid_results; index++){
+        module_ptr[job->event_energy_ptr[index] & (energy_spectrum_bins - 1)]++;
+      }
+    }
+    // All events in a job belong to the same time slice
+    time_slices[job->time_slice] += job->valid_results;
+    events += job->valid_results;
+  }
+
+  void LATRDHistogramSet::merge(LATRDHistogramSet& other)
+  {
+    for (size_t index = 0; index < energy_spectrum_bins; index++){
+      energy[index] += other.energy[index];
+    }
+    std::map<uint32_t, uint64_t>::iterator ts_iter;
+    for (ts_iter = other.time_slices.begin(); ts_iter != other.time_slices.end(); ++ts_iter){
+      time_slices[ts_iter->first] += ts_iter->second;
+    }
+    std::map<uint8_t, std::vector<uint64_t> >::iterator module_iter;
+    for (module_iter = other.modules.begin(); module_iter != other.modules.end(); ++module_iter){
+      std::vector<uint64_t>& spectrum = modules[module_iter->first];
+      if (spectrum.empty()){
+        spectrum.assign(energy_spectrum_bins, 0);
+      }
+      for (size_t index = 0; index < energy_spectrum_bins; index++){
+        spectrum[index] += module_iter->second[index];
+      }
+    }
+    events += other.events;
+  }
+
+  void LATRDHistogramSet::clear()
+  {
+    energy.assign(energy_spectrum_bins, 0);
+    time_slices.clear();
+    modules.clear();
+    events = 0;
+  }
+
+  bool LATRDHistogramSet::empty()
+  {
+    return events == 0 && time_slices.empty();
+  }
+
+  LATRDHistogramExchange::LATRDHistogramExchange() :
+      write_index_(0),
+      busy_(0)
+  {
+  }
+
+  LATRDHistogramExchange::~LATRDHistogramExchange()
+  {
+  }
+
+  LATRDHistogramSet *LATRDHistogramExchange::begin_job()
+  {
+    // Claim the active set, then check it was not swapped before the claim was visible
+    uint32_t index = 0;
+    do {
+      index = write_index_;
+      busy_ = index + 1;
+      __sync_synchronize();
+    } while (write_index_ != index);
+    return &sets_[index];
+  }
+
+  void LATRDHistogramExchange::end_job()
+  {
+    __sync_synchronize();
+    busy_ = 0;
+  }
+
+  void LATRDHistogramExchange::collect(LATRDHistogramSet& total)
+  {
+    uint32_t index = write_index_;
+    write_index_ = index ^ 1;
+    __sync_synchronize();
+    // Wait for any job that claimed the set before the swap
+    while (busy_ == index + 1){
+      __sync_synchronize();
+    }
+    total.merge(sets_[index]);
+    sets_[index].clear();
+  }
+
+}
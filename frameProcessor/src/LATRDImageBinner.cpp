@@ -0,0 +1,168 @@
+#include "LATRDDefinitions.h"
+#include "LATRDImageBinner.h"
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  LATRDImageBinner::LATRDImageBinner(uint32_t width, uint32_t height, uint64_t bin_width, size_t partitions) :
+      width_(width),
+      height_(height),
+      bin_width_(bin_width),
+      processes_(1),
+      rank_(0),
+      partials_(partitions),
+      late_(partitions, 0),
+      next_bin_(0),
+      images_(0)
+  {
+    if (bin_width_ == 0){
+      throw LATRDProcessingException("Image bin width must be greater than zero");
+    }
+  }
+
+  LATRDImageBinner::~LATRDImageBinner()
+  {
+  }
+
+  void LATRDImageBinner::configure_process(size_t processes, size_t rank)
+  {
+    processes_ = processes;
+    rank_ = rank;
+  }
+
+  size_t LATRDImageBinner::partitions()
+  {
+    return partials_.size();
+  }
+
+  void LATRDImageBinner::bin_events(size_t partition, LATRDProcessJob *job)
+  {
+    std::map<uint64_t, std::vector<uint32_t> >& images = partials_[partition];
+    // Consecutive events almost always fall into the same bin so cache the image
+    uint64_t current_bin = 0;
+    uint32_t *image_ptr = 0;
+    const uint32_t *pixel_ids = job->pixel_ids();
+    for (uint16_t index = 0; index < job->valid_results; index++){
+      uint64_t bin = job->event_ts_ptr[index] / bin_width_;
+      if (bin < next_bin_){
+        late_[partition]++;
+        continue;
+      }
+      if (image_ptr == 0 || bin != current_bin){
+        std::vector<uint32_t>& image = images[bin];
+        if (image.empty()){
+          image.assign((size_t)width_ * height_, 0);
+        }
+        image_ptr = &image[0];
+        current_bin = bin;
+      }
+      uint32_t x = LATRD::get_position_x(pixel_ids[index]);
+      uint32_t y = LATRD::get_position_y(pixel_ids[index]);
+      // Pixels outside of the sensor are ignored without branching
+      uint32_t in_sensor = (x < width_) & (y < height_);
+      size_t pixel = in_sensor ? (y * width_) + x : 0;
+      image_ptr[pixel] += in_sensor;
+    }
+  }
+
+  std::vector<boost::shared_ptr<Frame> > LATRDImageBinner::close_bins(uint64_t watermark, std::vector<uint64_t>& bins)
+  {
+    // Only bins that end at or before the watermark are complete
+    return this->close_before(watermark / bin_width_, bins);
+  }
+
+  std::vector<boost::shared_ptr<Frame> > LATRDImageBinner::close_all(std::vector<uint64_t>& bins)
+  {
+    uint64_t end_bin = next_bin_;
+    for (size_t partition = 0; partition < partials_.size(); partition++){
+      if (!partials_[partition].empty() && partials_[partition].rbegin()->first >= end_bin){
+        end_bin = partials_[partition].rbegin()->first + 1;
+      }
+    }
+    std::vector<boost::shared_ptr<Frame> > frames = this->close_before(end_bin, bins);
+    // The next acquisition starts from the beginning
+    next_bin_ = 0;
+    images_ = 0;
+    return frames;
+  }
+
+  uint64_t LATRDImageBinner::bin_width()
+  {
+    return bin_width_;
+  }
+
+  uint64_t LATRDImageBinner::late_events()
+  {
+    uint64_t late = 0;
+    for (size_t partition = 0; partition < late_.size(); partition++){
+      late += late_[partition];
+    }
+    return late;
+  }
+
+  std::vector<boost::shared_ptr<Frame> > LATRDImageBinner::close_before(uint64_t end_bin, std::vector<uint64_t>& bins)
+  {
+    std::vector<boost::shared_ptr<Frame> > frames;
+    if (end_bin <= next_bin_){
+      return frames;
+    }
+    // Find every bin below the end bin that holds data in any partition, in order
+    std::map<uint64_t, bool> closing;
+    for (size_t partition = 0; partition < partials_.size(); partition++){
+      std::map<uint64_t, std::vector<uint32_t> >::iterator iter;
+      for (iter = partials_[partition].begin(); iter != partials_[partition].end() && iter->first < end_bin; ++iter){
+        closing[iter->first] = true;
+      }
+    }
+    std::map<uint64_t, bool>::iterator iter;
+    for (iter = closing.begin(); iter != closing.end(); ++iter){
+      frames.push_back(this->create_image(iter->first));
+      bins.push_back(iter->first);
+    }
+    next_bin_ = end_bin;
+    return frames;
+  }
+
+  boost::shared_ptr<Frame> LATRDImageBinner::create_image(uint64_t bin)
+  {
+    size_t pixels = (size_t)width_ * height_;
+    std::vector<uint32_t> image(pixels, 0);
+    for (size_t partition = 0; partition < partials_.size(); partition++){
+      std::map<uint64_t, std::vector<uint32_t> >::iterator iter = partials_[partition].find(bin);
+      if (iter != partials_[partition].end()){
+        uint32_t *src_ptr = &iter->second[0];
+        for (size_t pixel = 0; pixel < pixels; pixel++){
+          image[pixel] += src_ptr[pixel];
+        }
+        partials_[partition].erase(iter);
+      }
+    }
+
+    boost::shared_ptr<Frame> frame = boost::shared_ptr<Frame>(new Frame("image"));
+    frame->copy_data(&image[0], pixels * sizeof(uint32_t));
+    frame->set_frame_number(rank_ + (images_ * processes_));
+    images_++;
+    std::vector<dimsize_t> dims(0);
+    dims.push_back(height_);
+    dims.push_back(width_);
+    frame->set_dataset_name("image");
+    frame->set_data_type(2);
+    frame->set_dimensions(dims);
+    return frame;
+  }
+
+  LATRDImageBinTask::LATRDImageBinTask(LATRDImageBinner *binner, size_t partition) :
+      binner(binner),
+      partition(partition)
+  {
+  }
+
+  void LATRDImageBinTask::execute()
+  {
+    std::vector<boost::shared_ptr<LATRDProcessJob> >::iterator iter;
+    for (iter = jobs.begin(); iter != jobs.end(); ++iter){
+      binner->bin_events(partition, iter->get());
+    }
+  }
+
+}
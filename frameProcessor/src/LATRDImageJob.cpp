@@ -1,24 +1,53 @@
 //
 // Created by gnx91527 on 27/09/18.
 //
+#include <algorithm>
+
 #include "LATRDImageJob.h"
+#include "LATRDExceptions.h"
 
 namespace FrameProcessor {
 
-    LATRDImageJob::LATRDImageJob(uint32_t width, uint32_t height, uint32_t number)
+    LATRDImageJob::LATRDImageJob(uint32_t width, uint32_t height, uint32_t number, uint32_t depth, bool huge_pages)
     {
+      if (depth != 16 && depth != 32){
+        throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+      }
+      image_block_ = boost::shared_ptr<LATRDMemoryBlock>(new LATRDMemoryBlock(width * height * (depth / 8),
+                                                                              huge_pages,
+                                                                              sizeof(uint64_t)));
       width_ = width;
       height_ = height;
+      depth_ = depth;
       frame_number_ = number;
-      image_ptr_ = (uint16_t *)malloc(width * height * sizeof(uint16_t));
+      // The image block is zeroed when it is allocated
+      image_ptr_ = image_block_->data();
+      eoi_packet_id_ = -1;
+      sent_ = false;
+    }
+
+    LATRDImageJob::LATRDImageJob(uint32_t width, uint32_t height, uint32_t number, uint32_t depth,
+                                 boost::shared_ptr<LATRDMemoryBlock> pool, size_t offset)
+    {
+      if (depth != 16 && depth != 32){
+        throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+      }
+      if (offset + (width * height * (depth / 8)) > pool->bytes()){
+        throw LATRDProcessingException("Image does not fit within the image pool");
+      }
+      image_block_ = pool;
+      width_ = width;
+      height_ = height;
+      depth_ = depth;
+      frame_number_ = number;
+      // The pool is zeroed when it is allocated, and images are zeroed again as they are reset
+      image_ptr_ = (uint8_t *)pool->data() + offset;
       eoi_packet_id_ = -1;
       sent_ = false;
-      this->reset();
     }
 
     LATRDImageJob::~LATRDImageJob()
     {
-      free(image_ptr_);
     }
 
     void LATRDImageJob::set_eoi(uint32_t packet_id)
@@ -31,50 +60,66 @@ namespace FrameProcessor {
         return frame_number_;
     }
 
-    void LATRDImageJob::add_pixel(uint32_t packet_id, uint32_t x, uint32_t y, uint32_t event_count)
+    void LATRDImageJob::set_frame_number(uint32_t number)
+    {
+        frame_number_ = number;
+    }
+
+    void LATRDImageJob::add_packet(uint32_t packet_id)
+    {
+      // Record the packet number, the set of bits grows to fit the largest packet ID
+      size_t word = packet_id >> 6;
+      if (word >= packet_bits_.size()){
+        packet_bits_.resize(word + 1, 0);
+      }
+      packet_bits_[word] |= (1ULL << (packet_id & 63));
+    }
+
+    void LATRDImageJob::add_pixel(uint32_t x, uint32_t y, uint32_t event_count)
     {
       // Calculate the data index
       uint32_t data_index = x + (y * width_);
-      // Record the event count into the correct pixel
-//      printf("Recording [%u] index [%u, %u] event count [%u]\n", packet_id, x, y, event_count);
-      image_ptr_[data_index] += (uint16_t)event_count;
-//      printf("image_ptr_[%u] = %u\n", data_index, image_ptr_[data_index]);
-      // Record the packet number
-      packet_ids_[packet_id] = 1;
+      // Record the event count into the correct pixel, bright pixels stop at the largest value
+      if (depth_ == 32){
+        saturating_add(((uint32_t *)image_ptr_)[data_index], event_count);
+      } else {
+        saturating_add(((uint16_t *)image_ptr_)[data_index], event_count);
+      }
     }
 
     bool LATRDImageJob::verify_image()
     {
-        bool verified = true;
-
-        // First check to see if we have received an EOI packet
-        if (eoi_packet_id_ == -1){
-            // We have not, so we are not verified
-            verified = false;
-        }
-        if (verified){
-          // Loop over the packet IDs and check there are no gaps
-          for (uint32_t index = 0; index < eoi_packet_id_; index++){
-            if (packet_ids_.count(index) == 0){
-              verified = false;
-              break;
-            }
-          }
-        }
-      return verified;
+      // First check to see if we have received an EOI packet
+      if (eoi_packet_id_ == -1){
+        // We have not, so we are not verified
+        return false;
+      }
+      // Every packet before the EOI packet must have been received, so count the bits below it
+      uint32_t required = (uint32_t)eoi_packet_id_;
+      uint32_t received = 0;
+      size_t full_words = required >> 6;
+      for (size_t word = 0; word < full_words && word < packet_bits_.size(); word++){
+        received += __builtin_popcountll(packet_bits_[word]);
+      }
+      if ((required & 63) != 0 && full_words < packet_bits_.size()){
+        uint64_t mask = (1ULL << (required & 63)) - 1;
+        received += __builtin_popcountll(packet_bits_[full_words] & mask);
+      }
+      return received == required;
     }
 
     boost::shared_ptr<Frame> LATRDImageJob::to_frame()
     {
       // Create the frame object to wrap the image
       boost::shared_ptr<Frame> out_frame = boost::shared_ptr<Frame>(new Frame("image"));
-      out_frame->copy_data(image_ptr_, width_ * height_ * sizeof(uint16_t));
+      out_frame->copy_data(image_ptr_, width_ * height_ * (depth_ / 8));
       out_frame->set_frame_number(frame_number_);
       std::vector<dimsize_t> dims(0);
       dims.push_back(height_);
       dims.push_back(width_);
       out_frame->set_dataset_name("image");
-      out_frame->set_data_type(1);
+      // Data type 1 is 16 bit and 2 is 32 bit unsigned
+      out_frame->set_data_type(depth_ == 32 ? 2 : 1);
       out_frame->set_dimensions(dims);
       return out_frame;
     }
@@ -82,11 +127,11 @@ namespace FrameProcessor {
     void LATRDImageJob::reset()
     {
       // We need to reset the memory block
-      memset(image_ptr_, 0, (width_ * height_ * sizeof(uint16_t)));
+      memset(image_ptr_, 0, width_ * height_ * (depth_ / 8));
       // Reset the largest_packet_id
       eoi_packet_id_ = -1;
-      // Reset the packet id map
-      packet_ids_.clear();
+      // Reset the packet bits, keeping their storage
+      std::fill(packet_bits_.begin(), packet_bits_.end(), 0);
       // Reset the sent flag
       sent_ = false;
     }
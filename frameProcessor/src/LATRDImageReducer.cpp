@@ -0,0 +1,128 @@
+#include <string.h>
+
+#include "LATRDImageReducer.h"
+#include "LATRDImageJob.h"
+#include "LATRDExceptions.h"
+
+namespace FrameProcessor {
+
+  LATRDImageReducer::LATRDImageReducer(uint32_t width, uint32_t height, uint32_t depth,
+                                       uint32_t sum_images, uint32_t bin, uint64_t live_interval) :
+      width_(width),
+      height_(height),
+      depth_(depth),
+      sum_images_(sum_images),
+      bin_(bin),
+      summed_(0),
+      sums_emitted_(0),
+      live_interval_(live_interval),
+      last_live_(0),
+      live_started_(false)
+  {
+    if (depth_ != 16 && depth_ != 32){
+      throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+    }
+    if (bin_ != 1 && bin_ != 2 && bin_ != 4){
+      throw LATRDProcessingException("Image binning must be 1, 2 or 4");
+    }
+    // Pixels left over at the edges of the sensor fall into a partial bin
+    binned_width_ = (width_ + bin_ - 1) / bin_;
+    binned_height_ = (height_ + bin_ - 1) / bin_;
+    if (sum_images_ > 0){
+      sum_.assign((size_t)binned_width_ * binned_height_, 0);
+    }
+    live_.assign((size_t)binned_width_ * binned_height_, 0);
+  }
+
+  LATRDImageReducer::~LATRDImageReducer()
+  {
+  }
+
+  std::vector<boost::shared_ptr<Frame> > LATRDImageReducer::add_image(const void *image, uint32_t image_number, uint64_t now)
+  {
+    std::vector<boost::shared_ptr<Frame> > frames;
+    if (sum_images_ > 0){
+      if (depth_ == 32){
+        this->bin_image((const uint32_t *)image, &sum_[0]);
+      } else {
+        this->bin_image((const uint16_t *)image, &sum_[0]);
+      }
+      summed_++;
+      if (summed_ == sum_images_){
+        frames = this->flush();
+      }
+    }
+    // The first image is always shown, then at most one image for each interval
+    if (live_interval_ > 0 && (!live_started_ || now - last_live_ >= live_interval_)){
+      memset(&live_[0], 0, live_.size() * sizeof(uint32_t));
+      if (depth_ == 32){
+        this->bin_image((const uint32_t *)image, &live_[0]);
+      } else {
+        this->bin_image((const uint16_t *)image, &live_[0]);
+      }
+      frames.push_back(this->create_frame(live_, "image_live", image_number));
+      last_live_ = now;
+      live_started_ = true;
+    }
+    return frames;
+  }
+
+  std::vector<boost::shared_ptr<Frame> > LATRDImageReducer::flush()
+  {
+    // A partial sum is emitted at the end of an acquisition, and the next sum starts afresh
+    std::vector<boost::shared_ptr<Frame> > frames;
+    if (summed_ > 0){
+      frames.push_back(this->create_frame(sum_, "image_sum", (uint32_t)sums_emitted_));
+      sums_emitted_++;
+      memset(&sum_[0], 0, sum_.size() * sizeof(uint32_t));
+      summed_ = 0;
+    }
+    return frames;
+  }
+
+  uint32_t LATRDImageReducer::binned_width()
+  {
+    return binned_width_;
+  }
+
+  uint32_t LATRDImageReducer::binned_height()
+  {
+    return binned_height_;
+  }
+
+  template <typename T> void LATRDImageReducer::bin_image(const T *image, uint32_t *output)
+  {
+    for (uint32_t y = 0; y < height_; y++){
+      const T *row_ptr = image + ((size_t)y * width_);
+      uint32_t *out_ptr = output + ((size_t)(y / bin_) * binned_width_);
+      if (bin_ == 1){
+        for (uint32_t x = 0; x < width_; x++){
+          saturating_add(out_ptr[x], row_ptr[x]);
+        }
+      } else {
+        // Bins are powers of two so the output column is a shift
+        uint32_t shift = (bin_ == 2) ? 1 : 2;
+        for (uint32_t x = 0; x < width_; x++){
+          saturating_add(out_ptr[x >> shift], row_ptr[x]);
+        }
+      }
+    }
+  }
+
+  boost::shared_ptr<Frame> LATRDImageReducer::create_frame(const std::vector<uint32_t>& image,
+                                                           const std::string& name,
+                                                           uint32_t number)
+  {
+    boost::shared_ptr<Frame> frame = boost::shared_ptr<Frame>(new Frame(name));
+    frame->copy_data(&image[0], image.size() * sizeof(uint32_t));
+    frame->set_frame_number(number);
+    std::vector<dimsize_t> dims(0);
+    dims.push_back(binned_height_);
+    dims.push_back(binned_width_);
+    frame->set_dataset_name(name);
+    frame->set_data_type(2);
+    frame->set_dimensions(dims);
+    return frame;
+  }
+
+}
@@ -0,0 +1,42 @@
+#include "LATRDJobArena.h"
+
+namespace FrameProcessor {
+
+  LATRDJobArena::LATRDJobArena(size_t jobs, size_t job_size, bool huge_pages) :
+      jobs_(jobs),
+      job_size_(job_size),
+      job_stride_(LATRDProcessJob::storage_size(job_size)),
+      block_(jobs * LATRDProcessJob::storage_size(job_size), huge_pages, job_array_alignment)
+  {
+  }
+
+  LATRDJobArena::~LATRDJobArena()
+  {
+  }
+
+  size_t LATRDJobArena::jobs()
+  {
+    return jobs_;
+  }
+
+  size_t LATRDJobArena::bytes()
+  {
+    return block_.bytes();
+  }
+
+  bool LATRDJobArena::huge_pages()
+  {
+    return block_.huge_pages();
+  }
+
+  std::vector<boost::shared_ptr<LATRDProcessJob> > LATRDJobArena::create_jobs()
+  {
+    std::vector<boost::shared_ptr<LATRDProcessJob> > jobs;
+    uint8_t *base = (uint8_t *)block_.data();
+    for (size_t index = 0; index < jobs_; index++){
+      jobs.push_back(boost::shared_ptr<LATRDProcessJob>(new LATRDProcessJob(job_size_, base + (index * job_stride_))));
+    }
+    return jobs;
+  }
+
+}
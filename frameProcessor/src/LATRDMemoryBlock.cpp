@@ -0,0 +1,69 @@
+#include <string.h>
+#include <sys/mman.h>
+
+#include "LATRDExceptions.h"
+#include "LATRDMemoryBlock.h"
+
+namespace FrameProcessor {
+
+  LATRDMemoryBlock::LATRDMemoryBlock(size_t bytes, bool huge_pages, size_t alignment) :
+      data_(0),
+      bytes_(bytes),
+      mapped_(false),
+      huge_pages_(false)
+  {
+    if (huge_pages){
+      // Explicit huge pages must be reserved by the system, so try those first
+      size_t huge_bytes = ((bytes_ + huge_page_size - 1) / huge_page_size) * huge_page_size;
+      void *block = mmap(0, huge_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (block != MAP_FAILED){
+        data_ = block;
+        bytes_ = huge_bytes;
+        mapped_ = true;
+        huge_pages_ = true;
+      }
+    }
+    if (!data_){
+      // Otherwise align the block to a huge page so that transparent huge pages can be used
+      if (huge_pages && alignment < huge_page_size){
+        alignment = huge_page_size;
+      }
+      if (posix_memalign(&data_, alignment, bytes_) != 0){
+        data_ = 0;
+        throw LATRDProcessingException("Unable to allocate memory block");
+      }
+      if (huge_pages){
+        // The kernel may or may not back the block with huge pages, so they are
+        // only requested here and not reported by huge_pages()
+        madvise(data_, bytes_, MADV_HUGEPAGE);
+      }
+    }
+    // Fault every page in now rather than while processing
+    memset(data_, 0, bytes_);
+  }
+
+  LATRDMemoryBlock::~LATRDMemoryBlock()
+  {
+    if (mapped_){
+      munmap(data_, bytes_);
+    } else {
+      free(data_);
+    }
+  }
+
+  void *LATRDMemoryBlock::data()
+  {
+    return data_;
+  }
+
+  size_t LATRDMemoryBlock::bytes()
+  {
+    return bytes_;
+  }
+
+  bool LATRDMemoryBlock::huge_pages()
+  {
+    return huge_pages_;
+  }
+
+}
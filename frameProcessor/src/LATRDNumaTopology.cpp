@@ -0,0 +1,118 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <fstream>
+#include <sstream>
+
+#include "LATRDNumaTopology.h"
+
+namespace FrameProcessor {
+
+  /** get_mempolicy flags to return the node of the page at an address */
+  static const unsigned long numa_policy_node = 1;
+  static const unsigned long numa_policy_address = 2;
+
+  LATRDNumaTopology::LATRDNumaTopology()
+  {
+    this->load(numa_sysfs_root);
+  }
+
+  LATRDNumaTopology::LATRDNumaTopology(const std::string& sysfs_root)
+  {
+    this->load(sysfs_root);
+  }
+
+  LATRDNumaTopology::~LATRDNumaTopology()
+  {
+  }
+
+  void LATRDNumaTopology::load(const std::string& sysfs_root)
+  {
+    // Nodes are numbered contiguously from zero, each has a list of its CPUs
+    cpus_.clear();
+    for (size_t node = 0; ; node++){
+      std::stringstream path;
+      path << sysfs_root << "/node" << node << "/cpulist";
+      std::ifstream file(path.str().c_str());
+      if (!file.is_open()){
+        break;
+      }
+      std::string list;
+      std::getline(file, list);
+      cpus_.push_back(parse_cpu_list(list));
+    }
+    if (cpus_.empty()){
+      cpus_.push_back(std::vector<int>());
+    }
+  }
+
+  size_t LATRDNumaTopology::nodes()
+  {
+    return cpus_.size();
+  }
+
+  std::vector<int> LATRDNumaTopology::cpus(size_t node)
+  {
+    return cpus_[node % cpus_.size()];
+  }
+
+  bool LATRDNumaTopology::bind_thread(size_t node, cpu_set_t *previous)
+  {
+    // The previous affinity is recorded so that temporary binding can be undone
+    if (previous){
+      CPU_ZERO(previous);
+      pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), previous);
+    }
+    std::vector<int> node_cpus = this->cpus(node);
+    if (node_cpus.empty()){
+      return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (size_t index = 0; index < node_cpus.size(); index++){
+      if (node_cpus[index] < CPU_SETSIZE){
+        CPU_SET(node_cpus[index], &cpu_set);
+      }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+  }
+
+  void LATRDNumaTopology::restore_thread(const cpu_set_t *previous)
+  {
+    if (previous && CPU_COUNT(previous) > 0){
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), previous);
+    }
+  }
+
+  int LATRDNumaTopology::node_of(const void *ptr)
+  {
+    // Returns -1 if the page is not yet placed or the kernel has no NUMA support
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, (unsigned long *)0, 0UL, ptr, numa_policy_node | numa_policy_address) != 0){
+      return -1;
+    }
+    return node;
+  }
+
+  std::vector<int> LATRDNumaTopology::parse_cpu_list(const std::string& list)
+  {
+    // Lists are comma separated CPUs or ranges of CPUs, for example "0-7,16-23"
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')){
+      int first = 0;
+      int last = 0;
+      if (sscanf(item.c_str(), "%d-%d", &first, &last) == 2){
+        for (int cpu = first; cpu <= last; cpu++){
+          cpus.push_back(cpu);
+        }
+      } else if (sscanf(item.c_str(), "%d", &first) == 1){
+        cpus.push_back(first);
+      }
+    }
+    return cpus;
+  }
+
+}
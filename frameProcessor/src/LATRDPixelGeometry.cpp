@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "LATRDDefinitions.h"
+#include "LATRDPixelGeometry.h"
+
+namespace FrameProcessor {
+
+  LATRDPixelGeometry::LATRDPixelGeometry(uint32_t width, uint32_t height, LATRDGeometryOutput output) :
+      width_(width),
+      height_(height),
+      output_(output),
+      raw_width_(0),
+      raw_height_(0)
+  {
+    if (output_ == GEOMETRY_XY && (width_ > unmapped_pixel_coordinate || height_ > unmapped_pixel_coordinate)){
+      throw LATRDProcessingException("Image is too large for 16 bit pixel coordinates");
+    }
+    if (width_ > (LATRD::position_mask >> LATRD::position_x_shift) + 1 || height_ > LATRD::position_y_mask + 1){
+      throw LATRDProcessingException("Image is too large for image position IDs");
+    }
+  }
+
+  LATRDPixelGeometry::~LATRDPixelGeometry()
+  {
+  }
+
+  void LATRDPixelGeometry::add_chip(uint32_t raw_x,
+                                    uint32_t raw_y,
+                                    uint32_t chip_width,
+                                    uint32_t chip_height,
+                                    uint32_t x,
+                                    uint32_t y,
+                                    uint32_t rotation)
+  {
+    if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270){
+      throw LATRDProcessingException("Chip rotation must be one of 0, 90, 180 or 270 degrees");
+    }
+    if (raw_x + chip_width > (LATRD::position_mask >> LATRD::position_x_shift) + 1 ||
+        raw_y + chip_height > LATRD::position_y_mask + 1){
+      throw LATRDProcessingException("Chip raw coordinates are outside of the position ID range");
+    }
+    // Rotating by 90 or 270 degrees swaps the size of the chip within the image
+    bool swapped = (rotation == 90 || rotation == 270);
+    uint32_t placed_width = swapped ? chip_height : chip_width;
+    uint32_t placed_height = swapped ? chip_width : chip_height;
+    if (x + placed_width > width_ || y + placed_height > height_){
+      throw LATRDProcessingException("Chip is placed outside of the sensor image");
+    }
+    Chip chip = {raw_x, raw_y, chip_width, chip_height, x, y, rotation};
+    chips_.push_back(chip);
+  }
+
+  void LATRDPixelGeometry::load_layout(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str());
+    if (!file){
+      throw LATRDProcessingException("Unable to open module layout file " + filename);
+    }
+    std::string line;
+    while (std::getline(file, line)){
+      if (line.empty() || line[0] == '#'){
+        continue;
+      }
+      std::istringstream fields(line);
+      uint32_t raw_x, raw_y, chip_width, chip_height, x, y, rotation;
+      if (!(fields >> raw_x >> raw_y >> chip_width >> chip_height >> x >> y >> rotation)){
+        throw LATRDProcessingException("Invalid chip definition in module layout file " + filename + ": " + line);
+      }
+      this->add_chip(raw_x, raw_y, chip_width, chip_height, x, y, rotation);
+    }
+    this->build();
+  }
+
+  void LATRDPixelGeometry::build()
+  {
+    raw_width_ = 0;
+    raw_height_ = 0;
+    std::vector<Chip>::iterator chip;
+    for (chip = chips_.begin(); chip != chips_.end(); ++chip){
+      raw_width_ = std::max(raw_width_, chip->raw_x + chip->width);
+      raw_height_ = std::max(raw_height_, chip->raw_y + chip->height);
+    }
+    index_table_.assign((size_t)raw_width_ * raw_height_, unmapped_pixel_index);
+    xy_table_.assign((size_t)raw_width_ * raw_height_,
+                     ((uint32_t)unmapped_pixel_coordinate << 16) | unmapped_pixel_coordinate);
+    id_table_.assign((size_t)raw_width_ * raw_height_, unmapped_position_id);
+    for (chip = chips_.begin(); chip != chips_.end(); ++chip){
+      for (uint32_t u = 0; u < chip->width; u++){
+        for (uint32_t v = 0; v < chip->height; v++){
+          // Position of the pixel within the chip after rotating clockwise
+          uint32_t px = u;
+          uint32_t py = v;
+          if (chip->rotation == 90){
+            px = chip->height - 1 - v;
+            py = u;
+          } else if (chip->rotation == 180){
+            px = chip->width - 1 - u;
+            py = chip->height - 1 - v;
+          } else if (chip->rotation == 270){
+            px = v;
+            py = chip->width - 1 - u;
+          }
+          uint32_t x = chip->x + px;
+          uint32_t y = chip->y + py;
+          size_t entry = ((size_t)(chip->raw_x + u) * raw_height_) + chip->raw_y + v;
+          index_table_[entry] = (y * width_) + x;
+          xy_table_[entry] = (x << 16) | y;
+          id_table_[entry] = (x << LATRD::position_x_shift) | y;
+        }
+      }
+    }
+  }
+
+  LATRDGeometryOutput LATRDPixelGeometry::output()
+  {
+    return output_;
+  }
+
+  uint32_t LATRDPixelGeometry::map_index(uint32_t position_id)
+  {
+    uint32_t entry = this->lookup(position_id);
+    return entry == unmapped_pixel_index ? unmapped_pixel_index : index_table_[entry];
+  }
+
+  void LATRDPixelGeometry::map_indexes(const uint32_t *position_id, uint32_t *index, uint16_t qty_events)
+  {
+    for (uint16_t event = 0; event < qty_events; event++){
+      index[event] = this->map_index(position_id[event]);
+    }
+  }
+
+  void LATRDPixelGeometry::map_coordinates(const uint32_t *position_id, uint16_t *x, uint16_t *y, uint16_t qty_events)
+  {
+    for (uint16_t event = 0; event < qty_events; event++){
+      uint32_t entry = this->lookup(position_id[event]);
+      uint32_t xy = entry == unmapped_pixel_index ? 0xFFFFFFFF : xy_table_[entry];
+      x[event] = (uint16_t)(xy >> 16);
+      y[event] = (uint16_t)(xy & 0xFFFF);
+    }
+  }
+
+  void LATRDPixelGeometry::map_positions(const uint32_t *position_id, uint32_t *image_id, uint16_t qty_events)
+  {
+    for (uint16_t event = 0; event < qty_events; event++){
+      uint32_t entry = this->lookup(position_id[event]);
+      image_id[event] = entry == unmapped_pixel_index ? unmapped_position_id : id_table_[entry];
+    }
+  }
+
+  uint32_t LATRDPixelGeometry::lookup(uint32_t position_id)
+  {
+    // Position IDs outside of the raw extent of the layout have no table entry
+    uint32_t raw_x = LATRD::get_position_x(position_id);
+    uint32_t raw_y = LATRD::get_position_y(position_id);
+    if (raw_x >= raw_width_ || raw_y >= raw_height_){
+      return unmapped_pixel_index;
+    }
+    return (raw_x * raw_height_) + raw_y;
+  }
+
+}
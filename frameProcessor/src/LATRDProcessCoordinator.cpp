@@ -10,13 +10,38 @@ namespace FrameProcessor {
 static int no_of_job = 0;
     LATRDProcessCoordinator::LATRDProcessCoordinator() :
     rank_(0),
+    processes_(1),
+    compression_(NO_COMPRESSION),
+    compression_delta_(false),
+    event_format_(COLUMN_EVENT_FORMAT),
+    job_pool_size_(0),
+    pool_exhausted_(0),
+    forced_releases_(0),
+    pool_dropped_packets_(0),
+    huge_pages_(false),
+    numa_enabled_(false),
+    numa_groups_(1),
+    numa_local_jobs_(0),
+    numa_remote_jobs_(0),
     current_ts_wrap_(0),
     current_ts_buffer_(0),
+    last_written_ts_index_(0),
+    frame_ts_min_(empty_ts_min),
+    frame_ts_max_(0),
+    histograms_enabled_(false),
+    histogram_modules_(false),
+    histogram_cadence_(1),
+    histogram_collections_(0),
+    clusters_(0),
+    metaPtr_(0),
     processed_jobs_(0),
     processed_frames_(0),
     output_frames_(0),
-    last_written_ts_index_(0),
-    metaPtr_(0)
+    energy_rejects_(0),
+    roi_rejects_(0),
+    mask_rejects_(0),
+    compression_failures_(0),
+    energy_data_type_(2)
     {
         // Setup logging for the class
         logger_ = Logger::getLogger("FP.LATRDProcessCoordinator");
@@ -24,21 +49,45 @@ static int no_of_job = 0;
         LOG4CXX_TRACE(logger_, "LATRDProcessCoordinator constructor.");
 
         // Create the work queue for processing jobs
-        jobQueue_ = boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > >(new WorkQueue<boost::shared_ptr<LATRDProcessJob> >);
+        jobQueues_.push_back(boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > >(new WorkQueue<boost::shared_ptr<LATRDProcessJob> >));
         // Create the work queue for completed jobs
         resultsQueue_ = boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > >(new WorkQueue<boost::shared_ptr<LATRDProcessJob> >);
 
         // Create a stack of process job objects ready to work
-        for (int index = 0; index < LATRD::num_primary_packets*2; index++){
-            jobStack_.push(boost::shared_ptr<LATRDProcessJob>(new LATRDProcessJob(LATRD::primary_packet_size/sizeof(uint64_t))));
-        }
+        this->configure_job_pool(LATRD::num_primary_packets*2);
 
         // Create the buffer managers
         timeStampBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_time_offset", UINT64_TYPE));
         idBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_id", UINT32_TYPE));
         energyBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_energy", UINT32_TYPE));
+        xBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_x", UINT16_TYPE));
+        yBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_y", UINT16_TYPE));
         ctrlWordBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cue_id", UINT16_TYPE));
         ctrlTimeStampBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cue_timestamp_zero", UINT64_TYPE));
+        // Packed records must not be split across frames so the buffer holds a whole number of records
+        packedBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer((LATRD::frame_size / packed_event_words) * packed_event_words, "event_packed", UINT32_TYPE));
+        varintBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size * sizeof(uint64_t), "event_varint", UINT8_TYPE));
+        cueIndexBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cue_event_index", UINT64_TYPE));
+        // Events within a varint block cannot be addressed, so control words index the byte offset of the block instead
+        cueOffsetBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cue_byte_offset", UINT64_TYPE));
+        // Float cluster values are stored in 32 bit buffers
+        clusterTimeBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cluster_time", UINT64_TYPE));
+        clusterXBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cluster_x", UINT32_TYPE));
+        clusterYBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cluster_y", UINT32_TYPE));
+        clusterEnergyBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cluster_energy", UINT32_TYPE));
+        clusterSizeBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "cluster_size", UINT16_TYPE));
+        // Column buffers fill in step so share the frame numbers of their first column
+        idBuffer_->followFrameNumbers(timeStampBuffer_);
+        energyBuffer_->followFrameNumbers(timeStampBuffer_);
+        xBuffer_->followFrameNumbers(timeStampBuffer_);
+        yBuffer_->followFrameNumbers(timeStampBuffer_);
+        ctrlWordBuffer_->followFrameNumbers(ctrlTimeStampBuffer_);
+        cueIndexBuffer_->followFrameNumbers(ctrlTimeStampBuffer_);
+        cueOffsetBuffer_->followFrameNumbers(ctrlTimeStampBuffer_);
+        clusterXBuffer_->followFrameNumbers(clusterTimeBuffer_);
+        clusterYBuffer_->followFrameNumbers(clusterTimeBuffer_);
+        clusterEnergyBuffer_->followFrameNumbers(clusterTimeBuffer_);
+        clusterSizeBuffer_->followFrameNumbers(clusterTimeBuffer_);
 
         // Initialise the ts index vector
         ts_index_array_.assign(LATRD::time_slice_write_size * LATRD::number_of_time_slice_buffers, 0);
@@ -46,8 +95,12 @@ static int no_of_job = 0;
         // Configure threads for processing
         // Now start the worker thread to monitor the queue
         for (size_t index = 0; index < LATRD::number_of_processing_threads; index++){
-            thread_[index] = new boost::thread(&LATRDProcessCoordinator::processTask, this);
+            histograms_.push_back(boost::shared_ptr<LATRDHistogramExchange>(new LATRDHistogramExchange()));
         }
+        this->start_workers();
+
+        // Create the pool of threads used for processing complete output frames
+        taskPool_ = boost::shared_ptr<LATRDTaskPool>(new LATRDTaskPool(LATRD::number_of_processing_threads));
     }
 
     void LATRDProcessCoordinator::get_statistics(uint32_t *processed_jobs,
@@ -57,7 +110,10 @@ static int no_of_job = 0;
                                                  uint32_t *output_frames)
     {
         *processed_jobs = processed_jobs_;
-        *job_q_size = jobQueue_->size();
+        *job_q_size = 0;
+        for (size_t group = 0; group < jobQueues_.size(); group++) {
+            *job_q_size += jobQueues_[group]->size();
+        }
         *result_q_size = resultsQueue_->size();
         *processed_frames = processed_frames_;
         *output_frames = output_frames_;
@@ -73,23 +129,625 @@ static int no_of_job = 0;
         processed_jobs_ = 0;
         processed_frames_ = 0;
         output_frames_ = 0;
+        energy_rejects_ = 0;
+        roi_rejects_ = 0;
+        mask_rejects_ = 0;
+        compression_failures_ = 0;
+        numa_local_jobs_ = 0;
+        numa_remote_jobs_ = 0;
+    }
+
+    void LATRDProcessCoordinator::get_filter_statistics(uint64_t *energy_rejects,
+                                                        uint64_t *roi_rejects,
+                                                        uint64_t *mask_rejects)
+    {
+        *energy_rejects = energy_rejects_;
+        *roi_rejects = roi_rejects_;
+        *mask_rejects = mask_rejects_;
+    }
+
+    void LATRDProcessCoordinator::configure_filter(boost::shared_ptr<LATRDEventFilter> filter)
+    {
+        // Workers take a reference to the filter for each job, so a filter that does nothing is dropped
+        boost::lock_guard<boost::mutex> lock(filter_mutex_);
+        filter_.reset();
+        if (filter && filter->enabled()) {
+            filter_ = filter;
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_geometry(boost::shared_ptr<LATRDPixelGeometry> geometry)
+    {
+        // The geometry should only be changed between acquisitions, as the datasets
+        // written for each event depend upon the geometry output
+        boost::lock_guard<boost::mutex> lock(geometry_mutex_);
+        geometry_.reset();
+        if (geometry && geometry->output() != NO_GEOMETRY) {
+            geometry_ = geometry;
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_calibration(boost::shared_ptr<LATRDEnergyCalibration> calibration)
+    {
+        // Calibration fixes the type of the energy dataset, so every energy of the previous type must have
+        // been written out before it is changed
+        if (free_jobs() != job_pool_size_ || !ts_store_.empty() || energyBuffer_->remaining() != LATRD::frame_size) {
+            throw LATRDProcessingException("Energy calibration cannot be changed while events are held");
+        }
+        boost::lock_guard<boost::mutex> lock(calibration_mutex_);
+        calibration_.reset();
+        if (calibration && calibration->output() != RAW_ENERGY) {
+            calibration_ = calibration;
+        }
+        energy_data_type_ = (calibration_ && calibration_->output() == FLOAT_ENERGY) ? 4 : 2;
     }
 
     LATRDProcessCoordinator::~LATRDProcessCoordinator()
     {
+        this->stop_workers();
+        this->release_frame_counter();
+    }
+
+    void LATRDProcessCoordinator::start_workers()
+    {
+        // Worker threads are shared out between the groups in turn
+        for (size_t index = 0; index < LATRD::number_of_processing_threads; index++){
+            thread_[index] = new boost::thread(&LATRDProcessCoordinator::processTask, this, index);
+        }
+    }
+
+    void LATRDProcessCoordinator::stop_workers()
+    {
+        // An empty job stops the worker that takes it, so each queue receives one for each of its workers
+        for (size_t index = 0; index < LATRD::number_of_processing_threads; index++){
+            jobQueues_[index % numa_groups_]->add(boost::shared_ptr<LATRDProcessJob>(), true);
+        }
+        for (size_t index = 0; index < LATRD::number_of_processing_threads; index++){
+            thread_[index]->join();
+            delete thread_[index];
+            thread_[index] = 0;
+        }
+    }
 
+    void LATRDProcessCoordinator::configure_numa(bool enable)
+    {
+        // Workers are restarted with the new groups, so this can only be done when every job is idle
+        if (free_jobs() != job_pool_size_) {
+            throw LATRDProcessingException("NUMA placement cannot be changed while jobs are in use");
+        }
+        this->stop_workers();
+        numa_enabled_ = enable;
+        numa_groups_ = 1;
+        if (numa_enabled_) {
+            numa_groups_ = std::min(numa_.nodes(), (size_t)LATRD::number_of_processing_threads);
+        }
+        jobQueues_.clear();
+        for (size_t group = 0; group < numa_groups_; group++) {
+            jobQueues_.push_back(boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > >(new WorkQueue<boost::shared_ptr<LATRDProcessJob> >));
+        }
+        this->configure_job_pool(job_pool_size_);
+        this->start_workers();
+        LOG4CXX_DEBUG_LEVEL(1, logger_, "NUMA placement " << (numa_enabled_ ? "enabled" : "disabled")
+                                        << " with " << numa_groups_ << " worker groups");
+    }
+
+    boost::shared_ptr<LATRDTaskPool> LATRDProcessCoordinator::get_task_pool()
+    {
+        return taskPool_;
+    }
+
+    void LATRDProcessCoordinator::get_numa_statistics(uint32_t *groups, uint64_t *local_jobs, uint64_t *remote_jobs)
+    {
+        *groups = numa_groups_;
+        *local_jobs = numa_local_jobs_;
+        *remote_jobs = numa_remote_jobs_;
+    }
+
+    void LATRDProcessCoordinator::configure_job_pool(size_t jobs)
+    {
+        // Jobs hold pointers into the arena so it can only be replaced when every job is idle
+        if (jobs < (size_t)LATRD::num_primary_packets) {
+            throw LATRDProcessingException("Job pool must hold at least one frame of packets");
+        }
+        if (free_jobs() != job_pool_size_) {
+            throw LATRDProcessingException("Job pool cannot be resized while jobs are in use");
+        }
+        jobStacks_.clear();
+        arenas_.clear();
+        jobStacks_.resize(numa_groups_);
+        size_t bytes = 0;
+        for (size_t group = 0; group < numa_groups_; group++) {
+            // The pool is split between the groups, each part is first touched by a thread on its node
+            size_t group_jobs = (jobs / numa_groups_) + (group < (jobs % numa_groups_) ? 1 : 0);
+            cpu_set_t previous;
+            if (numa_enabled_) {
+                numa_.bind_thread(group, &previous);
+            }
+            boost::shared_ptr<LATRDJobArena> arena(new LATRDJobArena(group_jobs, LATRD::primary_packet_size/sizeof(uint64_t), huge_pages_));
+            if (numa_enabled_) {
+                numa_.restore_thread(&previous);
+            }
+            std::vector<boost::shared_ptr<LATRDProcessJob> > pool = arena->create_jobs();
+            std::vector<boost::shared_ptr<LATRDProcessJob> >::iterator iter;
+            for (iter = pool.begin(); iter != pool.end(); ++iter) {
+                (*iter)->pool_group = (uint8_t)group;
+                jobStacks_[group].push(*iter);
+            }
+            arenas_.push_back(arena);
+            bytes += arena->bytes();
+        }
+        job_pool_size_ = jobs;
+        LOG4CXX_DEBUG_LEVEL(1, logger_, "Job pool of " << jobs << " jobs in " << numa_groups_ << " groups using "
+                                        << bytes << " bytes" << (arenas_[0]->huge_pages() ? " of huge pages" :
+                                                                 (huge_pages_ ? " with huge pages requested" : "")));
+    }
+
+    void LATRDProcessCoordinator::configure_huge_pages(bool huge_pages)
+    {
+        // All memory is allocated and faulted in here so that no page faults occur
+        // while processing.  Buffers holding data cannot be reallocated.
+        if (huge_pages == huge_pages_) {
+            return;
+        }
+        if (free_jobs() != job_pool_size_) {
+            throw LATRDProcessingException("Huge pages cannot be changed while jobs are in use");
+        }
+        huge_pages_ = huge_pages;
+        configure_job_pool(job_pool_size_);
+        timeStampBuffer_->allocate(huge_pages_);
+        idBuffer_->allocate(huge_pages_);
+        energyBuffer_->allocate(huge_pages_);
+        xBuffer_->allocate(huge_pages_);
+        yBuffer_->allocate(huge_pages_);
+        ctrlWordBuffer_->allocate(huge_pages_);
+        ctrlTimeStampBuffer_->allocate(huge_pages_);
+        packedBuffer_->allocate(huge_pages_);
+        varintBuffer_->allocate(huge_pages_);
+        cueIndexBuffer_->allocate(huge_pages_);
+        cueOffsetBuffer_->allocate(huge_pages_);
+        clusterTimeBuffer_->allocate(huge_pages_);
+        clusterXBuffer_->allocate(huge_pages_);
+        clusterYBuffer_->allocate(huge_pages_);
+        clusterEnergyBuffer_->allocate(huge_pages_);
+        clusterSizeBuffer_->allocate(huge_pages_);
+        LOG4CXX_DEBUG_LEVEL(1, logger_, "Output buffers allocated " << (timeStampBuffer_->hugePages() ? "with huge pages" :
+                                        (huge_pages_ ? "with huge pages requested" : "without huge pages")));
+    }
+
+    void LATRDProcessCoordinator::get_job_pool_statistics(uint32_t *size,
+                                                          uint32_t *free_jobs,
+                                                          uint64_t *exhausted,
+                                                          uint64_t *forced_releases,
+                                                          uint64_t *dropped_packets)
+    {
+        *size = job_pool_size_;
+        *free_jobs = this->free_jobs();
+        *exhausted = pool_exhausted_;
+        *forced_releases = forced_releases_;
+        *dropped_packets = pool_dropped_packets_;
     }
 
     void LATRDProcessCoordinator::configure_process(size_t processes, size_t rank)
     {
         // Record the rank
         rank_ = rank;
+        processes_ = processes;
+        {
+            boost::lock_guard<boost::mutex> lock(binner_mutex_);
+            if (binner_) {
+                binner_->configure_process(processes, rank);
+            }
+        }
         // Configure each of the buffer objects
         timeStampBuffer_->configureProcess(processes, rank);
         idBuffer_->configureProcess(processes, rank);
         energyBuffer_->configureProcess(processes, rank);
+        xBuffer_->configureProcess(processes, rank);
+        yBuffer_->configureProcess(processes, rank);
         ctrlWordBuffer_->configureProcess(processes, rank);
         ctrlTimeStampBuffer_->configureProcess(processes, rank);
+        packedBuffer_->configureProcess(processes, rank);
+        varintBuffer_->configureProcess(processes, rank);
+        cueIndexBuffer_->configureProcess(processes, rank);
+        cueOffsetBuffer_->configureProcess(processes, rank);
+        clusterTimeBuffer_->configureProcess(processes, rank);
+        clusterXBuffer_->configureProcess(processes, rank);
+        clusterYBuffer_->configureProcess(processes, rank);
+        clusterEnergyBuffer_->configureProcess(processes, rank);
+        clusterSizeBuffer_->configureProcess(processes, rank);
+    }
+
+    void LATRDProcessCoordinator::configure_event_format(LATRDEventFormat format)
+    {
+        event_format_ = format;
+    }
+
+    void LATRDProcessCoordinator::configure_frame_counter(const std::string& name)
+    {
+        // Every rank already shares the segment, reopening it could split the ranks between an old and a new one
+        if (frameCounter_ && !name.empty() && frameCounter_->name() == LATRDFrameCounter::segment_name(name)) {
+            return;
+        }
+        // An empty name returns to frame numbers calculated from the process rank
+        this->release_frame_counter();
+        if (!name.empty()) {
+            frameCounter_ = boost::shared_ptr<LATRDFrameCounter>(new LATRDFrameCounter(name));
+        }
+        timeStampBuffer_->setFrameCounter(frameCounter_, EVENT_FRAME_SLOT);
+        packedBuffer_->setFrameCounter(frameCounter_, EVENT_FRAME_SLOT);
+        varintBuffer_->setFrameCounter(frameCounter_, EVENT_FRAME_SLOT);
+        ctrlTimeStampBuffer_->setFrameCounter(frameCounter_, CUE_FRAME_SLOT);
+        clusterTimeBuffer_->setFrameCounter(frameCounter_, CLUSTER_FRAME_SLOT);
+    }
+
+    boost::shared_ptr<LATRDFrameCounter> LATRDProcessCoordinator::get_frame_counter()
+    {
+        return frameCounter_;
+    }
+
+    void LATRDProcessCoordinator::reset_frame_counter()
+    {
+        // Other ranks may already have claimed numbers from the shared counter, so only
+        // rank 0 resets it, before the ranks start a new acquisition
+        if (frameCounter_ && rank_ == 0) {
+            frameCounter_->reset();
+        }
+    }
+
+    void LATRDProcessCoordinator::release_frame_counter()
+    {
+        if (frameCounter_) {
+            // Rank 0 removes the segment so that stale counts are not picked up by the next acquisition
+            if (rank_ == 0) {
+                try {
+                    frameCounter_->unlink();
+                } catch (LATRDProcessingException& ex) {
+                    LOG4CXX_ERROR(logger_, ex.what());
+                }
+            }
+            frameCounter_.reset();
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_histograms(bool enable, bool modules, uint32_t cadence)
+    {
+        histogram_modules_ = modules;
+        histogram_cadence_ = cadence;
+        histograms_enabled_ = enable;
+    }
+
+    void LATRDProcessCoordinator::collect_histograms(bool publish)
+    {
+        if (histograms_enabled_) {
+            std::vector<boost::shared_ptr<LATRDHistogramExchange> >::iterator iter;
+            for (iter = histograms_.begin(); iter != histograms_.end(); ++iter) {
+                (*iter)->collect(histogram_total_);
+            }
+            histogram_collections_++;
+            if (histogram_collections_ >= histogram_cadence_) {
+                publish = true;
+            }
+        }
+        if (publish) {
+            if (!histogram_total_.empty()) {
+                this->publish_histogram_meta_data();
+            }
+            histogram_total_.clear();
+            histogram_collections_ = 0;
+        }
+    }
+
+    void LATRDProcessCoordinator::publish_histogram_meta_data()
+    {
+        if (metaPtr_){
+            rapidjson::Document meta_document;
+            meta_document.SetObject();
+
+            // Add rank
+            rapidjson::Value key_rank("rank", meta_document.GetAllocator());
+            rapidjson::Value value_rank;
+            value_rank.SetInt(rank_);
+            meta_document.AddMember(key_rank, value_rank, meta_document.GetAllocator());
+            // Add number of events
+            rapidjson::Value key_events("events", meta_document.GetAllocator());
+            rapidjson::Value value_events;
+            value_events.SetUint64(histogram_total_.events);
+            meta_document.AddMember(key_events, value_events, meta_document.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            meta_document.Accept(writer);
+
+            LOG4CXX_DEBUG_LEVEL(2, logger_, "Publishing histograms for " << histogram_total_.events << " events");
+            metaPtr_->publish_meta("latrd",
+                                   "energy_spectrum",
+                                   &histogram_total_.energy[0],
+                                   energy_spectrum_bins * sizeof(uint64_t),
+                                   buffer.GetString());
+
+            // Time slice counts are published as pairs of time slice ID and event count
+            std::vector<uint64_t> time_slices;
+            std::map<uint32_t, uint64_t>::iterator ts_iter;
+            for (ts_iter = histogram_total_.time_slices.begin(); ts_iter != histogram_total_.time_slices.end(); ++ts_iter) {
+                time_slices.push_back(ts_iter->first);
+                time_slices.push_back(ts_iter->second);
+            }
+            if (time_slices.size() > 0) {
+                metaPtr_->publish_meta("latrd",
+                                       "time_slice_events",
+                                       &time_slices[0],
+                                       time_slices.size() * sizeof(uint64_t),
+                                       buffer.GetString());
+            }
+
+            std::map<uint8_t, std::vector<uint64_t> >::iterator module_iter;
+            for (module_iter = histogram_total_.modules.begin(); module_iter != histogram_total_.modules.end(); ++module_iter) {
+                rapidjson::Document module_document;
+                module_document.SetObject();
+                rapidjson::Value key_module_rank("rank", module_document.GetAllocator());
+                rapidjson::Value value_module_rank;
+                value_module_rank.SetInt(rank_);
+                module_document.AddMember(key_module_rank, value_module_rank, module_document.GetAllocator());
+                rapidjson::Value key_module("module", module_document.GetAllocator());
+                rapidjson::Value value_module;
+                value_module.SetInt(module_iter->first);
+                module_document.AddMember(key_module, value_module, module_document.GetAllocator());
+
+                rapidjson::StringBuffer module_buffer;
+                rapidjson::Writer<rapidjson::StringBuffer> module_writer(module_buffer);
+                module_document.Accept(module_writer);
+
+                metaPtr_->publish_meta("latrd",
+                                       "module_spectrum",
+                                       &module_iter->second[0],
+                                       energy_spectrum_bins * sizeof(uint64_t),
+                                       module_buffer.GetString());
+            }
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_image_binning(bool enable, uint32_t width, uint32_t height, uint64_t bin_width)
+    {
+        // Images being built are held by the binner, so binning should only be changed between acquisitions
+        boost::shared_ptr<LATRDImageBinner> binner;
+        if (enable) {
+            binner = boost::shared_ptr<LATRDImageBinner>(new LATRDImageBinner(width, height, bin_width, taskPool_->size()));
+            binner->configure_process(processes_, rank_);
+        }
+        boost::lock_guard<boost::mutex> lock(binner_mutex_);
+        binner_ = binner;
+    }
+
+    uint64_t LATRDProcessCoordinator::get_image_late_events()
+    {
+        uint64_t late_events = 0;
+        boost::shared_ptr<LATRDImageBinner> binner;
+        {
+            boost::lock_guard<boost::mutex> lock(binner_mutex_);
+            binner = binner_;
+        }
+        if (binner) {
+            late_events = binner->late_events();
+        }
+        return late_events;
+    }
+
+    std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::bin_images(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs, bool purge)
+    {
+        std::vector<boost::shared_ptr<Frame> > frames;
+        boost::shared_ptr<LATRDImageBinner> binner;
+        boost::shared_ptr<LATRDRoiIntegrator> rois;
+        {
+            boost::lock_guard<boost::mutex> lock(binner_mutex_);
+            binner = binner_;
+            rois = rois_;
+        }
+        if (binner) {
+            // Share the released jobs between the pool threads, each binning into its own partial images
+            std::vector<boost::shared_ptr<LATRDTask> > tasks;
+            std::vector<boost::shared_ptr<LATRDImageBinTask> > bin_tasks;
+            for (size_t index = 0; index < binner->partitions(); index++) {
+                boost::shared_ptr<LATRDImageBinTask> task(new LATRDImageBinTask(binner.get(), index));
+                bin_tasks.push_back(task);
+                tasks.push_back(task);
+            }
+            uint64_t watermark = 0;
+            for (size_t index = 0; index < jobs.size(); index++) {
+                bin_tasks[index % bin_tasks.size()]->jobs.push_back(jobs[index]);
+                if (jobs[index]->valid_results > 0 && jobs[index]->ts_min > watermark) {
+                    watermark = jobs[index]->ts_min;
+                }
+            }
+            if (jobs.size() > 0) {
+                taskPool_->run(tasks);
+            }
+
+            // Released time slices overlap slightly, so allow one bin for events still to be released
+            std::vector<uint64_t> bins;
+            if (purge) {
+                frames = binner->close_all(bins);
+            } else if (watermark > binner->bin_width()) {
+                frames = binner->close_bins(watermark - binner->bin_width(), bins);
+            }
+            for (size_t index = 0; index < frames.size(); index++) {
+                this->publish_image_bin_meta_data(frames[index]->get_frame_number(),
+                                                  bins[index] * binner->bin_width(),
+                                                  binner->bin_width());
+                if (rois && rois->rois() > 0) {
+                    this->publish_roi_bin_meta_data(rois, frames[index], bins[index] * binner->bin_width());
+                }
+            }
+        }
+        return frames;
+    }
+
+    void LATRDProcessCoordinator::configure_clustering(bool enable, uint64_t window)
+    {
+        // Clusters that may still grow are held by the clusterer, so clustering should only be changed
+        // between acquisitions
+        boost::shared_ptr<LATRDClusterer> clusterer;
+        if (enable) {
+            clusterer = boost::shared_ptr<LATRDClusterer>(new LATRDClusterer(window, taskPool_->size()));
+        }
+        boost::lock_guard<boost::mutex> lock(clusterer_mutex_);
+        clusterer_ = clusterer;
+    }
+
+    uint64_t LATRDProcessCoordinator::get_timestamp_delta_mismatches()
+    {
+        return ts_tracker_.mismatches();
+    }
+
+    uint64_t LATRDProcessCoordinator::get_compression_failures()
+    {
+        return compression_failures_;
+    }
+
+    uint64_t LATRDProcessCoordinator::get_cluster_count()
+    {
+        return clusters_;
+    }
+
+    std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::cluster_events(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs, bool purge)
+    {
+        std::vector<boost::shared_ptr<Frame> > frames;
+        boost::shared_ptr<LATRDClusterer> clusterer;
+        {
+            boost::lock_guard<boost::mutex> lock(clusterer_mutex_);
+            clusterer = clusterer_;
+        }
+        if (clusterer) {
+            // Each pool thread clusters a run of consecutive time slices, so that
+            // only clusters at the edges of the runs need stitching
+            std::vector<boost::shared_ptr<LATRDTask> > tasks;
+            std::vector<boost::shared_ptr<LATRDClusterTask> > cluster_tasks;
+            for (size_t index = 0; index < clusterer->partitions(); index++) {
+                boost::shared_ptr<LATRDClusterTask> task(new LATRDClusterTask(clusterer.get(), index));
+                cluster_tasks.push_back(task);
+                tasks.push_back(task);
+            }
+            size_t time_slices = 0;
+            for (size_t index = 0; index < jobs.size(); index++) {
+                if (index == 0 || jobs[index]->time_slice != jobs[index - 1]->time_slice) {
+                    time_slices++;
+                }
+            }
+            size_t time_slice = 0;
+            for (size_t index = 0; index < jobs.size(); index++) {
+                if (index > 0 && jobs[index]->time_slice != jobs[index - 1]->time_slice) {
+                    time_slice++;
+                }
+                cluster_tasks[(time_slice * cluster_tasks.size()) / time_slices]->jobs.push_back(jobs[index]);
+            }
+            if (jobs.size() > 0) {
+                taskPool_->run(tasks);
+            }
+            std::vector<LATRDCluster> clusters = clusterer->stitch(purge);
+            clusters_ += clusters.size();
+
+            // Write the clusters out in runs that fit within the current frames
+            size_t written = 0;
+            while (written < clusters.size()) {
+                size_t qty = std::min(clusters.size() - written, clusterTimeBuffer_->remaining());
+                std::vector<uint64_t> cluster_time(qty);
+                std::vector<float> cluster_x(qty);
+                std::vector<float> cluster_y(qty);
+                std::vector<float> cluster_energy(qty);
+                std::vector<uint16_t> cluster_size(qty);
+                for (size_t index = 0; index < qty; index++) {
+                    const LATRDCluster& cluster = clusters[written + index];
+                    cluster_time[index] = cluster.first_ts;
+                    cluster_x[index] = cluster.centroid_x();
+                    cluster_y[index] = cluster.centroid_y();
+                    cluster_energy[index] = cluster.energy;
+                    cluster_size[index] = (uint16_t)std::min(cluster.pixels.size(), (size_t)0xFFFF);
+                }
+                this->add_output_frame(frames, clusterTimeBuffer_->appendData(&cluster_time[0], qty), "cluster_time", 3);
+                this->add_output_frame(frames, clusterXBuffer_->appendData(&cluster_x[0], qty), "cluster_x", 4);
+                this->add_output_frame(frames, clusterYBuffer_->appendData(&cluster_y[0], qty), "cluster_y", 4);
+                this->add_output_frame(frames, clusterEnergyBuffer_->appendData(&cluster_energy[0], qty), "cluster_energy", 4);
+                this->add_output_frame(frames, clusterSizeBuffer_->appendData(&cluster_size[0], qty), "cluster_size", 1);
+                written += qty;
+            }
+        }
+        return frames;
+    }
+
+    void LATRDProcessCoordinator::publish_image_bin_meta_data(uint64_t frame_number, uint64_t bin_start, uint64_t bin_width)
+    {
+        if (metaPtr_){
+            rapidjson::Document meta_document;
+            meta_document.SetObject();
+
+            // Add rank
+            rapidjson::Value key_rank("rank", meta_document.GetAllocator());
+            rapidjson::Value value_rank;
+            value_rank.SetInt(rank_);
+            meta_document.AddMember(key_rank, value_rank, meta_document.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            meta_document.Accept(writer);
+
+            // Image frame number, start time and width of the bin
+            uint64_t bin[3] = {frame_number, bin_start, bin_width};
+            metaPtr_->publish_meta("latrd",
+                                   "image_bin",
+                                   bin,
+                                   sizeof(bin),
+                                   buffer.GetString());
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_rois(boost::shared_ptr<LATRDRoiIntegrator> rois)
+    {
+        boost::lock_guard<boost::mutex> lock(binner_mutex_);
+        rois_ = rois;
+    }
+
+    void LATRDProcessCoordinator::publish_roi_bin_meta_data(boost::shared_ptr<LATRDRoiIntegrator> rois,
+                                                            boost::shared_ptr<Frame> frame,
+                                                            uint64_t bin_start)
+    {
+        if (metaPtr_){
+            rapidjson::Document meta_document;
+            meta_document.SetObject();
+
+            // Add rank
+            rapidjson::Value key_rank("rank", meta_document.GetAllocator());
+            rapidjson::Value value_rank;
+            value_rank.SetInt(rank_);
+            meta_document.AddMember(key_rank, value_rank, meta_document.GetAllocator());
+
+            rapidjson::Value key_rois("rois", meta_document.GetAllocator());
+            rapidjson::Value value_rois;
+            value_rois.SetUint((uint32_t)rois->rois());
+            meta_document.AddMember(key_rois, value_rois, meta_document.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            meta_document.Accept(writer);
+
+            // Image frame number and start time of the bin, followed by the integrated counts of each region
+            std::vector<uint64_t> sums(rois->rois() + 2, 0);
+            sums[0] = frame->get_frame_number();
+            sums[1] = bin_start;
+            rois->integrate(frame->get_data(), 32, &sums[2]);
+            metaPtr_->publish_meta("latrd",
+                                   "roi_bin_intensity",
+                                   &sums[0],
+                                   sums.size() * sizeof(uint64_t),
+                                   buffer.GetString());
+        }
+    }
+
+    void LATRDProcessCoordinator::configure_compression(LATRDCompressionType type, bool delta)
+    {
+        if (type != NO_COMPRESSION && !LATRDCompressor::available()){
+            throw LATRDProcessingException("Compression requested but LZ4 support was not built");
+        }
+        compression_ = type;
+        compression_delta_ = delta;
     }
 
     std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::process_frame(boost::shared_ptr<Frame> frame)
@@ -103,89 +761,177 @@ static int no_of_job = 0;
             //LOG4CXX_ERROR(logger_, "Current wrap: " << current_ts_wrap_);
             //LOG4CXX_ERROR(logger_, "ts_store count: " << ts_store_.count(current_ts_wrap_));
             //LOG4CXX_ERROR(logger_, "Wrap report: " << ts_store_[current_ts_wrap_]->report());
-            frames = this->add_jobs_to_buffer(check_for_data_to_write());
+            std::vector<boost::shared_ptr<LATRDProcessJob> > jobs = check_for_data_to_write();
+            if (jobs.size() > 0) {
+                // Time slice data has been released so bring the diagnostics up to date
+                this->collect_histograms(false);
+            }
+            // Images must be binned before the jobs are released by writing them to the buffers
+            std::vector<boost::shared_ptr<Frame> > image_frames = this->bin_images(jobs, false);
+            std::vector<boost::shared_ptr<Frame> > cluster_frames = this->cluster_events(jobs, false);
+            frames = this->add_jobs_to_buffer(jobs);
+            frames.insert(frames.end(), image_frames.begin(), image_frames.end());
+            frames.insert(frames.end(), cluster_frames.begin(), cluster_frames.end());
             processed_frames_++;
             output_frames_ += frames.size();
         } else {
             // This is an IDLE frame, so we need to completely flush all remaining jobs
-            frames = this->add_jobs_to_buffer(purge_remaining_jobs());
+            std::vector<boost::shared_ptr<LATRDProcessJob> > jobs = purge_remaining_jobs();
+            std::vector<boost::shared_ptr<Frame> > image_frames = this->bin_images(jobs, true);
+            std::vector<boost::shared_ptr<Frame> > cluster_frames = this->cluster_events(jobs, true);
+            frames = this->add_jobs_to_buffer(jobs);
+            frames.insert(frames.end(), image_frames.begin(), image_frames.end());
+            frames.insert(frames.end(), cluster_frames.begin(), cluster_frames.end());
+            this->collect_histograms(true);
             std::vector<boost::shared_ptr<Frame> > purged_frames;
             purged_frames = this->purge_remaining_buffers();
             frames.insert(frames.end(), purged_frames.begin(), purged_frames.end());
             // Now reset all counters
             current_ts_wrap_ = 0;
+            ts_tracker_.reset();
             current_ts_buffer_ = 0;
             // and the buffers
             timeStampBuffer_->resetFrameNumber();
             idBuffer_->resetFrameNumber();
             energyBuffer_->resetFrameNumber();
+            xBuffer_->resetFrameNumber();
+            yBuffer_->resetFrameNumber();
             ctrlWordBuffer_->resetFrameNumber();
             ctrlTimeStampBuffer_->resetFrameNumber();
+            packedBuffer_->resetFrameNumber();
+            varintBuffer_->resetFrameNumber();
+            cueIndexBuffer_->resetFrameNumber();
+            cueOffsetBuffer_->resetFrameNumber();
+            clusterTimeBuffer_->resetFrameNumber();
+            clusterXBuffer_->resetFrameNumber();
+            clusterYBuffer_->resetFrameNumber();
+            clusterEnergyBuffer_->resetFrameNumber();
+            clusterSizeBuffer_->resetFrameNumber();
             // Reset the time slice array and counter
             last_written_ts_index_ = 0;
             ts_index_array_.assign(LATRD::time_slice_write_size * LATRD::number_of_time_slice_buffers, 0);
         }
-        LOG4CXX_DEBUG_LEVEL(2, logger_, "Job stack size: " << jobStack_.size());
+        if (forced_frames_.size() > 0) {
+            // Frames written while freeing jobs from the pool come before the released data
+            frames.insert(frames.begin(), forced_frames_.begin(), forced_frames_.end());
+            output_frames_ += forced_frames_.size();
+            forced_frames_.clear();
+        }
+        if (compression_ != NO_COMPRESSION && frames.size() > 0) {
+            // Frames dropped by a failed compression are not output
+            size_t uncompressed_frames = frames.size();
+            frames = this->compress_frames(frames);
+            output_frames_ -= (uncompressed_frames - frames.size());
+        }
+        LOG4CXX_DEBUG_LEVEL(2, logger_, "Job stack size: " << free_jobs());
         return frames;
     }
 
     std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::add_jobs_to_buffer(std::vector<boost::shared_ptr<LATRDProcessJob> > jobs)
     {
         std::vector<boost::shared_ptr<Frame> > frames;
-        boost::shared_ptr<Frame> processedFrame;
         LOG4CXX_DEBUG_LEVEL(2, logger_, "Processed packets ready to write out: " << jobs.size());
         // Copy each processed job into the relevant buffer
         std::vector<boost::shared_ptr<LATRDProcessJob> >::iterator iter;
         for (iter = jobs.begin(); iter != jobs.end(); ++iter) {
             boost::shared_ptr<LATRDProcessJob> job = *iter;
-            processedFrame = timeStampBuffer_->appendData(job->event_ts_ptr, job->valid_results);
-            if (processedFrame) {
-                LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing timestamp data frame.");
-                std::vector<dimsize_t> dims(0);
-                processedFrame->set_dataset_name("event_time_offset");
-                processedFrame->set_data_type(3);
-                processedFrame->set_dimensions(dims);
-                frames.push_back(processedFrame);
-            }
-
-            processedFrame = idBuffer_->appendData(job->event_id_ptr, job->valid_results);
-            if (processedFrame) {
-                LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing ID data frame.");
-                std::vector<dimsize_t> dims(0);
-                processedFrame->set_dataset_name("event_id");
-                processedFrame->set_data_type(2);
-                processedFrame->set_dimensions(dims);
-                frames.push_back(processedFrame);
-            }
-
-            processedFrame = energyBuffer_->appendData(job->event_energy_ptr, job->valid_results);
-            if (processedFrame) {
-                LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing energy data frame.");
-                std::vector<dimsize_t> dims(0);
-                processedFrame->set_dataset_name("event_energy");
-                processedFrame->set_data_type(2);
-                processedFrame->set_dimensions(dims);
-                frames.push_back(processedFrame);
-            }
-
-            processedFrame = ctrlTimeStampBuffer_->appendData(job->ctrl_word_ts_ptr, job->valid_control_words);
-            if (processedFrame) {
-                LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing control word timestamps.");
-                std::vector<dimsize_t> dims(0);
-                processedFrame->set_dataset_name("cue_timestamp_zero");
-                processedFrame->set_data_type(3);
-                processedFrame->set_dimensions(dims);
-                frames.push_back(processedFrame);
-            }
-
-            processedFrame = ctrlWordBuffer_->appendData(job->ctrl_word_id_ptr, job->valid_control_words);
-            if (processedFrame) {
-                LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing control word IDs.");
-                std::vector<dimsize_t> dims(0);
-                processedFrame->set_dataset_name("cue_id");
-                processedFrame->set_data_type(1);
-                processedFrame->set_dimensions(dims);
-                frames.push_back(processedFrame);
+            energy_rejects_ += job->energy_rejects;
+            roi_rejects_ += job->roi_rejects;
+            mask_rejects_ += job->mask_rejects;
+            // Dataset index of the first event in this job, used to make the control word indexes global.
+            // Only requested when needed, as it fixes the number of the current frame
+            uint64_t event_offset = 0;
+            // Buffer the events are appended to, the points of each event, and the events that fit the current frame
+            boost::shared_ptr<LATRDBuffer> event_buffer;
+            size_t event_points = 1;
+            size_t events_before_spill = 0;
+            boost::shared_ptr<Frame> event_frame;
+            if (event_format_ == PACKED_EVENT_FORMAT) {
+                if (job->valid_control_words > 0) {
+                    event_offset = packedBuffer_->position() / packed_event_words;
+                }
+                event_buffer = packedBuffer_;
+                event_points = packed_event_words;
+                events_before_spill = packedBuffer_->remaining() / packed_event_words;
+                event_frame = packedBuffer_->appendData(job->event_packed_ptr, job->valid_results * packed_event_words);
+                this->update_time_range(event_frame, job, events_before_spill);
+                this->add_output_frame(frames, event_frame, "event_packed", 2);
+            } else if (event_format_ == VARINT_EVENT_FORMAT) {
+                // Varint blocks must not be split across frames, so flush the buffer if the block does not fit
+                if (job->packed_size > varintBuffer_->remaining()) {
+                    event_frame = varintBuffer_->retrieveCurrentFrame();
+                    this->update_time_range(event_frame, boost::shared_ptr<LATRDProcessJob>(), 0);
+                    this->add_output_frame(frames, event_frame, "event_varint", 0);
+                }
+                // Events within a varint block cannot be addressed directly so index the start of the block
+                if (job->valid_control_words > 0) {
+                    event_offset = varintBuffer_->position();
+                }
+                event_frame = varintBuffer_->appendData(job->event_packed_ptr, job->packed_size);
+                this->update_time_range(event_frame, job, job->valid_results);
+                this->add_output_frame(frames, event_frame, "event_varint", 0);
+            } else {
+                if (job->valid_control_words > 0) {
+                    event_offset = timeStampBuffer_->position();
+                }
+                event_buffer = timeStampBuffer_;
+                events_before_spill = timeStampBuffer_->remaining();
+                event_frame = timeStampBuffer_->appendData(job->event_ts_ptr, job->valid_results);
+                this->update_time_range(event_frame, job, events_before_spill);
+                this->add_output_frame(frames, event_frame, "event_time_offset", 3);
+                if (job->geometry_output == GEOMETRY_XY) {
+                    this->add_output_frame(frames,
+                                           xBuffer_->appendData(job->event_x_ptr, job->valid_results),
+                                           "event_x", 1);
+                    this->add_output_frame(frames,
+                                           yBuffer_->appendData(job->event_y_ptr, job->valid_results),
+                                           "event_y", 1);
+                } else {
+                    // Linear pixel indexes replace the raw position IDs when a geometry is applied
+                    uint32_t *id_ptr = job->event_id_ptr;
+                    if (job->geometry_output == GEOMETRY_INDEX) {
+                        id_ptr = job->event_pixel_ptr;
+                    }
+                    this->add_output_frame(frames,
+                                           idBuffer_->appendData(id_ptr, job->valid_results),
+                                           "event_id", 2);
+                }
+                // Float calibrated energies share the 32 bit energy buffer
+                this->add_output_frame(frames,
+                                       energyBuffer_->appendData(job->event_energy_ptr, job->valid_results),
+                                       "event_energy", energy_data_type_);
+            }
+            // Events that did not fit continue in the next frame written by this buffer.  Its number is
+            // not necessarily one more than the current frame, so they are indexed from its position
+            bool spill_known = false;
+            uint64_t spill_offset = 0;
+            for (uint16_t index = 0; index < job->valid_control_words; index++) {
+                if (event_format_ == VARINT_EVENT_FORMAT) {
+                    job->ctrl_event_index_ptr[index] = event_offset;
+                } else if (job->ctrl_index_ptr[index] < events_before_spill) {
+                    job->ctrl_event_index_ptr[index] = event_offset + job->ctrl_index_ptr[index];
+                } else {
+                    if (!spill_known) {
+                        spill_offset = (event_buffer->position() / event_points) - (job->valid_results - events_before_spill);
+                        spill_known = true;
+                    }
+                    job->ctrl_event_index_ptr[index] = spill_offset + (job->ctrl_index_ptr[index] - events_before_spill);
+                }
+            }
+            this->add_output_frame(frames,
+                                   ctrlTimeStampBuffer_->appendData(job->ctrl_word_ts_ptr, job->valid_control_words),
+                                   "cue_timestamp_zero", 3);
+            this->add_output_frame(frames,
+                                   ctrlWordBuffer_->appendData(job->ctrl_word_id_ptr, job->valid_control_words),
+                                   "cue_id", 1);
+            if (event_format_ == VARINT_EVENT_FORMAT) {
+                this->add_output_frame(frames,
+                                       cueOffsetBuffer_->appendData(job->ctrl_event_index_ptr, job->valid_control_words),
+                                       "cue_byte_offset", 3);
+            } else {
+                this->add_output_frame(frames,
+                                       cueIndexBuffer_->appendData(job->ctrl_event_index_ptr, job->valid_control_words),
+                                       "cue_event_index", 3);
             }
 
             // Job is now finished, release it back to the stack
@@ -197,63 +943,113 @@ static int no_of_job = 0;
     std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::purge_remaining_buffers()
     {
         std::vector<boost::shared_ptr<Frame> > frames;
-        boost::shared_ptr<Frame> processedFrame;
         LOG4CXX_DEBUG_LEVEL(2, logger_, "Purging any remaining data from buffers");
-        processedFrame = timeStampBuffer_->retrieveCurrentFrame();
-        if (processedFrame) {
-            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing timestamp data frame.");
-            std::vector<dimsize_t> dims(0);
-            processedFrame->set_dataset_name("event_time_offset");
-            processedFrame->set_data_type(3);
-            processedFrame->set_dimensions(dims);
-            frames.push_back(processedFrame);
+        // Buffers that follow the frame numbers of another are purged before their leader
+        boost::shared_ptr<Frame> id_frame = idBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> energy_frame = energyBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> x_frame = xBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> y_frame = yBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> event_frame = timeStampBuffer_->retrieveCurrentFrame();
+        if (event_format_ == COLUMN_EVENT_FORMAT) {
+            this->update_time_range(event_frame, boost::shared_ptr<LATRDProcessJob>(), 0);
         }
-
-        processedFrame = idBuffer_->retrieveCurrentFrame();
-        if (processedFrame) {
-            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing ID data frame.");
-            std::vector<dimsize_t> dims(0);
-            processedFrame->set_dataset_name("event_id");
-            processedFrame->set_data_type(2);
-            processedFrame->set_dimensions(dims);
-            frames.push_back(processedFrame);
+        this->add_output_frame(frames, event_frame, "event_time_offset", 3);
+        this->add_output_frame(frames, id_frame, "event_id", 2);
+        this->add_output_frame(frames, energy_frame, "event_energy", energy_data_type_);
+        this->add_output_frame(frames, x_frame, "event_x", 1);
+        this->add_output_frame(frames, y_frame, "event_y", 1);
+        event_frame = packedBuffer_->retrieveCurrentFrame();
+        if (event_format_ == PACKED_EVENT_FORMAT) {
+            this->update_time_range(event_frame, boost::shared_ptr<LATRDProcessJob>(), 0);
         }
-
-        processedFrame = energyBuffer_->retrieveCurrentFrame();
-        if (processedFrame) {
-            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing energy data frame.");
-            std::vector<dimsize_t> dims(0);
-            processedFrame->set_dataset_name("event_energy");
-            processedFrame->set_data_type(2);
-            processedFrame->set_dimensions(dims);
-            frames.push_back(processedFrame);
+        this->add_output_frame(frames, event_frame, "event_packed", 2);
+        event_frame = varintBuffer_->retrieveCurrentFrame();
+        if (event_format_ == VARINT_EVENT_FORMAT) {
+            this->update_time_range(event_frame, boost::shared_ptr<LATRDProcessJob>(), 0);
         }
+        this->add_output_frame(frames, event_frame, "event_varint", 0);
+        // Any range left over belongs to a frame that was never written
+        frame_ts_min_ = empty_ts_min;
+        frame_ts_max_ = 0;
+        boost::shared_ptr<Frame> cue_id_frame = ctrlWordBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> cue_index_frame = cueIndexBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> cue_offset_frame = cueOffsetBuffer_->retrieveCurrentFrame();
+        this->add_output_frame(frames, ctrlTimeStampBuffer_->retrieveCurrentFrame(), "cue_timestamp_zero", 3);
+        this->add_output_frame(frames, cue_id_frame, "cue_id", 1);
+        this->add_output_frame(frames, cue_index_frame, "cue_event_index", 3);
+        this->add_output_frame(frames, cue_offset_frame, "cue_byte_offset", 3);
+        boost::shared_ptr<Frame> cluster_x_frame = clusterXBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> cluster_y_frame = clusterYBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> cluster_energy_frame = clusterEnergyBuffer_->retrieveCurrentFrame();
+        boost::shared_ptr<Frame> cluster_size_frame = clusterSizeBuffer_->retrieveCurrentFrame();
+        this->add_output_frame(frames, clusterTimeBuffer_->retrieveCurrentFrame(), "cluster_time", 3);
+        this->add_output_frame(frames, cluster_x_frame, "cluster_x", 4);
+        this->add_output_frame(frames, cluster_y_frame, "cluster_y", 4);
+        this->add_output_frame(frames, cluster_energy_frame, "cluster_energy", 4);
+        this->add_output_frame(frames, cluster_size_frame, "cluster_size", 1);
+        return frames;
+    }
 
-        processedFrame = ctrlTimeStampBuffer_->retrieveCurrentFrame();
-        if (processedFrame) {
-            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing control word timestamps.");
+    void LATRDProcessCoordinator::add_output_frame(std::vector<boost::shared_ptr<Frame> >& frames,
+                                                   boost::shared_ptr<Frame> frame,
+                                                   const std::string& name,
+                                                   int data_type)
+    {
+        // Buffers only return a frame once it is complete, so there may be nothing to add
+        if (frame) {
+            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing " << name << " data frame.");
             std::vector<dimsize_t> dims(0);
-            processedFrame->set_dataset_name("cue_timestamp_zero");
-            processedFrame->set_data_type(3);
-            processedFrame->set_dimensions(dims);
-            frames.push_back(processedFrame);
+            frame->set_dataset_name(name);
+            frame->set_data_type(data_type);
+            frame->set_dimensions(dims);
+            frames.push_back(frame);
         }
+    }
 
-        processedFrame = ctrlWordBuffer_->retrieveCurrentFrame();
-        if (processedFrame) {
-            LOG4CXX_DEBUG_LEVEL(2, logger_, "Pushing control word IDs.");
-            std::vector<dimsize_t> dims(0);
-            processedFrame->set_dataset_name("cue_id");
-            processedFrame->set_data_type(1);
-            processedFrame->set_dimensions(dims);
-            frames.push_back(processedFrame);
+    std::vector<boost::shared_ptr<Frame> > LATRDProcessCoordinator::compress_frames(std::vector<boost::shared_ptr<Frame> > frames)
+    {
+        LOG4CXX_DEBUG_LEVEL(2, logger_, "Compressing " << frames.size() << " output frames");
+        // Create one compression task per frame and execute them on the task pool
+        std::vector<boost::shared_ptr<LATRDTask> > tasks;
+        std::vector<boost::shared_ptr<LATRDCompressionTask> > compression_tasks;
+        std::vector<boost::shared_ptr<Frame> >::iterator iter;
+        for (iter = frames.begin(); iter != frames.end(); ++iter) {
+            // Timestamps are delta encoded before shuffling if requested
+            std::string name = (*iter)->get_dataset_name();
+            bool delta = compression_delta_ && (name == "event_time_offset" || name == "cue_timestamp_zero");
+            boost::shared_ptr<LATRDCompressionTask> task(new LATRDCompressionTask(*iter, delta));
+            compression_tasks.push_back(task);
+            tasks.push_back(task);
         }
+        taskPool_->run(tasks);
 
-        return frames;
+        // Collect the compressed frames in their original order.  The datasets are created with the
+        // compression filter, so a frame that failed is dropped rather than written uncompressed
+        std::vector<boost::shared_ptr<Frame> > compressed_frames;
+        std::vector<boost::shared_ptr<LATRDCompressionTask> >::iterator task_iter;
+        for (task_iter = compression_tasks.begin(); task_iter != compression_tasks.end(); ++task_iter) {
+            if ((*task_iter)->out_frame) {
+                compressed_frames.push_back((*task_iter)->out_frame);
+            } else {
+                LOG4CXX_ERROR(logger_, "Compression failed for frame " << (*task_iter)->in_frame->get_frame_number()
+                                       << " of dataset " << (*task_iter)->in_frame->get_dataset_name()
+                                       << ", dropping it");
+                compression_failures_++;
+            }
+        }
+        return compressed_frames;
     }
 
     void LATRDProcessCoordinator::frame_to_jobs(boost::shared_ptr<Frame> frame)
     {
+        // Packets are decoded by the worker group on the node holding the frame
+        size_t group = 0;
+        if (numa_enabled_) {
+            int node = numa_.node_of(frame->get_data());
+            if (node >= 0) {
+                group = (size_t)node % numa_groups_;
+            }
+        }
         LATRD::PacketHeader packet_header = {};
         const LATRD::FrameHeader* hdrPtr = static_cast<const LATRD::FrameHeader*>(frame->get_data());
         // Extract the header words from each packet
@@ -274,19 +1070,27 @@ static int no_of_job = 0;
                 uint32_t packet_number = LATRD::get_packet_number(packet_header.headerWord2);
                 uint16_t word_count = LATRD::get_word_count(packet_header.headerWord1);
                 uint32_t time_slice = LATRD::get_time_slice_id(packet_header.headerWord1, packet_header.headerWord2);
+                uint32_t time_slice_wrap = LATRD::get_time_slice_modulo(packet_header.headerWord1);
                 uint16_t words_to_process = word_count - packet_header_count;
 
                 uint64_t *data_ptr = (((uint64_t *) payload_ptr) + 1);
                 data_ptr += packet_header_count;
-                boost::shared_ptr<LATRDProcessJob> job = this->getJob();
-                job->job_id = (uint32_t)index;
-                job->packet_number = packet_number;
-                job->data_ptr = data_ptr;
-                job->time_slice = time_slice;
-                job->time_slice_wrap = LATRD::get_time_slice_modulo(packet_header.headerWord1);
-                job->time_slice_buffer = LATRD::get_time_slice_number(packet_header.headerWord2);
-                job->words_to_process = words_to_process;
-                jobQueue_->add(job, true);
+                boost::shared_ptr<LATRDProcessJob> job = this->getJob(group, time_slice_wrap);
+                if (job) {
+                    job->job_id = (uint32_t)index;
+                    job->packet_number = packet_number;
+                    job->data_ptr = data_ptr;
+                    job->time_slice = time_slice;
+                    job->time_slice_wrap = time_slice_wrap;
+                    job->time_slice_buffer = LATRD::get_time_slice_number(packet_header.headerWord2);
+                    job->producer_id = LATRD::get_producer_ID(packet_header.headerWord1);
+                    job->words_to_process = words_to_process;
+                    jobQueues_[group]->add(job, true);
+                } else {
+                    // Every job is holding data that may still be added to, so the packet is lost
+                    dropped_packets += 1;
+                    pool_dropped_packets_++;
+                }
             }
             payload_ptr += LATRD::primary_packet_size;
         }
@@ -322,6 +1126,8 @@ static int no_of_job = 0;
                     LOG4CXX_ERROR(logger_, "Stale packet received ts_wrap[" << job->time_slice_wrap <<
                                            "] ts_buffer[" << job->time_slice_buffer << "], dropping");
                     // TODO: Log the fault into the plugin stats
+                    // The job holds nothing that will be written, so it goes straight back to the pool
+                    this->releaseJob(job);
                 }
             }
             processed_jobs_++;
@@ -424,6 +1230,18 @@ static int no_of_job = 0;
             rapidjson::Value value_index;
             value_index.SetInt(last_written_ts_index_);
             meta_document.AddMember(key_index, value_index, meta_document.GetAllocator());
+            // Add the event frame numbers written since the last publish
+            rapidjson::Value key_frames("frames", meta_document.GetAllocator());
+            rapidjson::Value value_frames;
+            value_frames.SetArray();
+            std::vector<uint64_t>::iterator frame_iter;
+            for (frame_iter = frame_numbers_.begin(); frame_iter != frame_numbers_.end(); ++frame_iter) {
+                rapidjson::Value value_frame;
+                value_frame.SetUint64(*frame_iter);
+                value_frames.PushBack(value_frame, meta_document.GetAllocator());
+            }
+            meta_document.AddMember(key_frames, value_frames, meta_document.GetAllocator());
+            frame_numbers_.clear();
 
             rapidjson::StringBuffer buffer;
             rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
@@ -438,6 +1256,68 @@ static int no_of_job = 0;
         }
     }
 
+    void LATRDProcessCoordinator::update_time_range(boost::shared_ptr<Frame> frame,
+                                                    boost::shared_ptr<LATRDProcessJob> job,
+                                                    size_t events_before_spill)
+    {
+        size_t events = job ? job->valid_results : 0;
+        if (events <= events_before_spill) {
+            // Every event fits the current frame, so the range found by the worker applies
+            if (events > 0) {
+                frame_ts_min_ = std::min(frame_ts_min_, job->ts_min);
+                frame_ts_max_ = std::max(frame_ts_max_, job->ts_max);
+            }
+        } else {
+            for (size_t index = 0; index < events_before_spill; index++) {
+                frame_ts_min_ = std::min(frame_ts_min_, job->event_ts_ptr[index]);
+                frame_ts_max_ = std::max(frame_ts_max_, job->event_ts_ptr[index]);
+            }
+        }
+        if (frame) {
+            // Record the event frame numbers written by this rank for the time slice meta data
+            frame_numbers_.push_back(frame->get_frame_number());
+            // The frame is complete so publish its range, only frames containing events have one
+            if (frame_ts_min_ <= frame_ts_max_) {
+                this->publish_time_range_meta_data(frame->get_frame_number(), frame_ts_min_, frame_ts_max_);
+            }
+            frame_ts_min_ = empty_ts_min;
+            frame_ts_max_ = 0;
+            // Events of a job that overflowed the frame begin the range of the next frame
+            for (size_t index = events_before_spill; index < events; index++) {
+                frame_ts_min_ = std::min(frame_ts_min_, job->event_ts_ptr[index]);
+                frame_ts_max_ = std::max(frame_ts_max_, job->event_ts_ptr[index]);
+            }
+        }
+    }
+
+    void LATRDProcessCoordinator::publish_time_range_meta_data(uint64_t frame_number, uint64_t ts_min, uint64_t ts_max)
+    {
+        if (metaPtr_){
+            rapidjson::Document meta_document;
+            meta_document.SetObject();
+
+            // Add rank
+            rapidjson::Value key_rank("rank", meta_document.GetAllocator());
+            rapidjson::Value value_rank;
+            value_rank.SetInt(rank_);
+            meta_document.AddMember(key_rank, value_rank, meta_document.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            meta_document.Accept(writer);
+
+            // Frame number, minimum and maximum timestamp of the frame
+            uint64_t range[3] = {frame_number, ts_min, ts_max};
+            LOG4CXX_DEBUG_LEVEL(2, logger_, "Publishing time range of frame " << frame_number
+                                            << " [" << ts_min << ", " << ts_max << "]");
+            metaPtr_->publish_meta("latrd",
+                                   "time_range",
+                                   range,
+                                   sizeof(range),
+                                   buffer.GetString());
+        }
+    }
+
     std::vector<boost::shared_ptr<LATRDProcessJob> > LATRDProcessCoordinator::purge_remaining_jobs()
     {
         std::vector<boost::shared_ptr<LATRDProcessJob> > jobs;
@@ -458,15 +1338,30 @@ static int no_of_job = 0;
         return jobs;
     }
 
-  void LATRDProcessCoordinator::processTask()
+  void LATRDProcessCoordinator::processTask(size_t thread_index)
   {
       LOG4CXX_TRACE(logger_, "Starting processing task with ID [" << boost::this_thread::get_id() << "]");
+      size_t group = thread_index % numa_groups_;
+      if (numa_enabled_) {
+          numa_.bind_thread(group, 0);
+      }
+      boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > > queue = jobQueues_[group];
       bool executing = true;
       while (executing){
-          boost::shared_ptr<LATRDProcessJob> job = jobQueue_->remove();
+          boost::shared_ptr<LATRDProcessJob> job = queue->remove();
+          if (!job) {
+              // An empty job is the request for this worker to stop
+              break;
+          }
           job->valid_results = 0;
           job->valid_control_words = 0;
           job->timestamp_mismatches = 0;
+          job->energy_rejects = 0;
+          job->roi_rejects = 0;
+          job->mask_rejects = 0;
+          job->geometry_output = NO_GEOMETRY;
+          job->energy_output = RAW_ENERGY;
+          job->energy_fraction_bits = 0;
           uint64_t previous_course_timestamp = 0;
           uint64_t current_course_timestamp = 0;
 //	    LOG4CXX_DEBUG(logger_, "Processing job [" << job->job_id
@@ -493,6 +1388,7 @@ static int no_of_job = 0;
                                       job->packet_number,
                                       job->time_slice_wrap,
                                       job->time_slice_buffer,
+                                      job->producer_id,
                                       event_ts_ptr,
                                       event_id_ptr,
                                       event_energy_ptr)){
@@ -530,6 +1426,87 @@ static int no_of_job = 0;
                   job->timestamp_mismatches++;
               }
               data_word_ptr++;
+          }
+          // Place the events on the sensor image before filtering, so that the regions of
+          // interest and the consumers of the pixel positions all work in image coordinates
+          boost::shared_ptr<LATRDPixelGeometry> geometry;
+          {
+              boost::lock_guard<boost::mutex> lock(geometry_mutex_);
+              geometry = geometry_;
+          }
+          if (geometry){
+              job->geometry_output = geometry->output();
+              geometry->map_positions(job->event_id_ptr, job->event_image_id_ptr, job->valid_results);
+          }
+          // Remove any unwanted events before they are counted into the results
+          boost::shared_ptr<LATRDEventFilter> filter;
+          {
+              boost::lock_guard<boost::mutex> lock(filter_mutex_);
+              filter = filter_;
+          }
+          if (filter){
+              job->valid_results = filter->filter(job->event_ts_ptr,
+                                                  job->event_id_ptr,
+                                                  job->pixel_ids(),
+                                                  job->event_energy_ptr,
+                                                  job->valid_results,
+                                                  job->ctrl_index_ptr,
+                                                  job->valid_control_words,
+                                                  &job->energy_rejects,
+                                                  &job->roi_rejects,
+                                                  &job->mask_rejects);
+          }
+          // Write the mapped pixels in the form selected for output.  The raw IDs are kept
+          // for the module histograms, which work in raw chip coordinates
+          uint32_t *output_id_ptr = job->event_id_ptr;
+          if (geometry){
+              if (job->geometry_output == GEOMETRY_XY){
+                  geometry->map_coordinates(job->event_id_ptr, job->event_x_ptr, job->event_y_ptr, job->valid_results);
+              } else {
+                  geometry->map_indexes(job->event_id_ptr, job->event_pixel_ptr, job->valid_results);
+                  output_id_ptr = job->event_pixel_ptr;
+              }
+          }
+          // Track the range of timestamps within the job
+          for (uint16_t index = 0; index < job->valid_results; index++){
+              if (job->event_ts_ptr[index] < job->ts_min){
+                  job->ts_min = job->event_ts_ptr[index];
+              }
+              if (job->event_ts_ptr[index] > job->ts_max){
+                  job->ts_max = job->event_ts_ptr[index];
+              }
+          }
+          // Add the events to the histograms owned by this thread
+          if (histograms_enabled_){
+              LATRDHistogramSet *histogram = histograms_[thread_index]->begin_job();
+              histogram->add_job(job.get(), histogram_modules_);
+              histograms_[thread_index]->end_job();
+          }
+          // Calibrate the energies once the histograms have been filled with the raw values.
+          // The packed formats only hold raw energies so are never calibrated
+          boost::shared_ptr<LATRDEnergyCalibration> calibration;
+          {
+              boost::lock_guard<boost::mutex> lock(calibration_mutex_);
+              calibration = calibration_;
+          }
+          if (calibration && event_format_ == COLUMN_EVENT_FORMAT){
+              calibration->calibrate(job->pixel_ids(), job->event_energy_ptr, job->valid_results);
+              job->energy_output = calibration->output();
+              job->energy_fraction_bits = (uint8_t)calibration->fraction_bits();
+          }
+          // Encode the packed output formats while the decoded events are still in cache
+          if (event_format_ == PACKED_EVENT_FORMAT){
+              job->packed_size = LATRDEventCodec::pack_records(job->event_ts_ptr,
+                                                               output_id_ptr,
+                                                               job->event_energy_ptr,
+                                                               job->valid_results,
+                                                               (uint32_t *)job->event_packed_ptr) * sizeof(uint32_t);
+          } else if (event_format_ == VARINT_EVENT_FORMAT){
+              job->packed_size = LATRDEventCodec::encode_varint_block(job->event_ts_ptr,
+                                                                      output_id_ptr,
+                                                                      job->event_energy_ptr,
+                                                                      job->valid_results,
+                                                                      job->event_packed_ptr);
           }
 	    LOG4CXX_DEBUG_LEVEL(2, logger_, "Processing complete for job [" << job->job_id
 	    		<< "] on task [" << boost::this_thread::get_id()
@@ -539,26 +1516,74 @@ static int no_of_job = 0;
       }
   }
 
-  boost::shared_ptr<LATRDProcessJob> LATRDProcessCoordinator::getJob()
+  boost::shared_ptr<LATRDProcessJob> LATRDProcessCoordinator::getJob(size_t group, uint32_t ts_wrap)
   {
       boost::shared_ptr<LATRDProcessJob> job;
-      // Check if we have a job available
-      if (jobStack_.size() > 0){
-          job = jobStack_.top();
-          jobStack_.pop();
-      } else{
-          // No job available so create a new one
-          job = boost::shared_ptr<LATRDProcessJob>(new LATRDProcessJob(LATRD::primary_packet_size/sizeof(uint64_t)));
+      if (free_jobs() == 0){
+          // The pool is bounded, so write out any held data that the incoming packet shows is complete
+          pool_exhausted_++;
+          this->release_wraps_before(ts_wrap);
+      }
+      if (free_jobs() == 0){
+          // An empty job tells the caller to drop the packet
+          return job;
+      }
+      // Jobs from the group's own node are preferred, otherwise one is borrowed from another node
+      size_t source = group;
+      while (jobStacks_[source].empty()){
+          source = (source + 1) % jobStacks_.size();
+      }
+      if (source == group){
+          numa_local_jobs_++;
+      } else {
+          numa_remote_jobs_++;
       }
+      job = jobStacks_[source].top();
+      jobStacks_[source].pop();
       return job;
   }
 
+  size_t LATRDProcessCoordinator::free_jobs()
+  {
+      size_t jobs = 0;
+      for (size_t group = 0; group < jobStacks_.size(); group++){
+          jobs += jobStacks_[group].size();
+      }
+      return jobs;
+  }
+
+  void LATRDProcessCoordinator::release_wraps_before(uint32_t ts_wrap)
+  {
+      // Wraps more than one behind the incoming packet would be written out once it is
+      // added, so they can be written now.  The current and previous wraps are never
+      // released early as packets for them may still arrive
+      std::vector<boost::shared_ptr<LATRDProcessJob> > jobs;
+      std::map<uint32_t, boost::shared_ptr<LATRDTimeSliceWrap> >::iterator iter;
+      for (iter = ts_store_.begin(); iter != ts_store_.end() && iter->first + 1 < ts_wrap;) {
+          LOG4CXX_DEBUG_LEVEL(1, logger_, "Job pool exhausted, releasing time slice wrap " << iter->first);
+          this->update_time_slice_meta_data(iter->first, iter->second->get_all_event_data_counts());
+          std::vector<boost::shared_ptr<LATRDProcessJob> > wrap_jobs = iter->second->empty_all_buffers();
+          jobs.insert(jobs.end(), wrap_jobs.begin(), wrap_jobs.end());
+          ts_store_.erase(iter++);
+          forced_releases_++;
+      }
+      if (jobs.size() > 0){
+          // The frames are returned with the output of the frame currently being processed
+          std::vector<boost::shared_ptr<Frame> > image_frames = this->bin_images(jobs, false);
+          std::vector<boost::shared_ptr<Frame> > cluster_frames = this->cluster_events(jobs, false);
+          std::vector<boost::shared_ptr<Frame> > frames = this->add_jobs_to_buffer(jobs);
+          forced_frames_.insert(forced_frames_.end(), frames.begin(), frames.end());
+          forced_frames_.insert(forced_frames_.end(), image_frames.begin(), image_frames.end());
+          forced_frames_.insert(forced_frames_.end(), cluster_frames.begin(), cluster_frames.end());
+      }
+  }
+
   void LATRDProcessCoordinator::releaseJob(boost::shared_ptr<LATRDProcessJob> job)
   {
       // Reset the job
       job->reset();
-      // Place the job back on the stack ready for re-use
-      jobStack_.push(job);
+      // Place the job back on the stack it was allocated for ready for re-use
+      jobStacks_[job->pool_group].push(job);
   }
 
   bool LATRDProcessCoordinator::processDataWord(uint64_t data_word,
@@ -567,6 +1592,7 @@ static int no_of_job = 0;
                                                 uint32_t packet_number,
                                                 uint32_t time_slice_wrap,
                                                 uint32_t time_slice_buffer,
+                                                uint8_t producer_id,
                                                 uint64_t *event_ts,
                                                 uint32_t *event_id,
                                                 uint32_t *event_energy)
@@ -576,16 +1602,15 @@ static int no_of_job = 0;
       if (LATRD::is_control_word(data_word)){
           if (LATRD::get_control_type(data_word) == LATRD::ExtendedTimestamp){
               uint64_t ts = getCourseTimestamp(data_word);
-//              LOG4CXX_DEBUG(logger_, "Parsing extended timestamp control word [" << std::hex << data_word << "] value [" << std::dec << ts << "]");
-              // Register the timestamp with the manager
-//              ts_manager_.add_timestamp(time_slice_buffer, time_slice_wrap, packet_number, (ts & LATRD::timestamp_match_mask));
+//              LOG4CXX_DEBUG(logger_, "Parsing extended timestamp control word [" << std::dec << ts << "]");
               *previous_course_timestamp = *current_course_timestamp;
               *current_course_timestamp = ts;
               if (*previous_course_timestamp == 0){
                   // Calculate the previous course timestamp by subtracting the delta from the current
-                  *previous_course_timestamp = *current_course_timestamp - LATRD::course_timestamp_rollover; //ts_manager_.read_delta();
-                  //LOG4CXX_DEBUG(logger_, "**** Current course timestamp [" << std::dec << *current_course_timestamp << "]");
-                  //LOG4CXX_DEBUG(logger_, "**** Previous course timestamp calculated from TS manager [" << std::dec << *previous_course_timestamp << "]");
+                  *previous_course_timestamp = ts_tracker_.previous(producer_id, *current_course_timestamp);
+              } else {
+                  // Consecutive extended timestamps within the packet give the delta for this producer
+                  ts_tracker_.record(producer_id, *previous_course_timestamp, *current_course_timestamp);
               }
 //			LOG4CXX_DEBUG(logger_, "New extended timestamp [" << std::dec << *current_course_timestamp << "]");
           }
@@ -1,6 +1,9 @@
 //
 // Created by gnx91527 on 06/08/18.
 //
+#include <algorithm>
+#include <time.h>
+
 #include "LATRDDefinitions.h"
 #include "LATRDProcessIntegral.h"
 #include "LATRDExceptions.h"
@@ -9,15 +12,29 @@ namespace FrameProcessor {
   LATRDProcessIntegral::LATRDProcessIntegral() :
       width_(0),
       height_(0),
-      base_image_counter_(0),
+      depth_(16),
       total_count_(0),
       next_frame_id_(1),
-      next_packet_id_(0)
+      next_packet_id_(0),
+      huge_pages_(false),
+      ring_started_(false),
+      oldest_image_(0),
+      end_image_(0),
+      late_packets_(0),
+      forced_images_(0),
+      dropped_words_(0),
+      output_full_(true),
+      output_sum_(0),
+      output_bin_(1),
+      output_live_rate_(0),
+      metaPtr_(0)
   {
     // Setup logging for the class
     logger_ = Logger::getLogger("FP.LATRDProcessIntegral");
     logger_->setLevel(Level::getAll());
     LOG4CXX_TRACE(logger_, "LATRDProcessIntegral constructor.");
+    // Packets are decoded on the calling thread until a task pool is set
+    this->set_task_pool(boost::shared_ptr<LATRDTaskPool>());
 
   }
 
@@ -25,21 +42,89 @@ namespace FrameProcessor {
   {
   }
 
-  void LATRDProcessIntegral::init(uint32_t width, uint32_t height) {
+  void LATRDProcessIntegral::init(uint32_t width, uint32_t height, uint32_t depth, bool huge_pages) {
+    if (depth != 16 && depth != 32){
+      throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+    }
     width_ = width;
     height_ = height;
+    depth_ = depth;
+    huge_pages_ = huge_pages;
     next_frame_id_ = 1;
     next_packet_id_ = 0;
-    if (image_ptr_){
-      free(image_ptr_);
+    // Images already in flight have the old dimensions so they are discarded.  The images of
+    // every slot are allocated and faulted in together so none are created while processing
+    image_ring_.assign(integral_image_slots, boost::shared_ptr<LATRDImageJob>());
+    image_pool_.reset();
+    size_t image_stride = width_ * height_ * (depth_ / 8);
+    image_stride = ((image_stride + integral_image_alignment - 1) / integral_image_alignment) * integral_image_alignment;
+    image_pool_ = boost::shared_ptr<LATRDMemoryBlock>(new LATRDMemoryBlock(image_stride * integral_image_slots,
+                                                                           huge_pages_,
+                                                                           integral_image_alignment));
+    for (size_t slot = 0; slot < integral_image_slots; slot++){
+      image_ring_[slot] = boost::shared_ptr<LATRDImageJob>(new LATRDImageJob(width_, height_, 0, depth_,
+                                                                             image_pool_, slot * image_stride));
+    }
+    slot_active_.assign(integral_image_slots, false);
+    ring_started_ = false;
+    this->assign_bands();
+    // Reduced images depend upon the sensor size and depth
+    this->configure_output(output_full_, output_sum_, output_bin_, output_live_rate_);
+    {
+      boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+      if (flat_field_ && (flat_field_->width() != width_ || flat_field_->height() != height_)){
+        LOG4CXX_DEBUG(logger_, "Sensor size changed, flat field correction removed");
+        flat_field_.reset();
+      }
+      if (rois_ && (rois_->width() != width_ || rois_->height() != height_)){
+        LOG4CXX_DEBUG(logger_, "Sensor size changed, regions of interest removed");
+        rois_.reset();
+      }
+    }
+  }
+
+  void LATRDProcessIntegral::register_meta_message_publisher(MetaMessagePublisher *ptr)
+  {
+    metaPtr_ = ptr;
+  }
+
+  void LATRDProcessIntegral::configure_rois(boost::shared_ptr<LATRDRoiIntegrator> rois)
+  {
+    boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+    rois_ = rois;
+  }
+
+  void LATRDProcessIntegral::configure_flat_field(boost::shared_ptr<LATRDFlatField> flat_field)
+  {
+    if (flat_field && (flat_field->width() != width_ || flat_field->height() != height_)){
+      throw LATRDProcessingException("Flat field does not match the sensor size");
+    }
+    boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+    flat_field_ = flat_field;
+  }
+
+  void LATRDProcessIntegral::configure_output(bool full, uint32_t sum_images, uint32_t bin, uint32_t live_rate)
+  {
+    boost::shared_ptr<LATRDImageReducer> reducer;
+    if (sum_images > 0 || live_rate > 0){
+      // Throws if the binning is not supported, leaving the current outputs in place
+      reducer = boost::shared_ptr<LATRDImageReducer>(new LATRDImageReducer(width_, height_, depth_, sum_images, bin,
+                                                                           live_rate > 0 ? 1000000 / live_rate : 0));
     }
-    image_ptr_ = (uint16_t *)malloc(width_ * height_ * sizeof(uint16_t));
+    boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+    reducer_ = reducer;
+    output_full_ = full;
+    output_sum_ = sum_images;
+    output_bin_ = bin;
+    output_live_rate_ = live_rate;
   }
 
   void LATRDProcessIntegral::reset_image()
   {
     LOG4CXX_DEBUG(logger_, "Resetting image memory");
-    memset(image_ptr_, 0, (width_ * height_ * sizeof(uint16_t)));
+    if (image_pool_){
+      memset(image_pool_->data(), 0, image_pool_->bytes());
+    }
     total_count_ = 0;
   }
 
@@ -55,25 +140,27 @@ namespace FrameProcessor {
       LOG4CXX_DEBUG(logger_, "Count mode IDLE frame detected");
 
       // This is an idle frame
-      // First we need to process any outstanding image frames, and then reset the image counter
-      uint32_t image_counter = base_image_counter_ - 1;
-      std::map<uint64_t, boost::shared_ptr<LATRDImageJob> >::iterator iter;
-      for (iter = image_store_.begin(); iter != image_store_.end(); ++iter){
-        image_counter++;
-          if (!iter->second->get_sent()) {
-            LOG4CXX_DEBUG(logger_,
-                          "Creating image frame " << iter->second->get_frame_number() << " from raw buffer " << frame->get_frame_number());
-            boost::shared_ptr<Frame> out_frame = iter->second->to_frame();
-            image_frames.push_back(out_frame);
-
-            iter->second->mark_sent();
-          }
-          iter->second->reset();
+      // First we need to send any outstanding images in order, and then restart the image numbers
+      while (ring_started_ && oldest_image_ != end_image_){
+        size_t slot = oldest_image_ % integral_image_slots;
+        if (slot_active_[slot]){
+          LOG4CXX_DEBUG(logger_, "Creating image frame " << image_ring_[slot]->get_frame_number()
+                                 << " from raw buffer " << frame->get_frame_number());
+          this->send_image(image_ring_[slot], image_frames);
+        }
+        this->release_oldest_image();
+      }
+      ring_started_ = false;
+      // A partial sum holds the last images of the acquisition
+      boost::shared_ptr<LATRDImageReducer> reducer;
+      {
+        boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+        reducer = reducer_;
+      }
+      if (reducer){
+        std::vector<boost::shared_ptr<Frame> > reduced = reducer->flush();
+        image_frames.insert(image_frames.end(), reduced.begin(), reduced.end());
       }
-      image_store_.clear();
-
-      // and reset the image counter
-      base_image_counter_ = 0;
       // and reset the expected frame ID
       next_frame_id_ = 1;
 
@@ -95,128 +182,338 @@ namespace FrameProcessor {
     // Number of packet header 64bit words
     uint16_t packet_header_count = (LATRD::packet_header_size / sizeof(uint64_t)) - 1;
 
-    int dropped_packets = 0;
-    // Loop over each packet
+    // The packet headers are walked in order to place each packet into its image, and the
+    // data words are then decoded and accumulated by the task pool workers
+    pending_.clear();
     for (int index = 0; index < LATRD::num_primary_packets; index++) {
       // Ignore first header word as it is not used.
       packet_header.headerWord1 = *(((uint64_t *) payload_ptr) + 1);
       packet_header.headerWord2 = *(((uint64_t *) payload_ptr) + 2);
 
-      if (hdrPtr->packet_state[index] == 0) {
-        dropped_packets += 1;
-      } else {
-        // Walk through each data word
+      if (hdrPtr->packet_state[index] != 0) {
         uint16_t word_count = LATRD::get_word_count(packet_header.headerWord1);
         uint32_t packet_id = LATRD::get_packet_number(packet_header.headerWord2);
         uint32_t image_number = LATRD::get_image_number(packet_header.headerWord2);
-        // Ignore the first 0x00000000 which is not used
-        uint64_t *data_word_ptr = (((uint64_t *) payload_ptr) + 1 + packet_header_count);
-
-        uint64_t packet_timestamp = get_course_timestamp(*data_word_ptr);
-        LOG4CXX_DEBUG(logger_, "Pkt [" << packet_id << "] timestamp [" << packet_timestamp << "] word count " << word_count);
-        data_word_ptr++;
 
-        // Check if we have an image job for this packet's timestamp
-        boost::shared_ptr<LATRDImageJob> image_job_ptr;
-        if (image_store_.count(packet_timestamp) > 0){
-          image_job_ptr = image_store_[packet_timestamp];
-        } else {
-          // We need to create a new image job for this packet
-          // TODO: Check this is not an old packet
-          image_job_ptr = boost::shared_ptr<LATRDImageJob>(new LATRDImageJob(width_, height_, image_number));
-          // Store the image job in the store, index by timestamp
-          image_store_[packet_timestamp] = image_job_ptr;
+        // An image sent early to make room must hold every packet before this one
+        if (this->image_forces_send(image_number)){
+          this->accumulate_pending();
         }
-
-        // Start from index 3 as we can ignore the header words and extended timestamp
-        for (uint16_t index = 3; index < word_count; index++) {
-          uint32_t x_pos = 0;
-          uint32_t y_pos = 0;
-          uint32_t i_tot = 0;
-          uint32_t event_count = 0;
-          uint32_t e_tot = 0;
-          try {
-              // Check if the word is a final packet word
-            if (check_for_final_packet_word(*data_word_ptr)) {
-                LOG4CXX_DEBUG(logger_, "Image [" << image_job_ptr->get_frame_number() << "] End Of Image on packet [" << packet_id << "]");
-                image_job_ptr->set_eoi(packet_id);
-            } else {
-              if (process_data_word(*data_word_ptr,
-                                    &x_pos,
-                                    &y_pos,
-                                    &i_tot,
-                                    &event_count)) {
-                // Add the event count to the 2D image
-                image_job_ptr->add_pixel(packet_id, x_pos, y_pos, event_count);
-                total_count_ += event_count;
-              }
-            }
-            /*
-            // Check if the frame is valid
-            if (image_job_ptr->verify_image()) {
-              //LOG4CXX_DEBUG(logger_, "  =>  Image total count " << total_count_);
-                // Calculate the image number for this image.
-                // The image number is the base_image_counter_ + the index of the frame in the map
-                uint32_t image_counter = base_image_counter_ - 1;
-                std::map<uint64_t, boost::shared_ptr<LATRDImageJob> >::iterator iter;
-                for (iter = image_store_.begin(); iter != image_store_.end(); ++iter) {
-                    image_counter++;
-                    if (packet_timestamp == iter->first){
-                        break;
-                    }
-                }
-
-                LOG4CXX_DEBUG(logger_,
-                              "Pkt [" << packet_id << "] Creating image frame " << image_counter << " from raw buffer "
-                                      << frame->get_frame_number());
-                boost::shared_ptr<Frame> out_frame = image_job_ptr->to_frame(image_counter);
-              image_frames.push_back(out_frame);
-
-              image_job_ptr->reset();
-            }*/
-          }
-          catch (LATRDProcessingException &ex){
-            // TODO: What to do here if there is an exception
-          }
-          data_word_ptr++;
+        // Find the slot of the image this packet belongs to
+        boost::shared_ptr<LATRDImageJob> image_job_ptr = this->image_slot(image_number, image_frames);
+        if (!image_job_ptr){
+          LOG4CXX_DEBUG(logger_, "Pkt [" << packet_id << "] for image [" << image_number << "] arrived after the image was sent");
+          late_packets_++;
+        } else {
+          // The packet is recorded once, whether or not it holds any counts
+          image_job_ptr->add_packet(packet_id);
+          LATRDIntegralPacket packet;
+          packet.slot = image_number % integral_image_slots;
+          packet.packet_id = packet_id;
+          // Ignore the first 0x00000000 which is not used, and the extended timestamp that follows
+          packet.data_ptr = ((uint64_t *) payload_ptr) + 2 + packet_header_count;
+          // Start from index 3 as we can ignore the header words and extended timestamp
+          packet.data_words = (word_count > 3) ? (word_count - 3) : 0;
+          packet.eoi = false;
+          pending_.push_back(packet);
         }
       }
       // Increment the payload pointer to the next packet
       payload_ptr += LATRD::primary_packet_size;
     }
-    // After processing all of the packets, loop through the job map and see if we can pass out any frames
-    uint32_t image_counter = base_image_counter_ - 1;
-    std::vector<uint64_t> delete_image_vector;
-    std::map<uint64_t, boost::shared_ptr<LATRDImageJob> >::iterator iter;
-    for (iter = image_store_.begin(); iter != image_store_.end(); ++iter){
-        image_counter++;
-        if (iter->second->verify_image()){
-          if (!iter->second->get_sent()) {
-            LOG4CXX_DEBUG(logger_,
-                          "Creating image frame " << iter->second->get_frame_number() << " from raw buffer " << frame->get_frame_number());
-            boost::shared_ptr<Frame> out_frame = iter->second->to_frame();
-            image_frames.push_back(out_frame);
-
-            iter->second->mark_sent();
+    this->accumulate_pending();
+
+    // After processing all of the packets, pass out any complete images
+    this->release_images(image_frames);
+
+    return image_frames;
+  }
+
+  void LATRDProcessIntegral::set_task_pool(boost::shared_ptr<LATRDTaskPool> pool)
+  {
+    task_pool_ = pool;
+    size_t partitions = pool ? std::max((size_t)1, pool->size()) : 1;
+    counts_.assign(partitions, std::vector<std::vector<LATRDIntegralCount> >(partitions));
+    partition_totals_.assign(partitions, 0);
+    partition_dropped_.assign(partitions, 0);
+    this->assign_bands();
+  }
+
+  void LATRDProcessIntegral::assign_bands()
+  {
+    // Each band is a run of whole rows, so no two workers write the same pixel
+    size_t bands = counts_.size();
+    row_band_.resize(height_);
+    for (uint32_t row = 0; row < height_; row++){
+      row_band_[row] = (uint16_t)(((size_t)row * bands) / height_);
+    }
+  }
+
+  void LATRDProcessIntegral::decode_packets(size_t partition, size_t begin, size_t end)
+  {
+    std::vector<std::vector<LATRDIntegralCount> >& bands = counts_[partition];
+    for (size_t band = 0; band < bands.size(); band++){
+      bands[band].clear();
+    }
+    uint64_t total = 0;
+    uint64_t dropped = 0;
+    for (size_t index = begin; index < end; index++){
+      LATRDIntegralPacket& packet = pending_[index];
+      const uint64_t *data_word_ptr = packet.data_ptr;
+      for (uint16_t word = 0; word < packet.data_words; word++) {
+        uint32_t x_pos = 0;
+        uint32_t y_pos = 0;
+        uint32_t i_tot = 0;
+        uint32_t event_count = 0;
+        // Check if the word is a final packet word
+        if (check_for_final_packet_word(*data_word_ptr)) {
+          packet.eoi = true;
+        } else if (process_data_word(*data_word_ptr, &x_pos, &y_pos, &i_tot, &event_count)) {
+          // A position outside the sensor would be written into another row or image, so it is dropped
+          if (x_pos < width_ && y_pos < height_) {
+            LATRDIntegralCount count;
+            count.pixel = x_pos + (y_pos * width_);
+            count.slot = packet.slot;
+            count.count = (uint16_t)event_count;
+            bands[row_band_[y_pos]].push_back(count);
+            total += event_count;
+          } else {
+            dropped++;
           }
-          // Mark the frame for deletion
-          delete_image_vector.push_back(iter->first);
         }
+        data_word_ptr++;
+      }
     }
-    std::vector<uint64_t>::iterator del_iter;
-    for (del_iter = delete_image_vector.begin(); del_iter != delete_image_vector.end(); ++del_iter){
-        if (image_store_.begin()->first == *del_iter){
-            // Reset the job
-            image_store_[*del_iter]->reset();
-            // Delete the job
-            image_store_.erase(*del_iter);
-            // Increment the base
-            base_image_counter_++;
-        }
+    partition_totals_[partition] = total;
+    partition_dropped_[partition] = dropped;
+  }
+
+  void LATRDProcessIntegral::accumulate_band(size_t band)
+  {
+    if (depth_ == 32){
+      this->accumulate_counts<uint32_t>(band);
+    } else {
+      this->accumulate_counts<uint16_t>(band);
     }
+  }
 
+  template <typename T> void LATRDProcessIntegral::accumulate_counts(size_t band)
+  {
+    // Counts are added in partition order, although saturating addition gives the same image in any order.
+    // Consecutive counts almost always belong to the same image so the image is cached
+    T *images[integral_image_slots];
+    for (size_t slot = 0; slot < integral_image_slots; slot++){
+      images[slot] = (T *)image_ring_[slot]->image_ptr_;
+    }
+    for (size_t partition = 0; partition < counts_.size(); partition++){
+      const std::vector<LATRDIntegralCount>& counts = counts_[partition][band];
+      size_t count_qty = counts.size();
+      for (size_t index = 0; index < count_qty; index++){
+        saturating_add(images[counts[index].slot][counts[index].pixel], counts[index].count);
+      }
+    }
+  }
 
-    return image_frames;
+  void LATRDProcessIntegral::accumulate_pending()
+  {
+    if (pending_.empty()){
+      return;
+    }
+    size_t partitions = counts_.size();
+    if (task_pool_ && partitions > 1 && pending_.size() > 1){
+      // Each worker decodes a share of the packets into counts sorted by band, then adds one band into the images
+      std::vector<boost::shared_ptr<LATRDTask> > tasks;
+      for (size_t partition = 0; partition < partitions; partition++){
+        boost::shared_ptr<LATRDIntegralDecodeTask> task(new LATRDIntegralDecodeTask(this, partition,
+                                                                                     (pending_.size() * partition) / partitions,
+                                                                                     (pending_.size() * (partition + 1)) / partitions));
+        tasks.push_back(task);
+      }
+      task_pool_->run(tasks);
+      tasks.clear();
+      for (size_t band = 0; band < partitions; band++){
+        tasks.push_back(boost::shared_ptr<LATRDTask>(new LATRDIntegralAccumulateTask(this, band)));
+      }
+      task_pool_->run(tasks);
+    } else {
+      for (size_t partition = 0; partition < partitions; partition++){
+        this->decode_packets(partition, (pending_.size() * partition) / partitions,
+                             (pending_.size() * (partition + 1)) / partitions);
+      }
+      for (size_t band = 0; band < partitions; band++){
+        this->accumulate_band(band);
+      }
+    }
+    for (size_t partition = 0; partition < partitions; partition++){
+      total_count_ += partition_totals_[partition];
+      dropped_words_ += partition_dropped_[partition];
+    }
+    // End of image words are applied in packet order
+    for (size_t index = 0; index < pending_.size(); index++){
+      if (pending_[index].eoi){
+        LOG4CXX_DEBUG(logger_, "Image [" << image_ring_[pending_[index].slot]->get_frame_number()
+                               << "] End Of Image on packet [" << pending_[index].packet_id << "]");
+        image_ring_[pending_[index].slot]->set_eoi(pending_[index].packet_id);
+      }
+    }
+    pending_.clear();
+  }
+
+  bool LATRDProcessIntegral::image_forces_send(uint32_t image_number)
+  {
+    if (!ring_started_){
+      return false;
+    }
+    uint32_t distance = (image_number - oldest_image_) & integral_image_number_mask;
+    return distance < integral_image_number_late && distance >= integral_image_slots;
+  }
+
+  boost::shared_ptr<LATRDImageJob> LATRDProcessIntegral::image_slot(uint32_t image_number,
+                                                                    std::vector<boost::shared_ptr<Frame> >& frames)
+  {
+    // The first image seen after a reset becomes the oldest image in flight
+    if (!ring_started_){
+      oldest_image_ = image_number;
+      end_image_ = image_number;
+      ring_started_ = true;
+    }
+    uint32_t distance = (image_number - oldest_image_) & integral_image_number_mask;
+    if (distance >= integral_image_number_late){
+      // The image has already been sent
+      return boost::shared_ptr<LATRDImageJob>();
+    }
+    // If the ring is full the oldest images are sent incomplete to make room
+    while (distance >= integral_image_slots){
+      size_t slot = oldest_image_ % integral_image_slots;
+      if (slot_active_[slot]){
+        LOG4CXX_DEBUG(logger_, "Image ring full, sending incomplete image " << image_ring_[slot]->get_frame_number());
+        this->send_image(image_ring_[slot], frames);
+        forced_images_++;
+      }
+      this->release_oldest_image();
+      distance--;
+    }
+    if (distance >= ((end_image_ - oldest_image_) & integral_image_number_mask)){
+      end_image_ = (image_number + 1) & integral_image_number_mask;
+    }
+    size_t slot = image_number % integral_image_slots;
+    if (!slot_active_[slot]){
+      image_ring_[slot]->set_frame_number(image_number);
+      slot_active_[slot] = true;
+    } else if (image_ring_[slot]->get_sent()){
+      // The image is held until the older images are sent, but its counts have already gone out
+      return boost::shared_ptr<LATRDImageJob>();
+    }
+    return image_ring_[slot];
+  }
+
+  void LATRDProcessIntegral::send_image(boost::shared_ptr<LATRDImageJob> image,
+                                        std::vector<boost::shared_ptr<Frame> >& frames)
+  {
+    if (!image->get_sent()){
+      // The outputs are taken together so that a configuration change applies from the next image
+      bool output_full;
+      boost::shared_ptr<LATRDFlatField> flat_field;
+      boost::shared_ptr<LATRDRoiIntegrator> rois;
+      boost::shared_ptr<LATRDImageReducer> reducer;
+      {
+        boost::lock_guard<boost::mutex> lock(outputs_mutex_);
+        output_full = output_full_;
+        flat_field = flat_field_;
+        rois = rois_;
+        reducer = reducer_;
+      }
+      // The full resolution image is only copied out if it is wanted
+      if (output_full){
+        frames.push_back(image->to_frame());
+      }
+      if (flat_field){
+        frames.push_back(flat_field->correct(image->image_ptr_, depth_, image->get_frame_number()));
+      }
+      if (rois && rois->rois() > 0){
+        this->publish_roi_meta_data(rois, image);
+      }
+      if (reducer){
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_us = ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+        std::vector<boost::shared_ptr<Frame> > reduced = reducer->add_image(image->image_ptr_,
+                                                                            image->get_frame_number(),
+                                                                            now_us);
+        frames.insert(frames.end(), reduced.begin(), reduced.end());
+      }
+      image->mark_sent();
+    }
+  }
+
+  void LATRDProcessIntegral::publish_roi_meta_data(boost::shared_ptr<LATRDRoiIntegrator> rois,
+                                                   boost::shared_ptr<LATRDImageJob> image)
+  {
+    if (metaPtr_){
+      // The image number is followed by the integrated counts of each region
+      std::vector<uint64_t> sums(rois->rois() + 1, 0);
+      sums[0] = image->get_frame_number();
+      rois->integrate(image->image_ptr_, depth_, &sums[1]);
+
+      rapidjson::Document meta_document;
+      meta_document.SetObject();
+      rapidjson::Value key_rois("rois", meta_document.GetAllocator());
+      rapidjson::Value value_rois;
+      value_rois.SetUint((uint32_t)rois->rois());
+      meta_document.AddMember(key_rois, value_rois, meta_document.GetAllocator());
+
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      meta_document.Accept(writer);
+
+      metaPtr_->publish_meta("latrd",
+                             "roi_intensity",
+                             &sums[0],
+                             sums.size() * sizeof(uint64_t),
+                             buffer.GetString());
+    }
+  }
+
+  void LATRDProcessIntegral::release_oldest_image()
+  {
+    // The slot is cleared ready for the image number one ring length ahead
+    size_t slot = oldest_image_ % integral_image_slots;
+    if (slot_active_[slot]){
+      image_ring_[slot]->reset();
+      slot_active_[slot] = false;
+    }
+    oldest_image_ = (oldest_image_ + 1) & integral_image_number_mask;
+  }
+
+  void LATRDProcessIntegral::release_images(std::vector<boost::shared_ptr<Frame> >& frames)
+  {
+    if (!ring_started_){
+      return;
+    }
+    // Complete images are sent as soon as they are verified, in image number order
+    uint32_t in_flight = (end_image_ - oldest_image_) & integral_image_number_mask;
+    for (uint32_t index = 0; index < in_flight; index++){
+      size_t slot = (oldest_image_ + index) % integral_image_slots;
+      if (slot_active_[slot] && image_ring_[slot]->verify_image()){
+        LOG4CXX_DEBUG(logger_, "Creating image frame " << image_ring_[slot]->get_frame_number());
+        this->send_image(image_ring_[slot], frames);
+      }
+    }
+    // Slots are only freed from the oldest image, so late packets of an image still held can be counted
+    while (oldest_image_ != end_image_){
+      size_t slot = oldest_image_ % integral_image_slots;
+      if (slot_active_[slot] && !image_ring_[slot]->get_sent()){
+        break;
+      }
+      this->release_oldest_image();
+    }
+  }
+
+  void LATRDProcessIntegral::get_statistics(uint64_t *late_packets, uint64_t *forced_images, uint64_t *dropped_words)
+  {
+    *late_packets = late_packets_;
+    *forced_images = forced_images_;
+    *dropped_words = dropped_words_;
   }
 
   bool LATRDProcessIntegral::process_data_word(uint64_t data_word,
@@ -265,4 +562,28 @@ namespace FrameProcessor {
     return false;
   }
 
+  LATRDIntegralDecodeTask::LATRDIntegralDecodeTask(LATRDProcessIntegral *integral, size_t partition, size_t begin, size_t end) :
+      integral(integral),
+      partition(partition),
+      begin(begin),
+      end(end)
+  {
+  }
+
+  void LATRDIntegralDecodeTask::execute()
+  {
+    integral->decode_packets(partition, begin, end);
+  }
+
+  LATRDIntegralAccumulateTask::LATRDIntegralAccumulateTask(LATRDProcessIntegral *integral, size_t band) :
+      integral(integral),
+      band(band)
+  {
+  }
+
+  void LATRDIntegralAccumulateTask::execute()
+  {
+    integral->accumulate_band(band);
+  }
+
 }
\ No newline at end of file
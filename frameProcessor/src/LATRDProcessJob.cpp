@@ -6,61 +6,108 @@
  */
 
 #include "LATRDProcessJob.h"
+#include "LATRDEventCodec.h"
+#include "LATRDExceptions.h"
 #include <stdio.h>
 namespace FrameProcessor {
 
 LATRDProcessJob::LATRDProcessJob(size_t size) :
-		time_slice(0),
-		data_ptr(0),
-		job_id(0),
-		packet_number(0),
-		valid_control_words(0),
-		timestamp_mismatches(0),
-		words_to_process(0),
-		valid_results(0)
+		pool_group(0)
 {
-	// Allocate all memory required for stores
-	event_ts_ptr = (uint64_t *)malloc(size * sizeof(uint64_t));
-	event_id_ptr = (uint32_t *)malloc(size * sizeof(uint32_t));
-	event_energy_ptr = (uint32_t *)malloc(size * sizeof(uint32_t));
-    ctrl_word_ts_ptr = (uint64_t *)malloc(size * sizeof(uint64_t));
-    ctrl_word_id_ptr = (uint16_t *)malloc(size * sizeof(uint16_t));
-	ctrl_index_ptr = (uint32_t *)malloc(size * sizeof(uint32_t));
+	reset();
+	// Allocate a single region for all of the stores
+	block_ = boost::shared_ptr<LATRDMemoryBlock>(new LATRDMemoryBlock(storage_size(size), false, job_array_alignment));
+	assign_storage(size, (uint8_t *)block_->data());
+}
+
+LATRDProcessJob::LATRDProcessJob(size_t size, uint8_t *storage) :
+		pool_group(0)
+{
+	reset();
+	// The stores are placed within a region owned by the caller
+	assign_storage(size, storage);
 }
 
 LATRDProcessJob::~LATRDProcessJob()
 {
-	// Free all of the previously allocated memory
-	if (event_ts_ptr){
-		free(event_ts_ptr);
-	}
-	if (event_id_ptr){
-		free(event_id_ptr);
-	}
-	if (event_energy_ptr){
-		free(event_energy_ptr);
-	}
-    if (ctrl_word_ts_ptr){
-        free(ctrl_word_ts_ptr);
-    }
-    if (ctrl_word_id_ptr){
-        free(ctrl_word_id_ptr);
-    }
-	if (ctrl_index_ptr){
-		free(ctrl_index_ptr);
-	}
 }
 
 void LATRDProcessJob::reset()
 {
 	time_slice = 0;
+	producer_id = 0;
+	geometry_output = 0;
+	energy_output = 0;
+	energy_fraction_bits = 0;
 	data_ptr = 0;
     job_id = 0;
     packet_number = 0;
 	valid_control_words = 0;
 	timestamp_mismatches = 0;
+	energy_rejects = 0;
+	roi_rejects = 0;
+	mask_rejects = 0;
 	words_to_process = 0;
 	valid_results = 0;
+	packed_size = 0;
+	ts_min = empty_ts_min;
+	ts_max = 0;
+}
+
+uint32_t *LATRDProcessJob::pixel_ids()
+{
+	// Consumers of the pixel positions work in the coordinates of the sensor image
+	return geometry_output == 0 ? event_id_ptr : event_image_id_ptr;
+}
+
+static size_t align_array(size_t bytes)
+{
+	return ((bytes + job_array_alignment - 1) / job_array_alignment) * job_array_alignment;
+}
+
+size_t LATRDProcessJob::storage_size(size_t size)
+{
+	return align_array(size * sizeof(uint64_t)) +      // event_ts_ptr
+	       align_array(size * sizeof(uint32_t)) * 4 +  // event_id_ptr, event_energy_ptr, event_pixel_ptr, event_image_id_ptr
+	       align_array(size * sizeof(uint16_t)) * 2 +  // event_x_ptr, event_y_ptr
+	       align_array(size * sizeof(uint64_t)) +      // ctrl_word_ts_ptr
+	       align_array(size * sizeof(uint16_t)) +      // ctrl_word_id_ptr
+	       align_array(size * sizeof(uint32_t)) +      // ctrl_index_ptr
+	       align_array(size * sizeof(uint64_t)) +      // ctrl_event_index_ptr
+	       align_array(LATRDEventCodec::varint_bound(size)); // event_packed_ptr
+}
+
+void LATRDProcessJob::assign_storage(size_t size, uint8_t *storage)
+{
+	if (!storage){
+		throw LATRDProcessingException("Unable to allocate storage for processing job");
+	}
+	// Carve the stores out of the region in the same order as storage_size
+	uint8_t *ptr = storage;
+	event_ts_ptr = (uint64_t *)ptr;
+	ptr += align_array(size * sizeof(uint64_t));
+	event_id_ptr = (uint32_t *)ptr;
+	ptr += align_array(size * sizeof(uint32_t));
+	event_energy_ptr = (uint32_t *)ptr;
+	ptr += align_array(size * sizeof(uint32_t));
+	event_pixel_ptr = (uint32_t *)ptr;
+	ptr += align_array(size * sizeof(uint32_t));
+	event_image_id_ptr = (uint32_t *)ptr;
+	ptr += align_array(size * sizeof(uint32_t));
+	event_x_ptr = (uint16_t *)ptr;
+	ptr += align_array(size * sizeof(uint16_t));
+	event_y_ptr = (uint16_t *)ptr;
+	ptr += align_array(size * sizeof(uint16_t));
+	ctrl_word_ts_ptr = (uint64_t *)ptr;
+	ptr += align_array(size * sizeof(uint64_t));
+	ctrl_word_id_ptr = (uint16_t *)ptr;
+	ptr += align_array(size * sizeof(uint16_t));
+	ctrl_index_ptr = (uint32_t *)ptr;
+	ptr += align_array(size * sizeof(uint32_t));
+	ctrl_event_index_ptr = (uint64_t *)ptr;
+	ptr += align_array(size * sizeof(uint64_t));
+	// Packed event store is large enough for either of the packed output formats
+	event_packed_ptr = ptr;
 }
 
 } /* namespace FrameProcessor */
@@ -11,6 +11,11 @@
 
 namespace FrameProcessor
 {
+/** Raw mode values, packets are recorded alone or alongside the processed output */
+static const uint32_t raw_mode_off  = 0;
+static const uint32_t raw_mode_only = 1;
+static const uint32_t raw_mode_dual = 2;
+
 const std::string LATRDProcessPlugin::META_NAME                  = "TristanProcessor";
 
 const std::string LATRDProcessPlugin::CONFIG_MODE                = "mode";
@@ -19,21 +24,110 @@ const std::string LATRDProcessPlugin::CONFIG_MODE_TIME_ONLY      = "time_only";
 const std::string LATRDProcessPlugin::CONFIG_MODE_COUNT          = "count";
 
 const std::string LATRDProcessPlugin::CONFIG_RAW_MODE            = "raw_mode";
+const std::string LATRDProcessPlugin::CONFIG_HUGE_PAGES          = "huge_pages";
+const std::string LATRDProcessPlugin::CONFIG_NUMA                = "numa";
 
 const std::string LATRDProcessPlugin::CONFIG_RESET_FRAME         = "reset_frame";
 
 const std::string LATRDProcessPlugin::CONFIG_PROCESS             = "process";
+const std::string LATRDProcessPlugin::CONFIG_FRAME_COUNTER       = "frame_counter";
 const std::string LATRDProcessPlugin::CONFIG_PROCESS_NUMBER      = "number";
 const std::string LATRDProcessPlugin::CONFIG_PROCESS_RANK        = "rank";
 
 const std::string LATRDProcessPlugin::CONFIG_SENSOR              = "sensor";
 const std::string LATRDProcessPlugin::CONFIG_SENSOR_WIDTH        = "width";
 const std::string LATRDProcessPlugin::CONFIG_SENSOR_HEIGHT       = "height";
+const std::string LATRDProcessPlugin::CONFIG_SENSOR_DEPTH        = "depth";
+
+const std::string LATRDProcessPlugin::CONFIG_COMPRESSION         = "compression";
+const std::string LATRDProcessPlugin::CONFIG_COMPRESSION_TYPE    = "type";
+const std::string LATRDProcessPlugin::CONFIG_COMPRESSION_NONE    = "none";
+const std::string LATRDProcessPlugin::CONFIG_COMPRESSION_BSLZ4   = "bslz4";
+const std::string LATRDProcessPlugin::CONFIG_COMPRESSION_DELTA   = "delta";
+const std::string LATRDProcessPlugin::CONFIG_EVENT_FORMAT        = "event_format";
+const std::string LATRDProcessPlugin::CONFIG_HISTOGRAMS          = "histograms";
+const std::string LATRDProcessPlugin::CONFIG_HISTOGRAMS_ENABLE   = "enable";
+const std::string LATRDProcessPlugin::CONFIG_HISTOGRAMS_MODULES  = "modules";
+const std::string LATRDProcessPlugin::CONFIG_HISTOGRAMS_CADENCE  = "cadence";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_BINS          = "image_bins";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_BINS_ENABLE   = "enable";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_BINS_WIDTH    = "bin_width";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT        = "image_output";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_FULL   = "full";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_SUM    = "sum";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_BIN    = "bin";
+const std::string LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_LIVE_RATE = "live_rate";
+const std::string LATRDProcessPlugin::CONFIG_CLUSTERING          = "clustering";
+const std::string LATRDProcessPlugin::CONFIG_CLUSTERING_ENABLE   = "enable";
+const std::string LATRDProcessPlugin::CONFIG_CLUSTERING_WINDOW   = "window";
+const std::string LATRDProcessPlugin::CONFIG_JOB_POOL            = "job_pool";
+const std::string LATRDProcessPlugin::CONFIG_JOB_POOL_SIZE       = "size";
+const std::string LATRDProcessPlugin::CONFIG_FILTER              = "filter";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MIN   = "energy_min";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MAX   = "energy_max";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ROI_X        = "roi_x";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ROI_Y        = "roi_y";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ROI_WIDTH    = "roi_width";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ROI_HEIGHT   = "roi_height";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_ROI_FILE     = "roi_file";
+const std::string LATRDProcessPlugin::CONFIG_FILTER_MASK_FILE    = "mask_file";
+const std::string LATRDProcessPlugin::CONFIG_GEOMETRY            = "geometry";
+const std::string LATRDProcessPlugin::CONFIG_GEOMETRY_FILE       = "layout_file";
+const std::string LATRDProcessPlugin::CONFIG_GEOMETRY_OUTPUT     = "output";
+const std::string LATRDProcessPlugin::CONFIG_GEOMETRY_INDEX      = "index";
+const std::string LATRDProcessPlugin::CONFIG_GEOMETRY_XY         = "xy";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION         = "calibration";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION_FILE    = "file";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION_OUTPUT  = "output";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION_FLOAT   = "float";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION_FIXED   = "fixed";
+const std::string LATRDProcessPlugin::CONFIG_CALIBRATION_FRACTION_BITS = "fraction_bits";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD          = "flat_field";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_GAIN_FILE = "gain_file";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_MASK_FILE = "mask_file";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_OUTPUT   = "output";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_FLOAT    = "float";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_FIXED    = "fixed";
+const std::string LATRDProcessPlugin::CONFIG_FLAT_FIELD_FRACTION_BITS = "fraction_bits";
+const std::string LATRDProcessPlugin::CONFIG_ROI                 = "roi";
+const std::string LATRDProcessPlugin::CONFIG_ROI_REGIONS         = "regions";
+const std::string LATRDProcessPlugin::CONFIG_EVENT_FORMAT_COLUMNS = "columns";
+const std::string LATRDProcessPlugin::CONFIG_EVENT_FORMAT_PACKED = "packed";
+const std::string LATRDProcessPlugin::CONFIG_EVENT_FORMAT_VARINT = "varint";
 
   LATRDProcessPlugin::LATRDProcessPlugin() :
     sensor_width_(256),
     sensor_height_(256),
+    sensor_depth_(16),
     mode_(CONFIG_MODE_TIME_ENERGY),
+    compression_type_(CONFIG_COMPRESSION_NONE),
+    compression_delta_(0),
+    event_format_(CONFIG_EVENT_FORMAT_COLUMNS),
+    histograms_enable_(0),
+    histograms_modules_(0),
+    histograms_cadence_(1),
+    image_bins_enable_(0),
+    image_bins_width_(1000000),
+    image_output_full_(1),
+    image_output_sum_(0),
+    image_output_bin_(1),
+    image_output_live_rate_(0),
+    clustering_enable_(0),
+    clustering_window_(320),
+    job_pool_size_(LATRD::num_primary_packets * 2),
+    huge_pages_(0),
+    numa_(0),
+    filter_energy_min_(0),
+    filter_energy_max_(0),
+    filter_roi_x_(0),
+    filter_roi_y_(0),
+    filter_roi_width_(0),
+    filter_roi_height_(0),
+    geometry_output_(CONFIG_GEOMETRY_INDEX),
+    calibration_output_(CONFIG_CALIBRATION_FLOAT),
+    calibration_fraction_bits_(8),
+    flat_field_output_(CONFIG_FLAT_FIELD_FLOAT),
+    flat_field_fraction_bits_(8),
 	concurrent_processes_(1),
 	concurrent_rank_(0),
 	current_point_index_(0),
@@ -42,15 +136,17 @@ const std::string LATRDProcessPlugin::CONFIG_SENSOR_HEIGHT       = "height";
 //    last_processed_ts_buffer_(0),
 //    last_processed_frame_number_(0),
 //    last_processed_was_idle_(0),
-    raw_mode_(0)
+    raw_mode_(raw_mode_off)
 {
     // Setup logging for the class
     logger_ = Logger::getLogger("FP.LATRDProcessPlugin");
     logger_->setLevel(Level::getAll());
     LOG4CXX_TRACE(logger_, "LATRDProcessPlugin constructor.");
 
-    integral_.init(sensor_width_, sensor_height_);
+    integral_.init(sensor_width_, sensor_height_, sensor_depth_, false);
     integral_.reset_image();
+    // Count mode frames are decoded by the coordinator workers, which are otherwise idle
+    integral_.set_task_pool(coordinator_.get_task_pool());
 
     // Create the work queue for processing jobs
 //    jobQueue_ = boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDProcessJob> > >(new WorkQueue<boost::shared_ptr<LATRDProcessJob> >);
@@ -63,7 +159,12 @@ const std::string LATRDProcessPlugin::CONFIG_SENSOR_HEIGHT       = "height";
 //    }
 
     // Create the buffer managers
-    rawBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "raw_data", UINT64_TYPE));
+    // Received frames are forwarded whole as raw data, the buffer only numbers them
+    rawBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::total_frame_size / sizeof(uint64_t), "raw_data", UINT64_TYPE));
+    // Each packet has one offset and two header words, so the header buffer fills in step with the offsets
+    rawOffsetBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "raw_packet_offset", UINT64_TYPE));
+    rawHeaderBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size * 2, "raw_packet_header", UINT64_TYPE));
+    rawHeaderBuffer_->followFrameNumbers(rawOffsetBuffer_);
 //    timeStampBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_time_offset", UINT64_TYPE));
 //    idBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_id", UINT32_TYPE));
 //    energyBuffer_ = boost::shared_ptr<LATRDBuffer>(new LATRDBuffer(LATRD::frame_size, "event_energy", UINT32_TYPE));
@@ -73,6 +174,7 @@ const std::string LATRDProcessPlugin::CONFIG_SENSOR_HEIGHT       = "height";
 
     // Register this parent as a meta message publisher with the coordinator class
     coordinator_.register_meta_message_publisher(this);
+    integral_.register_meta_message_publisher(this);
 
   LOG4CXX_DEBUG_LEVEL(1, logger_, "Completed LATRDProcessPlugin constructor.");
 }
@@ -113,13 +215,52 @@ void LATRDProcessPlugin::configure(OdinData::IpcMessage& config, OdinData::IpcMe
 
   // Check for raw mode
   if (config.has_param(LATRDProcessPlugin::CONFIG_RAW_MODE)) {
-    this->raw_mode_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_RAW_MODE);
-    LOG4CXX_DEBUG_LEVEL(1, logger_, "Raw mode set to " << this->raw_mode_);
+    uint32_t raw_mode = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_RAW_MODE);
+    if (raw_mode <= raw_mode_dual) {
+      this->raw_mode_ = raw_mode;
+      LOG4CXX_DEBUG_LEVEL(1, logger_, "Raw mode set to " << this->raw_mode_);
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid raw mode requested: " << raw_mode);
+    }
+  }
+
+  // Check for huge page backed memory
+  if (config.has_param(LATRDProcessPlugin::CONFIG_HUGE_PAGES)) {
+    this->configureHugePages(config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_HUGE_PAGES));
+  }
+
+  // Check for NUMA placement of the worker threads, which restarts the workers
+  if (config.has_param(LATRDProcessPlugin::CONFIG_NUMA)) {
+    uint32_t numa = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_NUMA);
+    try {
+      coordinator_.configure_numa(numa == 1);
+      this->numa_ = numa;
+      LOG4CXX_DEBUG_LEVEL(1, logger_, "NUMA placement set to " << this->numa_);
+    } catch (LATRDProcessingException& ex) {
+      LOG4CXX_ERROR(logger_, ex.what());
+    }
   }
 
-  // Check for a frame reset
+  // Check for a frame reset, a shared frame counter is only reset by rank 0
   if (config.has_param(LATRDProcessPlugin::CONFIG_RESET_FRAME)) {
     rawBuffer_->resetFrameNumber();
+    rawOffsetBuffer_->resetFrameNumber();
+    rawHeaderBuffer_->resetFrameNumber();
+    coordinator_.reset_frame_counter();
+  }
+
+  // Check for a shared frame counter, an empty name numbers frames by process rank
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FRAME_COUNTER)) {
+    std::string counter = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FRAME_COUNTER);
+    try {
+      coordinator_.configure_frame_counter(counter);
+      rawBuffer_->setFrameCounter(coordinator_.get_frame_counter(), RAW_FRAME_SLOT);
+      rawOffsetBuffer_->setFrameCounter(coordinator_.get_frame_counter(), RAW_INDEX_FRAME_SLOT);
+      this->frame_counter_ = counter;
+      LOG4CXX_DEBUG_LEVEL(1, logger_, "Frame counter set to [" << this->frame_counter_ << "]");
+    } catch (LATRDProcessingException& ex) {
+      LOG4CXX_ERROR(logger_, ex.what());
+    }
   }
 
   // Check to see if we are configuring the process number and rank
@@ -134,6 +275,90 @@ void LATRDProcessPlugin::configure(OdinData::IpcMessage& config, OdinData::IpcMe
     this->configureSensor(sensorConfig, reply);
   }
 
+  // Check to see if we are configuring the compression of output frames
+  if (config.has_param(LATRDProcessPlugin::CONFIG_COMPRESSION)) {
+    OdinData::IpcMessage compressionConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_COMPRESSION));
+    this->configureCompression(compressionConfig, reply);
+  }
+
+  // Check to see if we are configuring the online histograms
+  if (config.has_param(LATRDProcessPlugin::CONFIG_HISTOGRAMS)) {
+    OdinData::IpcMessage histogramConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_HISTOGRAMS));
+    this->configureHistograms(histogramConfig, reply);
+  }
+
+  // Check to see if we are configuring the time binned images
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_BINS)) {
+    OdinData::IpcMessage imageConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_IMAGE_BINS));
+    this->configureImageBins(imageConfig, reply);
+  }
+
+  // Check to see if we are configuring the count mode image outputs
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT)) {
+    OdinData::IpcMessage outputConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT));
+    this->configureImageOutput(outputConfig, reply);
+  }
+
+  // Check to see if we are configuring the event clustering
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CLUSTERING)) {
+    OdinData::IpcMessage clusterConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_CLUSTERING));
+    this->configureClustering(clusterConfig, reply);
+  }
+
+  // Check to see if we are configuring the pool of processing jobs
+  if (config.has_param(LATRDProcessPlugin::CONFIG_JOB_POOL)) {
+    OdinData::IpcMessage poolConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_JOB_POOL));
+    this->configureJobPool(poolConfig, reply);
+  }
+
+  // Check to see if we are configuring the event filter
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER)) {
+    OdinData::IpcMessage filterConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_FILTER));
+    this->configureFilter(filterConfig, reply);
+  }
+
+  // Check to see if we are configuring the pixel geometry
+  if (config.has_param(LATRDProcessPlugin::CONFIG_GEOMETRY)) {
+    OdinData::IpcMessage geometryConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_GEOMETRY));
+    this->configureGeometry(geometryConfig, reply);
+  }
+
+  // Check to see if we are configuring the energy calibration
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CALIBRATION)) {
+    OdinData::IpcMessage calibrationConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_CALIBRATION));
+    this->configureCalibration(calibrationConfig, reply);
+  }
+
+  // Check to see if we are configuring the count mode flat field correction
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FLAT_FIELD)) {
+    OdinData::IpcMessage flatFieldConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_FLAT_FIELD));
+    this->configureFlatField(flatFieldConfig, reply);
+  }
+
+  // Check to see if we are configuring the region of interest intensities
+  if (config.has_param(LATRDProcessPlugin::CONFIG_ROI)) {
+    OdinData::IpcMessage roiConfig(config.get_param<const rapidjson::Value&>(LATRDProcessPlugin::CONFIG_ROI));
+    this->configureRoi(roiConfig, reply);
+  }
+
+  // Check for the event output format
+  if (config.has_param(LATRDProcessPlugin::CONFIG_EVENT_FORMAT)) {
+    std::string format = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_EVENT_FORMAT);
+    if (format == LATRDProcessPlugin::CONFIG_EVENT_FORMAT_COLUMNS){
+      coordinator_.configure_event_format(COLUMN_EVENT_FORMAT);
+      this->event_format_ = format;
+    } else if (format == LATRDProcessPlugin::CONFIG_EVENT_FORMAT_PACKED){
+      coordinator_.configure_event_format(PACKED_EVENT_FORMAT);
+      this->event_format_ = format;
+    } else if (format == LATRDProcessPlugin::CONFIG_EVENT_FORMAT_VARINT){
+      coordinator_.configure_event_format(VARINT_EVENT_FORMAT);
+      this->event_format_ = format;
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid event format requested: " << format);
+    }
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Event format set to " << this->event_format_);
+  }
+
 }
 
 void LATRDProcessPlugin::requestConfiguration(OdinData::IpcMessage& reply)
@@ -141,6 +366,53 @@ void LATRDProcessPlugin::requestConfiguration(OdinData::IpcMessage& reply)
   // Return the configuration of the LATRD process plugin
   reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_MODE, this->mode_);
   reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_RAW_MODE, this->raw_mode_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_HUGE_PAGES, this->huge_pages_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_NUMA, this->numa_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_FRAME_COUNTER, this->frame_counter_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_COMPRESSION + "/" +
+                  LATRDProcessPlugin::CONFIG_COMPRESSION_TYPE, this->compression_type_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_COMPRESSION + "/" +
+                  LATRDProcessPlugin::CONFIG_COMPRESSION_DELTA, this->compression_delta_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_EVENT_FORMAT, this->event_format_);
+  std::string histogram_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_HISTOGRAMS + "/";
+  reply.set_param(histogram_path + LATRDProcessPlugin::CONFIG_HISTOGRAMS_ENABLE, this->histograms_enable_);
+  reply.set_param(histogram_path + LATRDProcessPlugin::CONFIG_HISTOGRAMS_MODULES, this->histograms_modules_);
+  reply.set_param(histogram_path + LATRDProcessPlugin::CONFIG_HISTOGRAMS_CADENCE, this->histograms_cadence_);
+  std::string image_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_IMAGE_BINS + "/";
+  reply.set_param(image_path + LATRDProcessPlugin::CONFIG_IMAGE_BINS_ENABLE, this->image_bins_enable_);
+  reply.set_param(image_path + LATRDProcessPlugin::CONFIG_IMAGE_BINS_WIDTH, this->image_bins_width_);
+  std::string output_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT + "/";
+  reply.set_param(output_path + LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_FULL, this->image_output_full_);
+  reply.set_param(output_path + LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_SUM, this->image_output_sum_);
+  reply.set_param(output_path + LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_BIN, this->image_output_bin_);
+  reply.set_param(output_path + LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_LIVE_RATE, this->image_output_live_rate_);
+  std::string cluster_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_CLUSTERING + "/";
+  reply.set_param(cluster_path + LATRDProcessPlugin::CONFIG_CLUSTERING_ENABLE, this->clustering_enable_);
+  reply.set_param(cluster_path + LATRDProcessPlugin::CONFIG_CLUSTERING_WINDOW, this->clustering_window_);
+  std::string pool_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_JOB_POOL + "/";
+  reply.set_param(pool_path + LATRDProcessPlugin::CONFIG_JOB_POOL_SIZE, this->job_pool_size_);
+  std::string filter_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_FILTER + "/";
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MIN, this->filter_energy_min_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MAX, this->filter_energy_max_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ROI_X, this->filter_roi_x_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ROI_Y, this->filter_roi_y_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ROI_WIDTH, this->filter_roi_width_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ROI_HEIGHT, this->filter_roi_height_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_ROI_FILE, this->filter_roi_file_);
+  reply.set_param(filter_path + LATRDProcessPlugin::CONFIG_FILTER_MASK_FILE, this->filter_mask_file_);
+  std::string geometry_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_GEOMETRY + "/";
+  reply.set_param(geometry_path + LATRDProcessPlugin::CONFIG_GEOMETRY_FILE, this->geometry_file_);
+  reply.set_param(geometry_path + LATRDProcessPlugin::CONFIG_GEOMETRY_OUTPUT, this->geometry_output_);
+  std::string calibration_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_CALIBRATION + "/";
+  reply.set_param(calibration_path + LATRDProcessPlugin::CONFIG_CALIBRATION_FILE, this->calibration_file_);
+  reply.set_param(calibration_path + LATRDProcessPlugin::CONFIG_CALIBRATION_OUTPUT, this->calibration_output_);
+  reply.set_param(calibration_path + LATRDProcessPlugin::CONFIG_CALIBRATION_FRACTION_BITS, this->calibration_fraction_bits_);
+  std::string flat_field_path = get_name() + "/" + LATRDProcessPlugin::CONFIG_FLAT_FIELD + "/";
+  reply.set_param(flat_field_path + LATRDProcessPlugin::CONFIG_FLAT_FIELD_GAIN_FILE, this->flat_field_gain_file_);
+  reply.set_param(flat_field_path + LATRDProcessPlugin::CONFIG_FLAT_FIELD_MASK_FILE, this->flat_field_mask_file_);
+  reply.set_param(flat_field_path + LATRDProcessPlugin::CONFIG_FLAT_FIELD_OUTPUT, this->flat_field_output_);
+  reply.set_param(flat_field_path + LATRDProcessPlugin::CONFIG_FLAT_FIELD_FRACTION_BITS, this->flat_field_fraction_bits_);
+  reply.set_param(get_name() + "/" + LATRDProcessPlugin::CONFIG_ROI + "/" + LATRDProcessPlugin::CONFIG_ROI_REGIONS, this->roi_regions_);
 }
 
 void LATRDProcessPlugin::status(OdinData::IpcMessage& status)
@@ -157,6 +429,44 @@ void LATRDProcessPlugin::status(OdinData::IpcMessage& status)
   status.set_param(get_name() + "/results_queue", result_q_size);
   status.set_param(get_name() + "/processed_frames", processed_frames);
   status.set_param(get_name() + "/output_frames", output_frames);
+
+  uint64_t energy_rejects = 0;
+  uint64_t roi_rejects = 0;
+  uint64_t mask_rejects = 0;
+  this->coordinator_.get_filter_statistics(&energy_rejects, &roi_rejects, &mask_rejects);
+  status.set_param(get_name() + "/filter_energy_rejected", energy_rejects);
+  status.set_param(get_name() + "/filter_roi_rejected", roi_rejects);
+  status.set_param(get_name() + "/filter_mask_rejected", mask_rejects);
+  status.set_param(get_name() + "/image_late_events", this->coordinator_.get_image_late_events());
+  status.set_param(get_name() + "/clusters", this->coordinator_.get_cluster_count());
+  status.set_param(get_name() + "/timestamp_delta_mismatches", this->coordinator_.get_timestamp_delta_mismatches());
+  status.set_param(get_name() + "/compression_failures", this->coordinator_.get_compression_failures());
+  uint32_t pool_size = 0;
+  uint32_t pool_free = 0;
+  uint64_t pool_exhausted = 0;
+  uint64_t pool_forced_releases = 0;
+  uint64_t pool_dropped_packets = 0;
+  this->coordinator_.get_job_pool_statistics(&pool_size, &pool_free, &pool_exhausted, &pool_forced_releases,
+                                             &pool_dropped_packets);
+  status.set_param(get_name() + "/job_pool_size", pool_size);
+  status.set_param(get_name() + "/job_pool_free", pool_free);
+  status.set_param(get_name() + "/job_pool_exhausted", pool_exhausted);
+  status.set_param(get_name() + "/job_pool_forced_releases", pool_forced_releases);
+  status.set_param(get_name() + "/job_pool_dropped_packets", pool_dropped_packets);
+  uint32_t numa_groups = 0;
+  uint64_t numa_local_jobs = 0;
+  uint64_t numa_remote_jobs = 0;
+  this->coordinator_.get_numa_statistics(&numa_groups, &numa_local_jobs, &numa_remote_jobs);
+  status.set_param(get_name() + "/numa_groups", numa_groups);
+  status.set_param(get_name() + "/numa_local_jobs", numa_local_jobs);
+  status.set_param(get_name() + "/numa_remote_jobs", numa_remote_jobs);
+  uint64_t image_late_packets = 0;
+  uint64_t image_forced = 0;
+  uint64_t image_dropped_words = 0;
+  this->integral_.get_statistics(&image_late_packets, &image_forced, &image_dropped_words);
+  status.set_param(get_name() + "/image_late_packets", image_late_packets);
+  status.set_param(get_name() + "/image_forced", image_forced);
+  status.set_param(get_name() + "/image_dropped_words", image_dropped_words);
 }
 
 /**
@@ -186,10 +496,24 @@ void LATRDProcessPlugin::configureProcess(OdinData::IpcMessage& config, OdinData
   this->coordinator_.configure_process(this->concurrent_processes_, this->concurrent_rank_);
 
   this->rawBuffer_->configureProcess(this->concurrent_processes_, this->concurrent_rank_);
+  this->rawOffsetBuffer_->configureProcess(this->concurrent_processes_, this->concurrent_rank_);
+  this->rawHeaderBuffer_->configureProcess(this->concurrent_processes_, this->concurrent_rank_);
 
   this->createMetaHeader();
 }
 
+/**
+ * Set configuration options for the sensor.
+ *
+ * The options are searched for:
+ * CONFIG_SENSOR_WIDTH - Width of the sensor in pixels
+ * CONFIG_SENSOR_HEIGHT - Height of the sensor in pixels
+ * CONFIG_SENSOR_DEPTH - Bits per pixel of count mode images, 16 or 32.  Counts
+ * saturate at the largest value rather than wrapping
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
 void LATRDProcessPlugin::configureSensor(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
 {
   // Check for sensor width and height
@@ -203,8 +527,545 @@ void LATRDProcessPlugin::configureSensor(OdinData::IpcMessage &config, OdinData:
     LOG4CXX_DEBUG_LEVEL(1, logger_, "Sensor height changed to " << this->sensor_height_);
   }
 
-  integral_.init(this->sensor_width_, this->sensor_height_);
+  if (config.has_param(LATRDProcessPlugin::CONFIG_SENSOR_DEPTH)) {
+    uint32_t depth = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_SENSOR_DEPTH);
+    if (depth == 16 || depth == 32) {
+      this->sensor_depth_ = depth;
+      LOG4CXX_DEBUG_LEVEL(1, logger_, "Sensor image depth changed to " << this->sensor_depth_);
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid image depth " << depth << ", must be 16 or 32");
+    }
+  }
+
+  integral_.init(this->sensor_width_, this->sensor_height_, this->sensor_depth_, this->huge_pages_ == 1);
   integral_.reset_image();
+
+  // Pixel maps and images depend upon the sensor size so they must be recreated
+  this->applyFilter();
+  this->applyImageBins();
+  this->applyGeometry();
+  this->applyCalibration();
+  this->applyFlatField();
+  this->applyRoi();
+}
+
+/**
+ * Set configuration options for the time binned images.
+ *
+ * Decoded events are binned by time into a sequence of count images that are
+ * written to the image dataset. The options are searched for:
+ * CONFIG_IMAGE_BINS_ENABLE - Build images from the decoded events
+ * CONFIG_IMAGE_BINS_WIDTH - Width of each image in timestamp units
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureImageBins(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_BINS_ENABLE)) {
+    this->image_bins_enable_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_IMAGE_BINS_ENABLE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_BINS_WIDTH)) {
+    this->image_bins_width_ = config.get_param<uint64_t>(LATRDProcessPlugin::CONFIG_IMAGE_BINS_WIDTH);
+  }
+  this->applyImageBins();
+}
+
+void LATRDProcessPlugin::applyImageBins()
+{
+  try {
+    coordinator_.configure_image_binning(this->image_bins_enable_ == 1,
+                                         this->sensor_width_,
+                                         this->sensor_height_,
+                                         this->image_bins_width_);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Image binning set to " << this->image_bins_enable_
+                                    << " with bin width " << this->image_bins_width_);
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the count mode image outputs.
+ *
+ * Completed count mode images can be summed, binned and sampled for a live
+ * view, each reduced stream being pushed as its own dataset.  The options
+ * are searched for:
+ * CONFIG_IMAGE_OUTPUT_FULL - Push each full resolution image to the image dataset
+ * CONFIG_IMAGE_OUTPUT_SUM - Number of consecutive images summed into the image_sum dataset, 0 to disable
+ * CONFIG_IMAGE_OUTPUT_BIN - Square of pixels, 1, 2 or 4 wide, summed into each pixel of the reduced images
+ * CONFIG_IMAGE_OUTPUT_LIVE_RATE - Highest rate in Hz of the image_live dataset, 0 to disable
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureImageOutput(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  uint32_t full = this->image_output_full_;
+  uint32_t sum = this->image_output_sum_;
+  uint32_t bin = this->image_output_bin_;
+  uint32_t live_rate = this->image_output_live_rate_;
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_FULL)) {
+    full = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_FULL);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_SUM)) {
+    sum = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_SUM);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_BIN)) {
+    bin = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_BIN);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_LIVE_RATE)) {
+    live_rate = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_IMAGE_OUTPUT_LIVE_RATE);
+  }
+  try {
+    integral_.configure_output(full == 1, sum, bin, live_rate);
+    this->image_output_full_ = full;
+    this->image_output_sum_ = sum;
+    this->image_output_bin_ = bin;
+    this->image_output_live_rate_ = live_rate;
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Image output set to full " << this->image_output_full_
+                                    << " sum " << this->image_output_sum_
+                                    << " bin " << this->image_output_bin_
+                                    << " live rate " << this->image_output_live_rate_);
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the event clustering.
+ *
+ * Events on neighbouring pixels within a time window of each other are grouped
+ * into clusters, which are written to the cluster datasets.  The options are
+ * searched for:
+ * CONFIG_CLUSTERING_ENABLE - Cluster the decoded events
+ * CONFIG_CLUSTERING_WINDOW - Time window in timestamp units
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureClustering(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CLUSTERING_ENABLE)) {
+    this->clustering_enable_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_CLUSTERING_ENABLE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CLUSTERING_WINDOW)) {
+    this->clustering_window_ = config.get_param<uint64_t>(LATRDProcessPlugin::CONFIG_CLUSTERING_WINDOW);
+  }
+  coordinator_.configure_clustering(this->clustering_enable_ == 1, this->clustering_window_);
+  LOG4CXX_DEBUG_LEVEL(1, logger_, "Clustering set to " << this->clustering_enable_
+                                  << " with window " << this->clustering_window_);
+}
+
+/**
+ * Set configuration options for the pool of processing jobs.
+ *
+ * Jobs are allocated from a single block of memory when the pool is
+ * configured.  If the pool runs dry, held wraps that the incoming packet
+ * shows to be complete are written out to free their jobs.  The current and
+ * previous wraps are never written early, so if no jobs can be freed the
+ * packet is dropped and counted.  The pool can only be resized when no data
+ * is held.  The options are searched for:
+ * CONFIG_JOB_POOL_SIZE - Number of jobs in the pool
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureJobPool(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_JOB_POOL_SIZE)) {
+    this->job_pool_size_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_JOB_POOL_SIZE);
+  }
+  try {
+    coordinator_.configure_job_pool(this->job_pool_size_);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Job pool size set to " << this->job_pool_size_);
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Back the job pool, the output buffers and the count mode images with huge pages.
+ *
+ * All of the memory is reallocated and faulted in when the option changes, so
+ * that no page faults are taken while processing.  Normal pages are used if
+ * no huge pages are available.  Memory cannot be reallocated while data is held,
+ * so this should be set between acquisitions.
+ *
+ * \param[in] huge_pages - 1 to request huge pages, 0 for normal pages.
+ */
+void LATRDProcessPlugin::configureHugePages(uint32_t huge_pages)
+{
+  try {
+    coordinator_.configure_huge_pages(huge_pages == 1);
+    rawOffsetBuffer_->allocate(huge_pages == 1);
+    rawHeaderBuffer_->allocate(huge_pages == 1);
+    this->huge_pages_ = huge_pages;
+    integral_.init(this->sensor_width_, this->sensor_height_, this->sensor_depth_, this->huge_pages_ == 1);
+    integral_.reset_image();
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Huge pages set to " << this->huge_pages_);
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the online histograms.
+ *
+ * Histograms are built by the worker threads and published as meta data. The
+ * options are searched for:
+ * CONFIG_HISTOGRAMS_ENABLE - Build the energy spectrum and time slice histograms
+ * CONFIG_HISTOGRAMS_MODULES - Also build an energy spectrum for each module
+ * CONFIG_HISTOGRAMS_CADENCE - Number of time slice releases between publishing
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureHistograms(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_HISTOGRAMS_ENABLE)) {
+    this->histograms_enable_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_HISTOGRAMS_ENABLE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_HISTOGRAMS_MODULES)) {
+    this->histograms_modules_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_HISTOGRAMS_MODULES);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_HISTOGRAMS_CADENCE)) {
+    this->histograms_cadence_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_HISTOGRAMS_CADENCE);
+  }
+  coordinator_.configure_histograms(this->histograms_enable_ == 1,
+                                    this->histograms_modules_ == 1,
+                                    this->histograms_cadence_);
+  LOG4CXX_DEBUG_LEVEL(1, logger_, "Histograms set to " << this->histograms_enable_
+                                  << " with modules " << this->histograms_modules_
+                                  << " and cadence " << this->histograms_cadence_);
+}
+
+/**
+ * Set configuration options for the event filter.
+ *
+ * Events are removed by the worker threads before they are written. The
+ * options are searched for:
+ * CONFIG_FILTER_ENERGY_MIN - Lowest energy to keep
+ * CONFIG_FILTER_ENERGY_MAX - Highest energy to keep, 0 disables the energy window
+ * CONFIG_FILTER_ROI_X, CONFIG_FILTER_ROI_Y - Origin of the rectangular ROI
+ * CONFIG_FILTER_ROI_WIDTH, CONFIG_FILTER_ROI_HEIGHT - Size of the ROI, 0 disables the ROI
+ * CONFIG_FILTER_ROI_FILE - Bitmap file of pixels to keep, empty to disable
+ * CONFIG_FILTER_MASK_FILE - Bitmap file of dead or hot pixels to reject, empty to disable
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureFilter(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MIN)) {
+    this->filter_energy_min_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MIN);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MAX)) {
+    this->filter_energy_max_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ENERGY_MAX);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ROI_X)) {
+    this->filter_roi_x_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ROI_X);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ROI_Y)) {
+    this->filter_roi_y_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ROI_Y);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ROI_WIDTH)) {
+    this->filter_roi_width_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ROI_WIDTH);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ROI_HEIGHT)) {
+    this->filter_roi_height_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FILTER_ROI_HEIGHT);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_ROI_FILE)) {
+    this->filter_roi_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FILTER_ROI_FILE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FILTER_MASK_FILE)) {
+    this->filter_mask_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FILTER_MASK_FILE);
+  }
+  this->applyFilter();
+}
+
+void LATRDProcessPlugin::applyFilter()
+{
+  try {
+    boost::shared_ptr<LATRDEventFilter> filter(new LATRDEventFilter(this->sensor_width_, this->sensor_height_));
+    if (this->filter_energy_max_ > 0) {
+      filter->set_energy_window(this->filter_energy_min_, this->filter_energy_max_);
+    }
+    if (this->filter_roi_width_ > 0 && this->filter_roi_height_ > 0) {
+      filter->set_roi(this->filter_roi_x_, this->filter_roi_y_, this->filter_roi_width_, this->filter_roi_height_);
+    }
+    if (!this->filter_roi_file_.empty()) {
+      filter->set_roi_map(filter->load_map(this->filter_roi_file_));
+    }
+    if (!this->filter_mask_file_.empty()) {
+      filter->set_mask(filter->load_map(this->filter_mask_file_));
+    }
+    coordinator_.configure_filter(filter);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Event filter " << (filter->enabled() ? "enabled" : "disabled"));
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the pixel geometry.
+ *
+ * The geometry maps raw position IDs onto pixels of the sensor image, which is
+ * the configured sensor width and height.  The filter regions, calibration,
+ * image binning and clustering then all work in sensor image coordinates, while
+ * the module histograms keep the raw coordinates.  The options are searched for:
+ * CONFIG_GEOMETRY_FILE - Module layout file, empty to write raw position IDs
+ * CONFIG_GEOMETRY_OUTPUT - Either linear pixel indexes in the event_id dataset,
+ * or x and y coordinates in the event_x and event_y datasets.  The packed event
+ * formats have a single ID field so always hold raw IDs for x and y output
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureGeometry(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_GEOMETRY_FILE)) {
+    this->geometry_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_GEOMETRY_FILE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_GEOMETRY_OUTPUT)) {
+    std::string output = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_GEOMETRY_OUTPUT);
+    if (output == LATRDProcessPlugin::CONFIG_GEOMETRY_INDEX || output == LATRDProcessPlugin::CONFIG_GEOMETRY_XY) {
+      this->geometry_output_ = output;
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid geometry output requested: " << output);
+    }
+  }
+  this->applyGeometry();
+}
+
+void LATRDProcessPlugin::applyGeometry()
+{
+  try {
+    boost::shared_ptr<LATRDPixelGeometry> geometry;
+    if (!this->geometry_file_.empty()) {
+      LATRDGeometryOutput output = GEOMETRY_INDEX;
+      if (this->geometry_output_ == LATRDProcessPlugin::CONFIG_GEOMETRY_XY) {
+        output = GEOMETRY_XY;
+      }
+      geometry = boost::shared_ptr<LATRDPixelGeometry>(new LATRDPixelGeometry(this->sensor_width_,
+                                                                             this->sensor_height_,
+                                                                             output));
+      geometry->load_layout(this->geometry_file_);
+    }
+    coordinator_.configure_geometry(geometry);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Pixel geometry " << (geometry ? "loaded from " + this->geometry_file_ : "disabled"));
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the energy calibration.
+ *
+ * Raw energies are converted into keV by the decode workers using per pixel
+ * surrogate function coefficients.  Calibration is only applied to the column
+ * event format, the packed formats always hold raw energies.  The calibration
+ * sets the type of the event_energy dataset, so it is rejected while events
+ * are held and should be changed between acquisitions.  The options are
+ * searched for:
+ * CONFIG_CALIBRATION_FILE - Coefficient file, empty to write raw energies
+ * CONFIG_CALIBRATION_OUTPUT - Write energies as float or fixed point values
+ * CONFIG_CALIBRATION_FRACTION_BITS - Number of fractional bits of fixed point values
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureCalibration(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CALIBRATION_FILE)) {
+    this->calibration_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_CALIBRATION_FILE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CALIBRATION_OUTPUT)) {
+    std::string output = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_CALIBRATION_OUTPUT);
+    if (output == LATRDProcessPlugin::CONFIG_CALIBRATION_FLOAT || output == LATRDProcessPlugin::CONFIG_CALIBRATION_FIXED) {
+      this->calibration_output_ = output;
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid calibration output requested: " << output);
+    }
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_CALIBRATION_FRACTION_BITS)) {
+    this->calibration_fraction_bits_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_CALIBRATION_FRACTION_BITS);
+  }
+  this->applyCalibration();
+}
+
+/**
+ * Set configuration options for the count mode flat field correction.
+ *
+ * Completed count mode images are multiplied by a per pixel gain map and have
+ * dead or hot pixels zeroed, and the corrected images are written to the
+ * image_corrected dataset.  The uncorrected images are still controlled by
+ * the full image output option.  The options are searched for:
+ * CONFIG_FLAT_FIELD_GAIN_FILE - Gain file of float32 values, empty for unit gain
+ * CONFIG_FLAT_FIELD_MASK_FILE - Bitmap file of dead or hot pixels, empty for no mask
+ * CONFIG_FLAT_FIELD_OUTPUT - Write corrected images as float or fixed point values
+ * CONFIG_FLAT_FIELD_FRACTION_BITS - Number of fractional bits of fixed point values
+ *
+ * Correction is disabled when both files are empty.
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureFlatField(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FLAT_FIELD_GAIN_FILE)) {
+    this->flat_field_gain_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FLAT_FIELD_GAIN_FILE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FLAT_FIELD_MASK_FILE)) {
+    this->flat_field_mask_file_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FLAT_FIELD_MASK_FILE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FLAT_FIELD_OUTPUT)) {
+    std::string output = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_FLAT_FIELD_OUTPUT);
+    if (output == LATRDProcessPlugin::CONFIG_FLAT_FIELD_FLOAT || output == LATRDProcessPlugin::CONFIG_FLAT_FIELD_FIXED) {
+      this->flat_field_output_ = output;
+    } else {
+      LOG4CXX_ERROR(logger_, "Invalid flat field output requested: " << output);
+    }
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_FLAT_FIELD_FRACTION_BITS)) {
+    this->flat_field_fraction_bits_ = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_FLAT_FIELD_FRACTION_BITS);
+  }
+  this->applyFlatField();
+}
+
+void LATRDProcessPlugin::applyFlatField()
+{
+  try {
+    boost::shared_ptr<LATRDFlatField> flat_field;
+    if (!this->flat_field_gain_file_.empty() || !this->flat_field_mask_file_.empty()) {
+      LATRDFlatFieldOutput output = FLOAT_FLAT_FIELD;
+      if (this->flat_field_output_ == LATRDProcessPlugin::CONFIG_FLAT_FIELD_FIXED) {
+        output = FIXED_FLAT_FIELD;
+      }
+      flat_field = boost::shared_ptr<LATRDFlatField>(new LATRDFlatField(this->sensor_width_,
+                                                                        this->sensor_height_,
+                                                                        output,
+                                                                        this->flat_field_fraction_bits_));
+      if (!this->flat_field_gain_file_.empty()) {
+        flat_field->load_gain(this->flat_field_gain_file_);
+      }
+      if (!this->flat_field_mask_file_.empty()) {
+        flat_field->load_mask(this->flat_field_mask_file_);
+      }
+    }
+    integral_.configure_flat_field(flat_field);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Flat field correction " << (flat_field ? "enabled" : "disabled"));
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the region of interest intensities.
+ *
+ * The counts within each rectangular region are summed as each count mode
+ * image completes, and over each time binned image in event mode, and the
+ * sums are published through the meta channel as roi_intensity and
+ * roi_bin_intensity messages.  The options are searched for:
+ * CONFIG_ROI_REGIONS - Semicolon separated regions of comma separated x,y,width,height
+ *
+ * Integration is disabled when the regions are empty.
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureRoi(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  if (config.has_param(LATRDProcessPlugin::CONFIG_ROI_REGIONS)) {
+    this->roi_regions_ = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_ROI_REGIONS);
+  }
+  this->applyRoi();
+}
+
+void LATRDProcessPlugin::applyRoi()
+{
+  try {
+    boost::shared_ptr<LATRDRoiIntegrator> rois;
+    if (!this->roi_regions_.empty()) {
+      rois = boost::shared_ptr<LATRDRoiIntegrator>(new LATRDRoiIntegrator(this->sensor_width_, this->sensor_height_));
+      rois->add_regions(this->roi_regions_);
+    }
+    integral_.configure_rois(rois);
+    coordinator_.configure_rois(rois);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Region of interest intensities " << (rois ? "enabled" : "disabled"));
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+void LATRDProcessPlugin::applyCalibration()
+{
+  try {
+    boost::shared_ptr<LATRDEnergyCalibration> calibration;
+    if (!this->calibration_file_.empty()) {
+      LATRDEnergyOutput output = FLOAT_ENERGY;
+      if (this->calibration_output_ == LATRDProcessPlugin::CONFIG_CALIBRATION_FIXED) {
+        output = FIXED_ENERGY;
+      }
+      calibration = boost::shared_ptr<LATRDEnergyCalibration>(new LATRDEnergyCalibration(this->sensor_width_,
+                                                                                         this->sensor_height_,
+                                                                                         output,
+                                                                                         this->calibration_fraction_bits_));
+      calibration->load_coefficients(this->calibration_file_);
+    }
+    coordinator_.configure_calibration(calibration);
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Energy calibration " << (calibration ? "loaded from " + this->calibration_file_ : "disabled"));
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
+}
+
+/**
+ * Set configuration options for the compression of output frames.
+ *
+ * Compressed frames are tagged so that the file writer can store them with a
+ * direct chunk write. The options are searched for:
+ * CONFIG_COMPRESSION_TYPE - Compression algorithm (none or bslz4)
+ * CONFIG_COMPRESSION_DELTA - Delta encode timestamp datasets before compression
+ *
+ * \param[in] config - IpcMessage containing configuration data.
+ * \param[out] reply - Response IpcMessage.
+ */
+void LATRDProcessPlugin::configureCompression(OdinData::IpcMessage &config, OdinData::IpcMessage &reply)
+{
+  std::string type = this->compression_type_;
+  uint32_t delta = this->compression_delta_;
+  if (config.has_param(LATRDProcessPlugin::CONFIG_COMPRESSION_TYPE)) {
+    type = config.get_param<std::string>(LATRDProcessPlugin::CONFIG_COMPRESSION_TYPE);
+  }
+  if (config.has_param(LATRDProcessPlugin::CONFIG_COMPRESSION_DELTA)) {
+    delta = config.get_param<uint32_t>(LATRDProcessPlugin::CONFIG_COMPRESSION_DELTA);
+  }
+
+  try {
+    if (type == LATRDProcessPlugin::CONFIG_COMPRESSION_NONE) {
+      coordinator_.configure_compression(NO_COMPRESSION, delta == 1);
+    } else if (type == LATRDProcessPlugin::CONFIG_COMPRESSION_BSLZ4) {
+      coordinator_.configure_compression(BSLZ4_COMPRESSION, delta == 1);
+    } else {
+      throw LATRDProcessingException("Invalid compression type requested: " + type);
+    }
+    this->compression_type_ = type;
+    this->compression_delta_ = delta;
+    LOG4CXX_DEBUG_LEVEL(1, logger_, "Compression set to " << this->compression_type_ << " with delta " << this->compression_delta_);
+  }
+  catch (LATRDProcessingException& ex) {
+    LOG4CXX_ERROR(logger_, ex.what());
+  }
 }
 
 void LATRDProcessPlugin::createMetaHeader()
@@ -264,7 +1125,7 @@ void LATRDProcessPlugin::dump_frame(boost::shared_ptr<Frame> frame)
 
 void LATRDProcessPlugin::process_frame(boost::shared_ptr<Frame> frame)
 {
-  if (this->raw_mode_ == 1) {
+  if (this->raw_mode_ == raw_mode_only) {
     LOG4CXX_DEBUG_LEVEL(2, logger_, "Raw mode selected for fast recording of packets");
     this->process_raw(frame);
   } else {
@@ -283,14 +1144,19 @@ void LATRDProcessPlugin::process_frame(boost::shared_ptr<Frame> frame)
         this->push(*iter);
       }
     }
+    if (this->raw_mode_ == raw_mode_dual) {
+      // The received frame itself is forwarded as raw data, and recording it reads only
+      // the packet headers, so the payload is read once by the decoding above.  It is
+      // forwarded afterwards as forwarding renames and renumbers the frame
+      LOG4CXX_DEBUG_LEVEL(2, logger_, "Dual mode selected, recording packets after processing");
+      this->process_raw(frame);
+    }
   }
 }
 
 void LATRDProcessPlugin::process_raw(boost::shared_ptr<Frame> frame)
 {
-  // TODO: Fudge factor of 8 introduced as packets are not formed correctly
   LATRD::PacketHeader packet_header;
-  boost::shared_ptr<Frame> processedFrame;
 
   // Extract the header from the buffer and print the details
   const LATRD::FrameHeader* hdrPtr = static_cast<const LATRD::FrameHeader*>(frame->get_data());
@@ -298,73 +1164,53 @@ void LATRDProcessPlugin::process_raw(boost::shared_ptr<Frame> frame)
   LOG4CXX_TRACE(logger_, "Frame State: " << hdrPtr->frame_state);
   LOG4CXX_TRACE(logger_, "Packets Received: " << hdrPtr->packets_received);
   if (hdrPtr->idle_frame == 1){
-    // Get whatever is available in the buffer and then push it on to the next plugin.
+    // Get whatever is available in the index buffers and then push it on to the next plugin.
     LOG4CXX_ERROR(logger_, "** Idle frame passed to plugin !! **");
-    processedFrame = rawBuffer_->retrieveCurrentFrame();
-    if (processedFrame) {
-      LOG4CXX_TRACE(logger_, "Pushing a raw data frame due to an idle flag.");
-      std::vector<dimsize_t> dims(0);
-      processedFrame->set_dataset_name("raw_data");
-      processedFrame->set_data_type(3);
-      processedFrame->set_dimensions(dims);
-      this->push(processedFrame);
-    }
+    this->push_raw_frame(rawOffsetBuffer_->retrieveCurrentFrame(), "raw_packet_offset", 3);
+    this->push_raw_frame(rawHeaderBuffer_->retrieveCurrentFrame(), "raw_packet_header", 3);
   } else {
     // Extract the header words from each packet
-    uint8_t *payload_ptr = (uint8_t *) (frame->get_data()) + sizeof(LATRD::FrameHeader);
-
-    // Number of packet header 64bit words
-    uint16_t packet_header_count = (LATRD::packet_header_size / sizeof(uint64_t)) - 1;
+    const uint64_t *payload_ptr = (const uint64_t *)((const uint8_t *) (frame->get_data()) + sizeof(LATRD::FrameHeader));
 
+    // The received frame is written as it stands, so each packet is located by the
+    // position of its slot within the raw dataset.  Only the header words are read
+    uint64_t base = rawBuffer_->position() + (sizeof(LATRD::FrameHeader) / sizeof(uint64_t));
+    std::vector<uint64_t> positions;
+    std::vector<uint64_t> headers;
     for (int index = 0; index < LATRD::num_primary_packets; index++) {
-      if (hdrPtr->packet_state[index] == 0) {
-//        LOG4CXX_DEBUG(logger_, "   Packet number: [Missing Packet]");
-      } else {
-        packet_header.headerWord1 = *(((uint64_t *) payload_ptr) + 1);
-        packet_header.headerWord2 = *(((uint64_t *) payload_ptr) + 2);
+      if (hdrPtr->packet_state[index] != 0) {
+        packet_header.headerWord1 = *(payload_ptr + 1);
+        packet_header.headerWord2 = *(payload_ptr + 2);
         LOG4CXX_DEBUG_LEVEL(3, logger_, "   Header Word 1: 0x" << std::hex << packet_header.headerWord1);
         LOG4CXX_DEBUG_LEVEL(3, logger_, "   Header Word 2: 0x" << std::hex << packet_header.headerWord2);
-
-        // We need to decode how many values are in the packet
-        uint32_t packet_number = LATRD::get_packet_number(packet_header.headerWord2);
-        uint16_t word_count = LATRD::get_word_count(packet_header.headerWord1) + (uint16_t)2;
-        uint32_t time_slice = LATRD::get_time_slice_modulo(packet_header.headerWord1);
-
-        // Copy the number of valid results into the buffer
-        LOG4CXX_TRACE(logger_, "Appending " << word_count << " raw values");
-        processedFrame = rawBuffer_->appendData(payload_ptr, word_count);
-        // Check if a full frame was returned by the append.  If it was then push it on to the next plugin.
-        if (processedFrame) {
-          LOG4CXX_TRACE(logger_, "Pushing a raw data frame.");
-          std::vector<dimsize_t> dims(0);
-          processedFrame->set_dataset_name("raw_data");
-          processedFrame->set_data_type(3);
-          processedFrame->set_dimensions(dims);
-          this->push(processedFrame);
-        }
+        positions.push_back(base + (index * (LATRD::primary_packet_size / sizeof(uint64_t))));
+        headers.push_back(packet_header.headerWord1);
+        headers.push_back(packet_header.headerWord2);
       }
-      // Increment the payload_ptr by the correct number of bytes in a packet
-      payload_ptr += LATRD::primary_packet_size;
+      // Increment the payload_ptr by the correct number of words in a packet
+      payload_ptr += LATRD::primary_packet_size / sizeof(uint64_t);
+    }
+
+    // Frames without any packets are not recorded
+    if (positions.size() > 0) {
+      this->push_raw_frame(rawBuffer_->forwardFrame(frame), "raw_data", 3);
+      this->push_raw_frame(rawOffsetBuffer_->appendData(&positions[0], positions.size()), "raw_packet_offset", 3);
+      this->push_raw_frame(rawHeaderBuffer_->appendData(&headers[0], headers.size()), "raw_packet_header", 3);
     }
   }
 }
 
-void LATRDProcessPlugin::publishControlMetaData(boost::shared_ptr<LATRDProcessJob> job)
+void LATRDProcessPlugin::push_raw_frame(boost::shared_ptr<Frame> frame, const std::string& name, int data_type)
 {
-    LOG4CXX_DEBUG_LEVEL(2, logger_, "Number of control words [" << job->valid_control_words << "]");
-	if (job->valid_control_words > 0){
-		// Prepare the meta data header information
-		rapidjson::StringBuffer buffer;
-		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-		meta_document_.Accept(writer);
-
-		// Loop over the number of control words
-		for (uint16_t index = 0; index < job->valid_control_words; index++){
-			// For each control word publish the appropriate meta data
-			//publish_meta(META_NAME, "control_word", job->ctrl_word_ptr[index], buffer.GetString());
-			//publish_meta(META_NAME, "control_word_index", job->ctrl_index_ptr[index]+current_point_index_, buffer.GetString());
-		}
-	}
+  // Check if a frame was returned by the buffer.  If it was then push it on to the next plugin.
+  if (frame) {
+    LOG4CXX_TRACE(logger_, "Pushing a " << name << " frame.");
+    std::vector<dimsize_t> dims(0);
+    frame->set_dataset_name(name);
+    frame->set_data_type(data_type);
+    frame->set_dimensions(dims);
+    this->push(frame);
+  }
 }
 
 bool LATRDProcessPlugin::reset_statistics()
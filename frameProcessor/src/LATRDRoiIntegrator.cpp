@@ -0,0 +1,96 @@
+#include <sstream>
+
+#include "LATRDRoiIntegrator.h"
+
+namespace FrameProcessor {
+
+  LATRDRoiIntegrator::LATRDRoiIntegrator(uint32_t width, uint32_t height) :
+      width_(width),
+      height_(height)
+  {
+  }
+
+  LATRDRoiIntegrator::~LATRDRoiIntegrator()
+  {
+  }
+
+  void LATRDRoiIntegrator::add_roi(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+  {
+    if (width == 0 || height == 0){
+      throw LATRDProcessingException("Region of interest must not be empty");
+    }
+    if (x >= width_ || y >= height_ || width > width_ - x || height > height_ - y){
+      throw LATRDProcessingException("Region of interest does not lie within the sensor");
+    }
+    LATRDRoi roi = {x, y, width, height};
+    rois_.push_back(roi);
+  }
+
+  void LATRDRoiIntegrator::add_regions(const std::string& regions)
+  {
+    std::stringstream stream(regions);
+    std::string region;
+    while (std::getline(stream, region, ';')){
+      if (region.find_first_not_of(" ") == std::string::npos){
+        continue;
+      }
+      std::stringstream region_stream(region);
+      uint32_t values[4] = {0, 0, 0, 0};
+      char separator = 0;
+      region_stream >> values[0];
+      for (int index = 1; index < 4 && region_stream; index++){
+        region_stream >> separator >> values[index];
+        if (separator != ','){
+          region_stream.setstate(std::ios::failbit);
+        }
+      }
+      if (!region_stream || !(region_stream >> std::ws).eof()){
+        throw LATRDProcessingException("Invalid region of interest " + region);
+      }
+      this->add_roi(values[0], values[1], values[2], values[3]);
+    }
+  }
+
+  size_t LATRDRoiIntegrator::rois()
+  {
+    return rois_.size();
+  }
+
+  uint32_t LATRDRoiIntegrator::width()
+  {
+    return width_;
+  }
+
+  uint32_t LATRDRoiIntegrator::height()
+  {
+    return height_;
+  }
+
+  void LATRDRoiIntegrator::integrate(const void *image, uint32_t depth, uint64_t *sums)
+  {
+    if (depth == 32){
+      this->integrate_image((const uint32_t *)image, sums);
+    } else if (depth == 16){
+      this->integrate_image((const uint16_t *)image, sums);
+    } else {
+      throw LATRDProcessingException("Image depth must be 16 or 32 bits");
+    }
+  }
+
+  template <typename T> void LATRDRoiIntegrator::integrate_image(const T *image, uint64_t *sums)
+  {
+    // Each row of a region is contiguous, so the inner loop is a simple reduction
+    for (size_t index = 0; index < rois_.size(); index++){
+      const LATRDRoi& roi = rois_[index];
+      uint64_t sum = 0;
+      for (uint32_t y = roi.y; y < roi.y + roi.height; y++){
+        const T *row_ptr = image + ((size_t)y * width_) + roi.x;
+        for (uint32_t x = 0; x < roi.width; x++){
+          sum += row_ptr[x];
+        }
+      }
+      sums[index] = sum;
+    }
+  }
+
+}
@@ -0,0 +1,75 @@
+#include "LATRDTaskPool.h"
+#include "DebugLevelLogger.h"
+
+namespace FrameProcessor {
+
+  LATRDTaskPool::LATRDTaskPool(size_t threads)
+  {
+    // Setup logging for the class
+    logger_ = Logger::getLogger("FP.LATRDTaskPool");
+    logger_->setLevel(Level::getAll());
+    LOG4CXX_TRACE(logger_, "LATRDTaskPool constructor.");
+
+    // Create the work queues for outstanding and completed tasks
+    taskQueue_ = boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDTask> > >(new WorkQueue<boost::shared_ptr<LATRDTask> >);
+    doneQueue_ = boost::shared_ptr<WorkQueue<boost::shared_ptr<LATRDTask> > >(new WorkQueue<boost::shared_ptr<LATRDTask> >);
+
+    // Start the worker threads to monitor the queue
+    for (size_t index = 0; index < threads; index++){
+      threads_.push_back(new boost::thread(&LATRDTaskPool::workerTask, this));
+    }
+  }
+
+  LATRDTaskPool::~LATRDTaskPool()
+  {
+    // A null task stops a worker, so queue one for each worker and wait for them to exit
+    for (size_t index = 0; index < threads_.size(); index++){
+      taskQueue_->add(boost::shared_ptr<LATRDTask>(), true);
+    }
+    for (size_t index = 0; index < threads_.size(); index++){
+      threads_[index]->join();
+      delete threads_[index];
+    }
+    threads_.clear();
+  }
+
+  size_t LATRDTaskPool::size()
+  {
+    return threads_.size();
+  }
+
+  void LATRDTaskPool::run(std::vector<boost::shared_ptr<LATRDTask> > tasks)
+  {
+    // Queue every task and then wait for the same number to complete
+    std::vector<boost::shared_ptr<LATRDTask> >::iterator iter;
+    for (iter = tasks.begin(); iter != tasks.end(); ++iter){
+      taskQueue_->add(*iter, true);
+    }
+    for (size_t index = 0; index < tasks.size(); index++){
+      doneQueue_->remove();
+    }
+  }
+
+  void LATRDTaskPool::workerTask()
+  {
+    LOG4CXX_TRACE(logger_, "Starting pool task with ID [" << boost::this_thread::get_id() << "]");
+    bool executing = true;
+    while (executing){
+      boost::shared_ptr<LATRDTask> task = taskQueue_->remove();
+      if (!task){
+        executing = false;
+        continue;
+      }
+      try
+      {
+        task->execute();
+      }
+      catch (std::exception& ex)
+      {
+        LOG4CXX_ERROR(logger_, "Task failed: " << ex.what());
+      }
+      doneQueue_->add(task, true);
+    }
+  }
+
+}
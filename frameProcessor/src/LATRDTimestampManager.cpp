@@ -25,6 +25,7 @@ namespace FrameProcessor {
         // Protect this method
         boost::lock_guard<boost::recursive_mutex> lock(mutex_);
         timestamps_.clear();
+        delta_timestamp_ = 0;
     }
 
     void LATRDTimestampManager::reset_delta() {
@@ -47,6 +48,7 @@ namespace FrameProcessor {
             // Record the time slice wrap and buffer number
             time_slice_buffer_ = time_slice_buffer;
             time_slice_wrap_ = time_slice_wrap;
+            timestamps_[packet_number] = timestamp;
         } else {
             // We can only use packets from the same time slice buffer and wrap
             if (time_slice_buffer == time_slice_buffer_ && time_slice_wrap == time_slice_wrap_) {
@@ -0,0 +1,84 @@
+#include "LATRDDefinitions.h"
+#include "LATRDTimestampTracker.h"
+
+namespace FrameProcessor {
+
+  LATRDTimestampTracker::LATRDTimestampTracker() :
+      mismatches_(0)
+  {
+    this->reset();
+  }
+
+  LATRDTimestampTracker::~LATRDTimestampTracker()
+  {
+  }
+
+  void LATRDTimestampTracker::reset()
+  {
+    // Only called between acquisitions, when no workers are decoding
+    for (size_t index = 0; index < timestamp_tracker_producers; index++){
+      delta_[index] = 0;
+      run_[index] = 0;
+    }
+    mismatches_ = 0;
+    __sync_synchronize();
+  }
+
+  void LATRDTimestampTracker::record(uint8_t producer_id, uint64_t previous_timestamp, uint64_t current_timestamp)
+  {
+    // A repeated extended timestamp carries no interval information
+    if (current_timestamp <= previous_timestamp){
+      return;
+    }
+    uint64_t interval = current_timestamp - previous_timestamp;
+    uint64_t recorded = __sync_val_compare_and_swap(&delta_[producer_id], 0, interval);
+    if (recorded == 0){
+      return;
+    }
+    if (recorded == interval){
+      // A consistent interval ends any run of disagreeing ones
+      if (run_[producer_id] != 0){
+        run_[producer_id] = 0;
+      }
+      return;
+    }
+    __sync_fetch_and_add(&mismatches_, 1);
+    // The run is held in a single word so it can be extended without locking.  Intervals too
+    // large to pack are only counted
+    if ((interval >> 56) != 0){
+      return;
+    }
+    uint64_t run = run_[producer_id];
+    uint64_t extended = (((run >> 8) == interval) ? run : (interval << 8)) + 1;
+    uint64_t seen = __sync_val_compare_and_swap(&run_[producer_id], run, extended);
+    while (seen != run){
+      run = seen;
+      extended = (((run >> 8) == interval) ? run : (interval << 8)) + 1;
+      seen = __sync_val_compare_and_swap(&run_[producer_id], run, extended);
+    }
+    if ((extended & 0xFF) >= timestamp_tracker_run_length){
+      __sync_bool_compare_and_swap(&delta_[producer_id], recorded, interval);
+      __sync_bool_compare_and_swap(&run_[producer_id], extended, 0);
+    }
+  }
+
+  uint64_t LATRDTimestampTracker::delta(uint8_t producer_id)
+  {
+    return delta_[producer_id];
+  }
+
+  uint64_t LATRDTimestampTracker::previous(uint8_t producer_id, uint64_t current_timestamp)
+  {
+    uint64_t interval = delta_[producer_id];
+    if (interval == 0){
+      interval = LATRD::course_timestamp_rollover;
+    }
+    return current_timestamp - interval;
+  }
+
+  uint64_t LATRDTimestampTracker::mismatches()
+  {
+    return mismatches_;
+  }
+
+}
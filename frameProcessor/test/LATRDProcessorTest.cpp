@@ -14,9 +14,32 @@
 using namespace log4cxx;
 using namespace log4cxx::xml;
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
 #include "LATRDBuffer.h"
+#include "LATRDCompressor.h"
+#include "LATRDEventCodec.h"
+#include "LATRDEventFilter.h"
+#include "LATRDHistogram.h"
+#include "LATRDImageJob.h"
+#include "LATRDImageBinner.h"
+#include "LATRDImageReducer.h"
+#include "LATRDPixelGeometry.h"
+#include "LATRDEnergyCalibration.h"
+#include "LATRDFlatField.h"
+#include "LATRDClusterer.h"
+#include "LATRDFrameCounter.h"
+#include "LATRDJobArena.h"
+#include "LATRDMemoryBlock.h"
+#include "LATRDNumaTopology.h"
+#include "LATRDRoiIntegrator.h"
 #include "LATRDProcessCoordinator.h"
+#include "LATRDProcessIntegral.h"
+#include "LATRDProcessPlugin.h"
 #include "LATRDTimestampManager.h"
+#include "LATRDTimestampTracker.h"
 
 class GlobalConfig {
 public:
@@ -36,6 +59,32 @@ private:
 };
 BOOST_GLOBAL_FIXTURE(GlobalConfig);
 
+// Records the binary meta messages published by the class under test
+class TestMetaPublisher : public FrameProcessor::MetaMessagePublisher {
+public:
+  void publish_meta(const std::string& name, const std::string& item, int32_t value, const std::string& header = "") {}
+  void publish_meta(const std::string& name, const std::string& item, uint64_t value, const std::string& header = "") {}
+  void publish_meta(const std::string& name, const std::string& item, double value, const std::string& header = "") {}
+  void publish_meta(const std::string& name, const std::string& item, const std::string& value, const std::string& header = "") {}
+  void publish_meta(const std::string& name, const std::string& item, const void *pValue, size_t length, const std::string& header = "")
+  {
+    items.push_back(item);
+    values.push_back(std::vector<uint64_t>((const uint64_t *)pValue, (const uint64_t *)pValue + (length / sizeof(uint64_t))));
+  }
+  std::vector<std::string> items;
+  std::vector<std::vector<uint64_t> > values;
+};
+
+// Records the frames pushed by the plugin under test
+class TestFrameCallback : public FrameProcessor::IFrameCallback {
+public:
+  void callback(boost::shared_ptr<FrameProcessor::Frame> frame)
+  {
+    frames.push_back(frame);
+  }
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames;
+};
+
 BOOST_AUTO_TEST_SUITE(BufferUnitTest);
 
 BOOST_AUTO_TEST_CASE(BufferTest)
@@ -71,12 +120,947 @@ BOOST_AUTO_TEST_CASE(BufferTest)
   BOOST_CHECK(frame);
   // Verify the frame has frame number 7
   BOOST_CHECK_EQUAL(frame->get_frame_number(), 7);
+  // Verify the dataset position of the next point is the start of frame 10
+  BOOST_CHECK_EQUAL(buffer.position(), 200);
+  BOOST_CHECK_NO_THROW(frame = buffer.appendData(data1, 5));
+  BOOST_CHECK_EQUAL(buffer.position(), 205);
 
 }
 
+BOOST_AUTO_TEST_CASE(BufferAllocateTest)
+{
+  FrameProcessor::LATRDBuffer buffer(10, "test_buffer", FrameProcessor::UINT32_TYPE);
+  uint32_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  boost::shared_ptr<FrameProcessor::Frame> frame;
+  // Fill a complete frame so the buffer is reused without clearing
+  frame = buffer.appendData(data, 10);
+  BOOST_REQUIRE(frame);
+  // A partial frame must not contain points from the previous frame
+  buffer.appendData(data, 3);
+  frame = buffer.retrieveCurrentFrame();
+  BOOST_REQUIRE(frame);
+  const uint32_t *values = static_cast<const uint32_t *>(frame->get_data());
+  BOOST_CHECK_EQUAL(values[2], 3);
+  BOOST_CHECK_EQUAL(values[3], 0);
+  BOOST_CHECK_EQUAL(values[9], 0);
+
+  // A complete frame is numbered and forwarded in place of the buffer's own frame
+  boost::shared_ptr<FrameProcessor::Frame> full(new FrameProcessor::Frame("received"));
+  full->copy_data(data, sizeof(data));
+  frame = buffer.forwardFrame(full);
+  BOOST_CHECK(frame == full);
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 2);
+  BOOST_CHECK_EQUAL(buffer.position(), 30);
+  boost::shared_ptr<FrameProcessor::Frame> partial(new FrameProcessor::Frame("received"));
+  partial->copy_data(data, 3 * sizeof(uint32_t));
+  BOOST_CHECK_THROW(buffer.forwardFrame(partial), FrameProcessor::LATRDProcessingException);
+  buffer.appendData(data, 3);
+  BOOST_CHECK_THROW(buffer.forwardFrame(full), FrameProcessor::LATRDProcessingException);
+  buffer.retrieveCurrentFrame();
+
+  // An empty buffer can be reallocated, falling back to normal pages if required
+  BOOST_CHECK_NO_THROW(buffer.allocate(true));
+  BOOST_CHECK_NO_THROW(buffer.allocate(false));
+  BOOST_CHECK(!buffer.hugePages());
+  // A buffer holding points cannot be reallocated
+  buffer.appendData(data, 3);
+  BOOST_CHECK_THROW(buffer.allocate(true), FrameProcessor::LATRDProcessingException);
+}
+
+BOOST_AUTO_TEST_CASE(BufferFrameCounterTest)
+{
+  // Two buffers from different ranks sharing a frame counter
+  boost::shared_ptr<FrameProcessor::LATRDFrameCounter> counter1(new FrameProcessor::LATRDFrameCounter("latrd_test_counter"));
+  boost::shared_ptr<FrameProcessor::LATRDFrameCounter> counter2(new FrameProcessor::LATRDFrameCounter("latrd_test_counter"));
+  counter1->reset();
+  FrameProcessor::LATRDBuffer buffer1(10, "test_buffer", FrameProcessor::UINT32_TYPE);
+  FrameProcessor::LATRDBuffer buffer2(10, "test_buffer", FrameProcessor::UINT32_TYPE);
+  boost::shared_ptr<FrameProcessor::LATRDBuffer> leader(new FrameProcessor::LATRDBuffer(10, "leader", FrameProcessor::UINT32_TYPE));
+  FrameProcessor::LATRDBuffer follower(10, "follower", FrameProcessor::UINT32_TYPE);
+  buffer1.setFrameCounter(counter1, FrameProcessor::EVENT_FRAME_SLOT);
+  buffer2.setFrameCounter(counter2, FrameProcessor::EVENT_FRAME_SLOT);
+  leader->setFrameCounter(counter1, FrameProcessor::CUE_FRAME_SLOT);
+  follower.followFrameNumbers(leader);
+  uint32_t data[15] = {0};
+  boost::shared_ptr<FrameProcessor::Frame> frame;
+
+  // Frame numbers are taken in the order frames are started, whichever rank starts them
+  BOOST_CHECK(!buffer2.appendData(data, 5));
+  BOOST_CHECK(!buffer1.appendData(data, 5));
+  frame = buffer1.appendData(data, 5);
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 1);
+  frame = buffer2.appendData(data, 5);
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 0);
+  // A frame started by a position request is written even without points
+  BOOST_CHECK_EQUAL(buffer1.position(), 20);
+  frame = buffer1.retrieveCurrentFrame();
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 2);
+
+  // Following buffers share the frame numbers of the leader when appended in step
+  BOOST_CHECK(!leader->appendData(data, 5));
+  BOOST_CHECK(!follower.appendData(data, 5));
+  frame = leader->appendData(data, 10);
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 0);
+  frame = follower.appendData(data, 10);
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 0);
+  frame = follower.retrieveCurrentFrame();
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 1);
+  frame = leader->retrieveCurrentFrame();
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 1);
+
+  // A follower that never receives points does not write the frames claimed by its leader
+  FrameProcessor::LATRDBuffer unused(10, "unused", FrameProcessor::UINT32_TYPE);
+  unused.followFrameNumbers(leader);
+  BOOST_CHECK(!leader->appendData(data, 5));
+  BOOST_CHECK(!unused.retrieveCurrentFrame());
+  frame = leader->retrieveCurrentFrame();
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 2);
+  // and once reset, a used follower is idle until it receives points again
+  follower.resetFrameNumber();
+  BOOST_CHECK(leader->position() > 0);
+  BOOST_CHECK(!follower.retrieveCurrentFrame());
+  BOOST_CHECK(leader->retrieveCurrentFrame());
+  counter1->reset();
+  shm_unlink(counter1->name().c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END(); //BufferUnitTest
 
 
+// Unit tests for the LATRDCompressor class
+BOOST_AUTO_TEST_SUITE(CompressorUnitTest);
+
+BOOST_AUTO_TEST_CASE(CompressorTest)
+{
+  // Create a set of increasing timestamps
+  uint64_t data[2050];
+  uint64_t copy[2050];
+  for (int index = 0; index < 2050; index++){
+    data[index] = 5877939652317ULL + (index * 37) + (index % 5);
+    copy[index] = data[index];
+  }
+
+  // Delta encode and verify the values can be recovered
+  FrameProcessor::LATRDCompressor::delta_encode(copy, 2050);
+  BOOST_CHECK_EQUAL(copy[0], data[0]);
+  BOOST_CHECK_EQUAL(copy[1], data[1] - data[0]);
+  FrameProcessor::LATRDCompressor::delta_decode(copy, 2050);
+  BOOST_CHECK(memcmp(data, copy, sizeof(data)) == 0);
+
+  // Shuffle 8 elements and verify bit 0 of every element is collected into the first byte
+  uint32_t elements[8] = {1, 0, 1, 1, 0, 0, 0, 1};
+  uint32_t shuffled[8];
+  uint32_t unshuffled[8];
+  FrameProcessor::LATRDCompressor::bitshuffle(elements, shuffled, 8, sizeof(uint32_t));
+  BOOST_CHECK_EQUAL(((uint8_t *)shuffled)[0], 0x8D);
+  BOOST_CHECK_EQUAL(((uint8_t *)shuffled)[1], 0x00);
+  FrameProcessor::LATRDCompressor::bitunshuffle(shuffled, unshuffled, 8, sizeof(uint32_t));
+  BOOST_CHECK(memcmp(elements, unshuffled, sizeof(elements)) == 0);
+
+  // Compress a full block plus a partial block and leftover elements
+  if (FrameProcessor::LATRDCompressor::available()){
+    std::vector<char> compressed(FrameProcessor::LATRDCompressor::bslz4_bound(2050, sizeof(uint64_t)));
+    size_t bytes = 0;
+    BOOST_CHECK_NO_THROW(bytes = FrameProcessor::LATRDCompressor::compress_bslz4(data, &compressed[0], 2050, sizeof(uint64_t)));
+    BOOST_CHECK(bytes < sizeof(data));
+    memset(copy, 0, sizeof(copy));
+    BOOST_CHECK_EQUAL(FrameProcessor::LATRDCompressor::decompress_bslz4(&compressed[0], bytes, copy, sizeof(copy), sizeof(uint64_t)), sizeof(data));
+    BOOST_CHECK(memcmp(data, copy, sizeof(data)) == 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //CompressorUnitTest
+
+
+// Unit tests for the LATRDEventCodec class
+BOOST_AUTO_TEST_SUITE(EventCodecUnitTest);
+
+BOOST_AUTO_TEST_CASE(EventCodecTest)
+{
+  // Events with full range values and an out of order timestamp
+  uint64_t ts[4] = {0x000FFFFFFFFFFFFFULL, 5877939652317ULL, 5877939652320ULL, 5877939652300ULL};
+  uint32_t id[4] = {0x03FFFFFF, 0, 12345, 8193};
+  uint32_t energy[4] = {0x3FFF, 1, 0x1000, 0x0FFF};
+  uint64_t out_ts[4];
+  uint32_t out_id[4];
+  uint32_t out_energy[4];
+
+  // Pack into records and verify the values are recovered
+  uint32_t records[4 * FrameProcessor::packed_event_words];
+  BOOST_CHECK_EQUAL(FrameProcessor::LATRDEventCodec::pack_records(ts, id, energy, 4, records), 12);
+  FrameProcessor::LATRDEventCodec::unpack_records(records, 4, out_ts, out_id, out_energy);
+  for (int index = 0; index < 4; index++){
+    BOOST_CHECK_EQUAL(out_ts[index], ts[index]);
+    BOOST_CHECK_EQUAL(out_id[index], id[index]);
+    BOOST_CHECK_EQUAL(out_energy[index], energy[index]);
+  }
+
+  // Encode two varint blocks followed by zero padding and verify the stream decodes
+  std::vector<uint8_t> stream(FrameProcessor::LATRDEventCodec::varint_bound(4) * 2 + 16, 0);
+  size_t bytes = FrameProcessor::LATRDEventCodec::encode_varint_block(ts, id, energy, 4, &stream[0]);
+  bytes += FrameProcessor::LATRDEventCodec::encode_varint_block(&ts[1], &id[1], &energy[1], 3, &stream[bytes]);
+  std::vector<uint64_t> dec_ts;
+  std::vector<uint32_t> dec_id;
+  std::vector<uint32_t> dec_energy;
+  BOOST_CHECK_EQUAL(FrameProcessor::LATRDEventCodec::decode_varint_stream(&stream[0], bytes + 16, dec_ts, dec_id, dec_energy), 7);
+  BOOST_CHECK_EQUAL(dec_ts[0], ts[0]);
+  BOOST_CHECK_EQUAL(dec_ts[3], ts[3]);
+  BOOST_CHECK_EQUAL(dec_ts[6], ts[3]);
+  BOOST_CHECK_EQUAL(dec_id[5], id[2]);
+  BOOST_CHECK_EQUAL(dec_energy[4], energy[1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //EventCodecUnitTest
+
+
+// Unit tests for the LATRDMemoryBlock class
+BOOST_AUTO_TEST_SUITE(MemoryBlockUnitTest);
+
+BOOST_AUTO_TEST_CASE(MemoryBlockTest)
+{
+  FrameProcessor::LATRDMemoryBlock block(1000, false, 64);
+  BOOST_CHECK_EQUAL(block.bytes(), 1000);
+  BOOST_CHECK(!block.huge_pages());
+  BOOST_CHECK_EQUAL((uintptr_t)block.data() % 64, 0);
+  // The block is zeroed when it is allocated
+  const uint8_t *bytes = (const uint8_t *)block.data();
+  BOOST_CHECK_EQUAL(bytes[0], 0);
+  BOOST_CHECK_EQUAL(bytes[999], 0);
+
+  // Huge pages fall back to normal pages when they are unavailable, but the
+  // block is always huge page aligned and large enough
+  FrameProcessor::LATRDMemoryBlock huge_block(1000, true, 64);
+  BOOST_CHECK(huge_block.bytes() >= 1000);
+  BOOST_CHECK_EQUAL((uintptr_t)huge_block.data() % FrameProcessor::huge_page_size, 0);
+  ((uint8_t *)huge_block.data())[999] = 1;
+  // Only reserved huge pages are reported, these are mapped in whole pages
+  if (huge_block.huge_pages()){
+    BOOST_CHECK_EQUAL(huge_block.bytes() % FrameProcessor::huge_page_size, 0);
+  } else {
+    BOOST_CHECK_EQUAL(huge_block.bytes(), 1000);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //MemoryBlockUnitTest
+
+// Unit tests for the LATRDNumaTopology class
+BOOST_AUTO_TEST_SUITE(NumaTopologyUnitTest);
+
+BOOST_AUTO_TEST_CASE(NumaTopologyTest)
+{
+  // CPU lists are made of single CPUs and ranges
+  std::vector<int> cpus = FrameProcessor::LATRDNumaTopology::parse_cpu_list("0-3,8,10-11\n");
+  BOOST_REQUIRE_EQUAL(cpus.size(), 7);
+  BOOST_CHECK_EQUAL(cpus[0], 0);
+  BOOST_CHECK_EQUAL(cpus[3], 3);
+  BOOST_CHECK_EQUAL(cpus[4], 8);
+  BOOST_CHECK_EQUAL(cpus[6], 11);
+  BOOST_CHECK(FrameProcessor::LATRDNumaTopology::parse_cpu_list("").empty());
+
+  // Without NUMA information there is a single node that places no restriction
+  FrameProcessor::LATRDNumaTopology missing("/latrd/no/such/node/path");
+  BOOST_CHECK_EQUAL(missing.nodes(), 1);
+  BOOST_CHECK(missing.cpus(0).empty());
+  BOOST_CHECK(!missing.bind_thread(0, 0));
+
+  // Binding to a node of the host can always be undone
+  FrameProcessor::LATRDNumaTopology topology;
+  BOOST_CHECK(topology.nodes() >= 1);
+  cpu_set_t previous;
+  topology.bind_thread(0, &previous);
+  topology.restore_thread(&previous);
+  cpu_set_t current;
+  CPU_ZERO(&current);
+  pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &current);
+  BOOST_CHECK(CPU_EQUAL(&current, &previous));
+  // A touched page is reported on a node, or -1 if the kernel has no NUMA support
+  std::vector<uint64_t> data(1024, 1);
+  BOOST_CHECK(topology.node_of(&data[0]) < (int)topology.nodes());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //NumaTopologyUnitTest
+
+// Unit tests for the LATRDJobArena class
+BOOST_AUTO_TEST_SUITE(JobArenaUnitTest);
+
+BOOST_AUTO_TEST_CASE(JobArenaTest)
+{
+  FrameProcessor::LATRDJobArena arena(4, 100, false);
+  BOOST_CHECK_EQUAL(arena.jobs(), 4);
+  BOOST_CHECK_EQUAL(arena.bytes(), 4 * FrameProcessor::LATRDProcessJob::storage_size(100));
+  std::vector<boost::shared_ptr<FrameProcessor::LATRDProcessJob> > jobs = arena.create_jobs();
+  BOOST_REQUIRE_EQUAL(jobs.size(), 4);
+  for (size_t index = 0; index < jobs.size(); index++) {
+    // Every array starts on its own cache line
+    BOOST_CHECK_EQUAL((uintptr_t)jobs[index]->event_ts_ptr % FrameProcessor::job_array_alignment, 0);
+    BOOST_CHECK_EQUAL((uintptr_t)jobs[index]->event_energy_ptr % FrameProcessor::job_array_alignment, 0);
+    BOOST_CHECK_EQUAL((uintptr_t)jobs[index]->event_packed_ptr % FrameProcessor::job_array_alignment, 0);
+    // Jobs are laid out one after another and do not overlap
+    if (index > 0) {
+      BOOST_CHECK((uint8_t *)jobs[index]->event_ts_ptr >= jobs[index - 1]->event_packed_ptr + FrameProcessor::LATRDEventCodec::varint_bound(100));
+    }
+    // Writing to the last element of each array must be safe
+    jobs[index]->event_ts_ptr[99] = 1;
+    jobs[index]->ctrl_event_index_ptr[99] = 1;
+    jobs[index]->event_packed_ptr[FrameProcessor::LATRDEventCodec::varint_bound(100) - 1] = 1;
+  }
+
+  // Huge pages fall back to normal pages when they are unavailable
+  FrameProcessor::LATRDJobArena huge_arena(2, 100, true);
+  BOOST_CHECK(huge_arena.bytes() >= 2 * FrameProcessor::LATRDProcessJob::storage_size(100));
+  BOOST_CHECK_EQUAL(huge_arena.create_jobs().size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //JobArenaUnitTest
+
+
+// Unit tests for the LATRDEventFilter class
+BOOST_AUTO_TEST_SUITE(EventFilterUnitTest);
+
+BOOST_AUTO_TEST_CASE(EventFilterTest)
+{
+  // Position IDs hold x in the upper bits and y in the lower 13 bits
+  uint64_t ts[6] = {10, 11, 12, 13, 14, 15};
+  uint32_t id[6] = {(1 << 13) | 1, (2 << 13) | 2, (3 << 13) | 3, (1 << 13) | 2, (0 << 13) | 0, (9 << 13) | 1};
+  uint32_t energy[6] = {100, 50, 100, 100, 100, 100};
+  uint32_t ctrl_index[3] = {0, 2, 6};
+  uint32_t energy_rejects = 0;
+  uint32_t roi_rejects = 0;
+  uint32_t mask_rejects = 0;
+
+  FrameProcessor::LATRDEventFilter filter(4, 4);
+  BOOST_CHECK(!filter.enabled());
+  BOOST_CHECK_THROW(filter.set_energy_window(200, 100), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_THROW(filter.set_mask(std::vector<uint8_t>(15, 0)), FrameProcessor::LATRDProcessingException);
+  filter.set_energy_window(80, 120);
+  filter.set_roi(1, 1, 3, 3);
+  std::vector<uint8_t> mask(16, 0);
+  mask[2 * 4 + 1] = 1;
+  filter.set_mask(mask);
+  BOOST_CHECK(filter.enabled());
+
+  // Keeps events 0 and 2, the others are rejected by energy, mask, ROI and ROI
+  uint16_t kept = filter.filter(ts, id, id, energy, 6, ctrl_index, 3, &energy_rejects, &roi_rejects, &mask_rejects);
+  BOOST_CHECK_EQUAL(kept, 2);
+  BOOST_CHECK_EQUAL(ts[0], 10);
+  BOOST_CHECK_EQUAL(ts[1], 12);
+  BOOST_CHECK_EQUAL(id[1], (3 << 13) | 3);
+  BOOST_CHECK_EQUAL(energy_rejects, 1);
+  BOOST_CHECK_EQUAL(roi_rejects, 2);
+  BOOST_CHECK_EQUAL(mask_rejects, 1);
+  // Control word indexes are moved to the kept events
+  BOOST_CHECK_EQUAL(ctrl_index[0], 0);
+  BOOST_CHECK_EQUAL(ctrl_index[1], 1);
+  BOOST_CHECK_EQUAL(ctrl_index[2], 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //EventFilterUnitTest
+
+
+// Unit tests for the LATRDHistogramSet and LATRDHistogramExchange classes
+BOOST_AUTO_TEST_SUITE(HistogramUnitTest);
+
+BOOST_AUTO_TEST_CASE(HistogramTest)
+{
+  FrameProcessor::LATRDProcessJob job(8);
+  job.valid_results = 4;
+  job.time_slice = 7;
+  job.producer_id = 3;
+  job.event_energy_ptr[0] = 10;
+  job.event_energy_ptr[1] = 10;
+  job.event_energy_ptr[2] = 16383;
+  job.event_energy_ptr[3] = 0;
+
+  // Add the job through an exchange and collect it into a total
+  FrameProcessor::LATRDHistogramExchange exchange;
+  FrameProcessor::LATRDHistogramSet total;
+  BOOST_CHECK(total.empty());
+  FrameProcessor::LATRDHistogramSet *set = exchange.begin_job();
+  set->add_job(&job, true);
+  exchange.end_job();
+  exchange.collect(total);
+  BOOST_CHECK_EQUAL(total.events, 4);
+  BOOST_CHECK_EQUAL(total.energy[10], 2);
+  BOOST_CHECK_EQUAL(total.energy[16383], 1);
+  BOOST_CHECK_EQUAL(total.time_slices[7], 4);
+  BOOST_CHECK_EQUAL(total.modules[3][0], 1);
+
+  // The next job is written into the other set, and the collected set was cleared
+  set = exchange.begin_job();
+  set->add_job(&job, false);
+  exchange.end_job();
+  exchange.collect(total);
+  BOOST_CHECK_EQUAL(total.events, 8);
+  BOOST_CHECK_EQUAL(total.energy[10], 4);
+  BOOST_CHECK_EQUAL(total.modules[3][10], 2);
+  exchange.collect(total);
+  BOOST_CHECK_EQUAL(total.events, 8);
+  total.clear();
+  BOOST_CHECK(total.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //HistogramUnitTest
+
+
+// Unit tests for the LATRDImageBinner class
+BOOST_AUTO_TEST_SUITE(ImageBinnerUnitTest);
+
+BOOST_AUTO_TEST_CASE(ImageBinnerTest)
+{
+  // Two partitions binning 4x2 images 100 time units wide
+  FrameProcessor::LATRDImageBinner binner(4, 2, 100, 2);
+  FrameProcessor::LATRDProcessJob job1(4);
+  FrameProcessor::LATRDProcessJob job2(4);
+  job1.valid_results = 3;
+  job1.event_ts_ptr[0] = 1010; job1.event_id_ptr[0] = (1 << 13) | 1;
+  job1.event_ts_ptr[1] = 1020; job1.event_id_ptr[1] = (1 << 13) | 1;
+  job1.event_ts_ptr[2] = 1150; job1.event_id_ptr[2] = (3 << 13) | 0;
+  job2.valid_results = 2;
+  job2.event_ts_ptr[0] = 1099; job2.event_id_ptr[0] = (1 << 13) | 1;
+  job2.event_ts_ptr[1] = 1400; job2.event_id_ptr[1] = (9 << 13) | 0;
+  binner.bin_events(0, &job1);
+  binner.bin_events(1, &job2);
+
+  // Close up to time 1100, only the first bin is complete
+  std::vector<uint64_t> bins;
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = binner.close_bins(1100, bins);
+  BOOST_CHECK_EQUAL(frames.size(), 1);
+  BOOST_CHECK_EQUAL(bins[0], 10);
+  BOOST_CHECK_EQUAL(frames[0]->get_data_type(), 2);
+  const uint32_t *image = static_cast<const uint32_t *>(frames[0]->get_data());
+  BOOST_CHECK_EQUAL(image[1 * 4 + 1], 3);
+  BOOST_CHECK_EQUAL(image[0], 0);
+
+  // An event for the closed bin is late
+  job1.valid_results = 1;
+  binner.bin_events(0, &job1);
+  BOOST_CHECK_EQUAL(binner.late_events(), 1);
+
+  // Closing everything emits the remaining bins with data, ignoring the event outside the sensor
+  bins.clear();
+  frames = binner.close_all(bins);
+  BOOST_CHECK_EQUAL(frames.size(), 2);
+  BOOST_CHECK_EQUAL(bins[0], 11);
+  BOOST_CHECK_EQUAL(bins[1], 14);
+  BOOST_CHECK_EQUAL(frames[1]->get_frame_number(), 2);
+  image = static_cast<const uint32_t *>(frames[0]->get_data());
+  BOOST_CHECK_EQUAL(image[0 * 4 + 3], 1);
+  image = static_cast<const uint32_t *>(frames[1]->get_data());
+  BOOST_CHECK_EQUAL(image[0], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //ImageBinnerUnitTest
+
+
+// Unit tests for the LATRDClusterer class
+BOOST_AUTO_TEST_SUITE(ClustererUnitTest);
+
+BOOST_AUTO_TEST_CASE(ClustererTest)
+{
+  // Two partitions clustering with a window of 10 time units
+  FrameProcessor::LATRDClusterer clusterer(10, 2);
+  boost::shared_ptr<FrameProcessor::LATRDProcessJob> job1(new FrameProcessor::LATRDProcessJob(8));
+  boost::shared_ptr<FrameProcessor::LATRDProcessJob> job2(new FrameProcessor::LATRDProcessJob(8));
+  job1->valid_results = 4;
+  job1->event_ts_ptr[0] = 102; job1->event_id_ptr[0] = (5 << 13) | 6; job1->event_energy_ptr[0] = 30;
+  job1->event_ts_ptr[1] = 100; job1->event_id_ptr[1] = (5 << 13) | 5; job1->event_energy_ptr[1] = 10;
+  job1->event_ts_ptr[2] = 104; job1->event_id_ptr[2] = (20 << 13) | 20; job1->event_energy_ptr[2] = 5;
+  job1->event_ts_ptr[3] = 150; job1->event_id_ptr[3] = (5 << 13) | 5; job1->event_energy_ptr[3] = 7;
+  // The first event continues the first cluster across the partition boundary
+  job2->valid_results = 2;
+  job2->event_ts_ptr[0] = 108; job2->event_id_ptr[0] = (6 << 13) | 7; job2->event_energy_ptr[0] = 20;
+  job2->event_ts_ptr[1] = 300; job2->event_id_ptr[1] = (1 << 13) | 1; job2->event_energy_ptr[1] = 1;
+  std::vector<boost::shared_ptr<FrameProcessor::LATRDProcessJob> > jobs;
+  jobs.push_back(job1);
+  clusterer.cluster_events(0, jobs);
+  jobs.clear();
+  jobs.push_back(job2);
+  clusterer.cluster_events(1, jobs);
+
+  std::vector<FrameProcessor::LATRDCluster> clusters = clusterer.stitch(false);
+  BOOST_REQUIRE_EQUAL(clusters.size(), 3);
+  BOOST_CHECK_EQUAL(clusters[0].first_ts, 100);
+  BOOST_CHECK_EQUAL(clusters[0].last_ts, 108);
+  BOOST_CHECK_EQUAL(clusters[0].pixels.size(), 3);
+  BOOST_CHECK_CLOSE(clusters[0].energy, 60.0f, 0.001);
+  BOOST_CHECK_CLOSE(clusters[0].centroid_x(), 320.0f / 60.0f, 0.001);
+  BOOST_CHECK_CLOSE(clusters[0].centroid_y(), 370.0f / 60.0f, 0.001);
+  BOOST_CHECK_EQUAL(clusters[1].first_ts, 104);
+  BOOST_CHECK_EQUAL(clusters[2].first_ts, 150);
+
+  // The last cluster could still grow so is only returned once purged
+  clusters = clusterer.stitch(true);
+  BOOST_REQUIRE_EQUAL(clusters.size(), 1);
+  BOOST_CHECK_EQUAL(clusters[0].first_ts, 300);
+  BOOST_CHECK_EQUAL(clusters[0].pixels.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //ClustererUnitTest
+
+
+// Unit tests for the LATRDPixelGeometry class
+BOOST_AUTO_TEST_SUITE(PixelGeometryUnitTest);
+
+BOOST_AUTO_TEST_CASE(PixelGeometryTest)
+{
+  // Two 2x3 chips in a 6x4 image, the second rotated by 90 degrees and separated by a gap
+  FrameProcessor::LATRDPixelGeometry geometry(6, 4, FrameProcessor::GEOMETRY_INDEX);
+  BOOST_CHECK_THROW(geometry.add_chip(0, 0, 2, 3, 0, 0, 45), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_THROW(geometry.add_chip(0, 0, 2, 3, 5, 0, 0), FrameProcessor::LATRDProcessingException);
+  geometry.add_chip(0, 0, 2, 3, 0, 0, 0);
+  geometry.add_chip(2, 0, 2, 3, 3, 0, 90);
+  geometry.build();
+
+  uint32_t ids[4] = {(1 << 13) | 2, (2 << 13) | 0, (3 << 13) | 2, (0 << 13) | 5};
+  uint32_t indexes[4];
+  geometry.map_indexes(ids, indexes, 4);
+  BOOST_CHECK_EQUAL(indexes[0], 2 * 6 + 1);
+  BOOST_CHECK_EQUAL(indexes[1], 5);
+  BOOST_CHECK_EQUAL(indexes[2], 1 * 6 + 3);
+  BOOST_CHECK_EQUAL(indexes[3], FrameProcessor::unmapped_pixel_index);
+
+  FrameProcessor::LATRDPixelGeometry xy_geometry(6, 4, FrameProcessor::GEOMETRY_XY);
+  xy_geometry.add_chip(2, 0, 2, 3, 3, 0, 180);
+  xy_geometry.build();
+  uint16_t x[2];
+  uint16_t y[2];
+  uint32_t xy_ids[2] = {(2 << 13) | 0, (1 << 13) | 1};
+  xy_geometry.map_coordinates(xy_ids, x, y, 2);
+  BOOST_CHECK_EQUAL(x[0], 4);
+  BOOST_CHECK_EQUAL(y[0], 2);
+  BOOST_CHECK_EQUAL(x[1], FrameProcessor::unmapped_pixel_coordinate);
+  BOOST_CHECK_EQUAL(y[1], FrameProcessor::unmapped_pixel_coordinate);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //PixelGeometryUnitTest
+
+
+// Unit tests for the LATRDEnergyCalibration class
+BOOST_AUTO_TEST_SUITE(EnergyCalibrationUnitTest);
+
+BOOST_AUTO_TEST_CASE(EnergyCalibrationTest)
+{
+  // 2x1 sensor, the first pixel is linear (ToT = 2E + 10) and the second uncalibrated
+  FrameProcessor::LATRDEnergyCalibration calibration(2, 1, FrameProcessor::FIXED_ENERGY, 4);
+  std::vector<float> coefficients(8, 0.0f);
+  BOOST_CHECK_THROW(calibration.set_coefficients(std::vector<float>(4, 1.0f)), FrameProcessor::LATRDProcessingException);
+  coefficients[0] = 2.0f;
+  coefficients[1] = 10.0f;
+  calibration.set_coefficients(coefficients);
+  BOOST_CHECK_CLOSE(calibration.energy(0, 30), 10.0f, 0.001);
+  BOOST_CHECK_EQUAL(calibration.energy(1 << 13, 30), 0.0f);
+  // Below the offset the energy is clamped at zero
+  BOOST_CHECK_EQUAL(calibration.energy(0, 4), 0.0f);
+
+  // Surrogate function with a non linear region
+  coefficients[0] = 1.0f;
+  coefficients[1] = 0.0f;
+  coefficients[2] = 8.0f;
+  coefficients[3] = 2.0f;
+  calibration.set_coefficients(coefficients);
+  // ToT = E - 8 / (E - 2) at E = 10 gives 9
+  BOOST_CHECK_CLOSE(calibration.energy(0, 9), 10.0f, 0.001);
+
+  // Fixed point output has 4 fractional bits
+  uint32_t ids[2] = {0, 1 << 13};
+  uint32_t energies[2] = {9, 9};
+  calibration.calibrate(ids, energies, 2);
+  BOOST_CHECK_EQUAL(energies[0], 160);
+  BOOST_CHECK_EQUAL(energies[1], 0);
+
+  // Float output is stored in the energy slot
+  FrameProcessor::LATRDEnergyCalibration float_calibration(2, 1, FrameProcessor::FLOAT_ENERGY, 0);
+  float_calibration.set_coefficients(coefficients);
+  energies[0] = 9;
+  float_calibration.calibrate(ids, energies, 1);
+  float value = 0.0f;
+  memcpy(&value, &energies[0], sizeof(float));
+  BOOST_CHECK_CLOSE(value, 10.0f, 0.001);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //EnergyCalibrationUnitTest
+
+
+BOOST_AUTO_TEST_SUITE(ImageJobUnitTest);
+
+BOOST_AUTO_TEST_CASE(ImageJobTest)
+{
+  FrameProcessor::LATRDImageJob image(4, 2, 7, 16, false);
+  BOOST_CHECK_EQUAL(image.get_frame_number(), 7);
+  // Without an end of image packet the image cannot be verified
+  image.add_packet(0);
+  BOOST_CHECK_EQUAL(image.verify_image(), false);
+
+  // Packets spanning several bitset words, with one missing
+  for (uint32_t packet = 1; packet < 150; packet++){
+    if (packet != 70){
+      image.add_packet(packet);
+    }
+  }
+  image.add_pixel(1, 1, 3);
+  image.add_pixel(1, 1, 2);
+  image.add_packet(150);
+  image.set_eoi(150);
+  BOOST_CHECK_EQUAL(image.verify_image(), false);
+  // Duplicated packets do not make up for the missing packet
+  image.add_packet(69);
+  BOOST_CHECK_EQUAL(image.verify_image(), false);
+  image.add_packet(70);
+  BOOST_CHECK_EQUAL(image.verify_image(), true);
+  BOOST_CHECK_EQUAL(((uint16_t *)image.image_ptr_)[5], 5);
+
+  // A reset image is ready to be reused with a new image number
+  image.reset();
+  image.set_frame_number(8);
+  BOOST_CHECK_EQUAL(image.get_frame_number(), 8);
+  BOOST_CHECK_EQUAL(((uint16_t *)image.image_ptr_)[5], 0);
+  BOOST_CHECK_EQUAL(image.get_sent(), false);
+  image.set_eoi(64);
+  BOOST_CHECK_EQUAL(image.verify_image(), false);
+  for (uint32_t packet = 0; packet < 64; packet++){
+    image.add_packet(packet);
+  }
+  BOOST_CHECK_EQUAL(image.verify_image(), true);
+
+  // Bright pixels hold at the largest value of the image depth
+  image.add_pixel(2, 0, 65000);
+  image.add_pixel(2, 0, 1000);
+  BOOST_CHECK_EQUAL(((uint16_t *)image.image_ptr_)[2], 65535);
+  FrameProcessor::LATRDImageJob deep_image(4, 2, 9, 32, false);
+  deep_image.add_pixel(2, 0, 65000);
+  deep_image.add_pixel(2, 0, 1000);
+  BOOST_CHECK_EQUAL(((uint32_t *)deep_image.image_ptr_)[2], 66000);
+  ((uint32_t *)deep_image.image_ptr_)[3] = 0xFFFFFFF0;
+  deep_image.add_pixel(3, 0, 100);
+  BOOST_CHECK_EQUAL(((uint32_t *)deep_image.image_ptr_)[3], 0xFFFFFFFF);
+  boost::shared_ptr<FrameProcessor::Frame> frame = deep_image.to_frame();
+  BOOST_CHECK_EQUAL(frame->get_data_type(), 2);
+  BOOST_CHECK_EQUAL(frame->get_data_size(), 4 * 2 * sizeof(uint32_t));
+  BOOST_CHECK_THROW(FrameProcessor::LATRDImageJob(4, 2, 0, 8, false), FrameProcessor::LATRDProcessingException);
+
+  // Images taken from a pool share its memory without overlapping
+  boost::shared_ptr<FrameProcessor::LATRDMemoryBlock> pool(new FrameProcessor::LATRDMemoryBlock(128, false, 64));
+  FrameProcessor::LATRDImageJob first(4, 2, 0, 16, pool, 0);
+  FrameProcessor::LATRDImageJob second(4, 2, 1, 16, pool, 64);
+  BOOST_CHECK_EQUAL(second.image_ptr_, (uint8_t *)pool->data() + 64);
+  first.add_pixel(3, 1, 4);
+  second.add_pixel(0, 0, 9);
+  BOOST_CHECK_EQUAL(((uint16_t *)first.image_ptr_)[7], 4);
+  BOOST_CHECK_EQUAL(((uint16_t *)first.image_ptr_)[0], 0);
+  second.reset();
+  BOOST_CHECK_EQUAL(((uint16_t *)second.image_ptr_)[0], 0);
+  BOOST_CHECK_EQUAL(((uint16_t *)first.image_ptr_)[7], 4);
+  BOOST_CHECK_EQUAL(first.to_frame()->get_data_size(), 16);
+  BOOST_CHECK_THROW(FrameProcessor::LATRDImageJob(4, 2, 2, 32, pool, 100), FrameProcessor::LATRDProcessingException);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //ImageJobUnitTest
+
+
+// Decodes six count mode frames of random counts into twelve images.  Four images are
+// interleaved, and the last packets of every second frame end them
+std::vector<boost::shared_ptr<FrameProcessor::Frame> > process_count_frames(FrameProcessor::LATRDProcessIntegral& integral,
+                                                                             uint32_t width,
+                                                                             uint32_t height)
+{
+  std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > images;
+  uint32_t seed = 12345;
+  uint32_t next_packet[4] = {0, 0, 0, 0};
+  for (int frame_index = 0; frame_index < 6; frame_index++){
+    memset(&buffer[0], 0, buffer.size());
+    LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+    uint64_t *packets = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader));
+    for (int index = 0; index < LATRD::num_primary_packets; index++){
+      uint32_t image = (uint32_t)(frame_index / 2) * 4 + (index % 4);
+      uint64_t *packet = packets + (index * (LATRD::primary_packet_size / sizeof(uint64_t)));
+      header->packet_state[index] = 1;
+      uint64_t words = 3;
+      for (int word = 0; word < 200; word++){
+        seed = seed * 1103515245 + 12345;
+        uint64_t x = (seed >> 8) % width;
+        uint64_t y = (seed >> 16) % height;
+        packet[1 + words++] = FrameProcessor::integral_data_word_value | (x << 37) | (y << 24) | ((seed >> 4) & 0x3FF);
+      }
+      if ((frame_index % 2) == 1 && index >= LATRD::num_primary_packets - 4){
+        packet[1 + words++] = FrameProcessor::integral_final_packet_value;
+      }
+      packet[1] = words;
+      packet[2] = ((uint64_t)image << 32) | next_packet[index % 4]++;
+    }
+    if ((frame_index % 2) == 1){
+      memset(next_packet, 0, sizeof(next_packet));
+    }
+    boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+    frame->copy_data(&buffer[0], buffer.size());
+    std::vector<boost::shared_ptr<FrameProcessor::Frame> > frame_images = integral.process_frame(frame);
+    images.insert(images.end(), frame_images.begin(), frame_images.end());
+  }
+  return images;
+}
+
+BOOST_AUTO_TEST_SUITE(IntegralUnitTest);
+
+BOOST_AUTO_TEST_CASE(IntegralParallelTest)
+{
+  // Count mode frames decoded by a task pool must give the same images as a single thread.
+  // The sensor has many rows so that every worker accumulates a band of several rows
+  uint32_t width = 64;
+  uint32_t height = 48;
+  FrameProcessor::LATRDProcessIntegral serial;
+  FrameProcessor::LATRDProcessIntegral parallel;
+  serial.init(width, height, 16, false);
+  parallel.init(width, height, 16, false);
+  parallel.set_task_pool(boost::shared_ptr<FrameProcessor::LATRDTaskPool>(new FrameProcessor::LATRDTaskPool(4)));
+
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > serial_images = process_count_frames(serial, width, height);
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > parallel_images = process_count_frames(parallel, width, height);
+  BOOST_REQUIRE_EQUAL(serial_images.size(), 12);
+  BOOST_REQUIRE_EQUAL(parallel_images.size(), serial_images.size());
+  for (size_t index = 0; index < serial_images.size(); index++){
+    BOOST_CHECK_EQUAL(parallel_images[index]->get_frame_number(), serial_images[index]->get_frame_number());
+    BOOST_REQUIRE_EQUAL(parallel_images[index]->get_data_size(), width * height * sizeof(uint16_t));
+    BOOST_CHECK_EQUAL(memcmp(parallel_images[index]->get_data(), serial_images[index]->get_data(),
+                             width * height * sizeof(uint16_t)), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(IntegralSaturationTest)
+{
+  // The sensor is small so that many pixels saturate at 16 bits
+  uint32_t width = 8;
+  uint32_t height = 4;
+  boost::shared_ptr<FrameProcessor::LATRDTaskPool> pool(new FrameProcessor::LATRDTaskPool(4));
+  uint32_t depths[2] = {16, 32};
+  uint32_t saturated[2] = {0, 0};
+  for (int depth_index = 0; depth_index < 2; depth_index++){
+    uint32_t depth = depths[depth_index];
+    FrameProcessor::LATRDProcessIntegral integral;
+    integral.init(width, height, depth, false);
+    integral.set_task_pool(pool);
+
+    std::vector<boost::shared_ptr<FrameProcessor::Frame> > images = process_count_frames(integral, width, height);
+    size_t image_bytes = width * height * (depth / 8);
+    BOOST_REQUIRE_EQUAL(images.size(), 12);
+    for (size_t index = 0; index < images.size(); index++){
+      BOOST_CHECK_EQUAL(images[index]->get_data_type(), depth == 32 ? 2 : 1);
+      BOOST_REQUIRE_EQUAL(images[index]->get_data_size(), image_bytes);
+      for (size_t pixel = 0; pixel < width * height; pixel++){
+        if (depth == 16){
+          saturated[depth_index] += ((const uint16_t *)images[index]->get_data())[pixel] == 0xFFFF;
+        } else {
+          saturated[depth_index] += ((const uint32_t *)images[index]->get_data())[pixel] >= 0xFFFF;
+        }
+      }
+    }
+  }
+  // Every pixel that saturates at 16 bits holds at least as many counts at 32 bits
+  BOOST_CHECK(saturated[0] > 0);
+  BOOST_CHECK_EQUAL(saturated[0], saturated[1]);
+}
+
+BOOST_AUTO_TEST_CASE(ImageReducerTest)
+{
+  BOOST_CHECK_THROW(FrameProcessor::LATRDImageReducer(4, 4, 16, 2, 3, 0), FrameProcessor::LATRDProcessingException);
+
+  // 5x3 sensor binned 2x2 gives a 3x2 image with partial bins on the edges
+  FrameProcessor::LATRDImageReducer reducer(5, 3, 16, 2, 2, 100);
+  BOOST_CHECK_EQUAL(reducer.binned_width(), 3);
+  BOOST_CHECK_EQUAL(reducer.binned_height(), 2);
+  std::vector<uint16_t> image(15, 1);
+  image[0] = 65535;
+  image[14] = 7;
+
+  // The first image is always shown live, the sum needs two images
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = reducer.add_image(&image[0], 10, 1000);
+  BOOST_REQUIRE_EQUAL(frames.size(), 1);
+  BOOST_CHECK_EQUAL(frames[0]->get_dataset_name(), "image_live");
+  BOOST_CHECK_EQUAL(frames[0]->get_frame_number(), 10);
+  BOOST_CHECK_EQUAL(frames[0]->get_data_type(), 2);
+  const uint32_t *live = (const uint32_t *)frames[0]->get_data();
+  BOOST_CHECK_EQUAL(live[0], 65538);
+  BOOST_CHECK_EQUAL(live[2], 2);
+  BOOST_CHECK_EQUAL(live[5], 7);
+
+  // Within the live interval only the sum is emitted
+  frames = reducer.add_image(&image[0], 11, 1050);
+  BOOST_REQUIRE_EQUAL(frames.size(), 1);
+  BOOST_CHECK_EQUAL(frames[0]->get_dataset_name(), "image_sum");
+  BOOST_CHECK_EQUAL(frames[0]->get_frame_number(), 0);
+  const uint32_t *sum = (const uint32_t *)frames[0]->get_data();
+  BOOST_CHECK_EQUAL(sum[0], 131076);
+  BOOST_CHECK_EQUAL(sum[3], 4);
+  BOOST_CHECK_EQUAL(sum[5], 14);
+
+  // After the interval the live image is shown again, and a partial sum is flushed
+  frames = reducer.add_image(&image[0], 12, 1100);
+  BOOST_REQUIRE_EQUAL(frames.size(), 1);
+  BOOST_CHECK_EQUAL(frames[0]->get_frame_number(), 12);
+  frames = reducer.flush();
+  BOOST_REQUIRE_EQUAL(frames.size(), 1);
+  BOOST_CHECK_EQUAL(frames[0]->get_frame_number(), 1);
+  BOOST_CHECK_EQUAL(((const uint32_t *)frames[0]->get_data())[5], 7);
+  BOOST_CHECK_EQUAL(reducer.flush().size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(IntegralBoundsTest)
+{
+  // Positions outside the sensor must not be written into a neighbouring row or image
+  uint32_t width = 8;
+  uint32_t height = 4;
+  boost::shared_ptr<FrameProcessor::LATRDTaskPool> pool(new FrameProcessor::LATRDTaskPool(2));
+  FrameProcessor::LATRDProcessIntegral integral;
+  integral.init(width, height, 16, false);
+  integral.set_task_pool(pool);
+
+  std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+  uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader));
+  header->packet_state[0] = 1;
+  uint64_t positions[4][2] = {{1, 1}, {8, 0}, {200, 3}, {0, 4}};
+  uint64_t words = 3;
+  for (int index = 0; index < 4; index++){
+    packet[1 + words++] = FrameProcessor::integral_data_word_value | (positions[index][0] << 37) | (positions[index][1] << 24) | 5;
+  }
+  packet[1 + words++] = FrameProcessor::integral_final_packet_value;
+  packet[1] = words;
+  packet[2] = 0;
+  boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+  frame->copy_data(&buffer[0], buffer.size());
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > images = integral.process_frame(frame);
+
+  BOOST_REQUIRE_EQUAL(images.size(), 1);
+  BOOST_REQUIRE_EQUAL(images[0]->get_data_size(), width * height * sizeof(uint16_t));
+  const uint16_t *image = (const uint16_t *)images[0]->get_data();
+  for (size_t pixel = 0; pixel < width * height; pixel++){
+    BOOST_CHECK_EQUAL(image[pixel], pixel == width + 1 ? 5 : 0);
+  }
+  uint64_t late_packets = 0;
+  uint64_t forced_images = 0;
+  uint64_t dropped_words = 0;
+  integral.get_statistics(&late_packets, &forced_images, &dropped_words);
+  BOOST_CHECK_EQUAL(dropped_words, 3);
+  BOOST_CHECK_EQUAL(late_packets, 0);
+}
+
+BOOST_AUTO_TEST_CASE(IntegralLatePacketTest)
+{
+  // Image 1 is sent as soon as it is complete but held in the ring behind image 0.
+  // A packet for image 1 arriving after that must be counted as late, not added to the sent image
+  FrameProcessor::LATRDProcessIntegral integral;
+  integral.init(8, 4, 16, false);
+
+  // Image number, packet ID and end of image flag of the two packets in each frame
+  uint32_t packets[2][2][3] = {{{0, 0, 0}, {1, 0, 1}},
+                               {{1, 1, 0}, {0, 1, 1}}};
+  uint64_t expected_images[2] = {1, 0};
+  for (int frame_index = 0; frame_index < 2; frame_index++){
+    std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+    LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+    for (int index = 0; index < 2; index++){
+      uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader) + (index * LATRD::primary_packet_size));
+      header->packet_state[index] = 1;
+      uint64_t words = 3;
+      packet[1 + words++] = FrameProcessor::integral_data_word_value | ((uint64_t)1 << 37) | ((uint64_t)2 << 24) | 3;
+      if (packets[frame_index][index][2]){
+        packet[1 + words++] = FrameProcessor::integral_final_packet_value;
+      }
+      packet[1] = words;
+      packet[2] = ((uint64_t)packets[frame_index][index][0] << 32) | packets[frame_index][index][1];
+    }
+    boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+    frame->copy_data(&buffer[0], buffer.size());
+    std::vector<boost::shared_ptr<FrameProcessor::Frame> > images = integral.process_frame(frame);
+    BOOST_REQUIRE_EQUAL(images.size(), 1);
+    BOOST_CHECK_EQUAL(images[0]->get_frame_number(), expected_images[frame_index]);
+    // Every image holds the counts of its two packets except image 1, whose second packet was late
+    BOOST_CHECK_EQUAL(((const uint16_t *)images[0]->get_data())[17], frame_index == 0 ? 3 : 6);
+  }
+  uint64_t late_packets = 0;
+  uint64_t forced_images = 0;
+  uint64_t dropped_words = 0;
+  integral.get_statistics(&late_packets, &forced_images, &dropped_words);
+  BOOST_CHECK_EQUAL(late_packets, 1);
+  BOOST_CHECK_EQUAL(forced_images, 0);
+}
+
+BOOST_AUTO_TEST_CASE(FlatFieldTest)
+{
+  BOOST_CHECK_THROW(FrameProcessor::LATRDFlatField(2, 2, FrameProcessor::FIXED_FLAT_FIELD, 20), FrameProcessor::LATRDProcessingException);
+
+  // 2x2 sensor with a gain map, one masked pixel and one invalid gain
+  std::vector<float> gain(4, 1.0f);
+  gain[0] = 1.5f;
+  gain[2] = -1.0f;
+  std::vector<uint8_t> mask(4, 0);
+  mask[1] = 1;
+  std::vector<uint16_t> image(4, 10);
+  image[3] = 65535;
+
+  FrameProcessor::LATRDFlatField float_field(2, 2, FrameProcessor::FLOAT_FLAT_FIELD, 0);
+  BOOST_CHECK_THROW(float_field.set_gain(std::vector<float>(3, 1.0f)), FrameProcessor::LATRDProcessingException);
+  float_field.set_gain(gain);
+  float_field.set_mask(mask);
+  boost::shared_ptr<FrameProcessor::Frame> frame = float_field.correct(&image[0], 16, 5);
+  BOOST_CHECK_EQUAL(frame->get_dataset_name(), "image_corrected");
+  BOOST_CHECK_EQUAL(frame->get_frame_number(), 5);
+  BOOST_CHECK_EQUAL(frame->get_data_type(), 4);
+  BOOST_REQUIRE_EQUAL(frame->get_data_size(), 4 * sizeof(float));
+  const float *corrected = (const float *)frame->get_data();
+  BOOST_CHECK_CLOSE(corrected[0], 15.0f, 0.001);
+  BOOST_CHECK_EQUAL(corrected[1], 0.0f);
+  BOOST_CHECK_EQUAL(corrected[2], 0.0f);
+  BOOST_CHECK_CLOSE(corrected[3], 65535.0f, 0.001);
+
+  // Fixed point output with 4 fractional bits saturates at the largest value
+  FrameProcessor::LATRDFlatField fixed_field(2, 2, FrameProcessor::FIXED_FLAT_FIELD, 4);
+  gain[3] = 100000.0f;
+  fixed_field.set_gain(gain);
+  std::vector<uint32_t> deep_image(4, 10);
+  deep_image[3] = 0x10000000;
+  frame = fixed_field.correct(&deep_image[0], 32, 6);
+  BOOST_CHECK_EQUAL(frame->get_data_type(), 2);
+  const uint32_t *fixed = (const uint32_t *)frame->get_data();
+  BOOST_CHECK_EQUAL(fixed[0], 240);
+  BOOST_CHECK_EQUAL(fixed[1], 160);
+  BOOST_CHECK_EQUAL(fixed[2], 0);
+  BOOST_CHECK_EQUAL(fixed[3], 4294967040U);
+}
+
+BOOST_AUTO_TEST_CASE(RoiIntegratorTest)
+{
+  FrameProcessor::LATRDRoiIntegrator rois(4, 3);
+  BOOST_CHECK_THROW(rois.add_roi(0, 0, 0, 1), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_THROW(rois.add_roi(3, 0, 2, 1), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_THROW(rois.add_regions("0,0,1"), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_THROW(rois.add_regions("0,0,1,1x"), FrameProcessor::LATRDProcessingException);
+  BOOST_CHECK_EQUAL(rois.rois(), 0);
+
+  // Whole sensor, a single pixel and an overlapping 2x2 block
+  rois.add_regions("0,0,4,3; 3,2,1,1;1,1,2,2;");
+  BOOST_REQUIRE_EQUAL(rois.rois(), 3);
+
+  std::vector<uint16_t> image(12);
+  std::vector<uint32_t> deep_image(12);
+  for (size_t index = 0; index < image.size(); index++){
+    image[index] = (uint16_t)index;
+    deep_image[index] = (uint32_t)index + 0x10000000;
+  }
+  uint64_t sums[3] = {0, 0, 0};
+  rois.integrate(&image[0], 16, sums);
+  BOOST_CHECK_EQUAL(sums[0], 66);
+  BOOST_CHECK_EQUAL(sums[1], 11);
+  BOOST_CHECK_EQUAL(sums[2], 5 + 6 + 9 + 10);
+  rois.integrate(&deep_image[0], 32, sums);
+  BOOST_CHECK_EQUAL(sums[0], 66 + 12 * (uint64_t)0x10000000);
+  BOOST_CHECK_EQUAL(sums[1], 11 + (uint64_t)0x10000000);
+  BOOST_CHECK_EQUAL(sums[2], 30 + 4 * (uint64_t)0x10000000);
+  BOOST_CHECK_THROW(rois.integrate(&image[0], 8, sums), FrameProcessor::LATRDProcessingException);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //IntegralUnitTest
+
+
 BOOST_AUTO_TEST_SUITE(CoordinatorUnitTest);
 
 BOOST_AUTO_TEST_CASE(CoordinatorTest)
@@ -174,6 +1158,370 @@ BOOST_AUTO_TEST_CASE(CoordinatorTest)
 */
 }
 
+BOOST_AUTO_TEST_CASE(TimeRangeTest)
+{
+  FrameProcessor::LATRDProcessCoordinator coordinator;
+  TestMetaPublisher publisher;
+  coordinator.register_meta_message_publisher(&publisher);
+  boost::shared_ptr<FrameProcessor::Frame> frames[3];
+  for (int index = 0; index < 3; index++){
+    frames[index] = boost::shared_ptr<FrameProcessor::Frame>(new FrameProcessor::Frame("event_time_offset"));
+    frames[index]->set_frame_number(5 + index);
+  }
+
+  boost::shared_ptr<FrameProcessor::LATRDProcessJob> first_job(new FrameProcessor::LATRDProcessJob(8));
+  first_job->valid_results = 2;
+  first_job->event_ts_ptr[0] = 200;
+  first_job->event_ts_ptr[1] = 100;
+  first_job->ts_min = 100;
+  first_job->ts_max = 200;
+  boost::shared_ptr<FrameProcessor::LATRDProcessJob> spilled_job(new FrameProcessor::LATRDProcessJob(8));
+  spilled_job->valid_results = 4;
+  spilled_job->event_ts_ptr[0] = 150;
+  spilled_job->event_ts_ptr[1] = 300;
+  spilled_job->event_ts_ptr[2] = 120;
+  spilled_job->event_ts_ptr[3] = 400;
+  spilled_job->ts_min = 120;
+  spilled_job->ts_max = 400;
+  boost::shared_ptr<FrameProcessor::LATRDProcessJob> no_job;
+
+  // Nothing is published until a frame is complete
+  coordinator.update_time_range(boost::shared_ptr<FrameProcessor::Frame>(), first_job, 2);
+  BOOST_CHECK_EQUAL(publisher.items.size(), 0);
+
+  // A job spilling out of the frame after two events divides its range between the two frames
+  coordinator.update_time_range(frames[0], spilled_job, 2);
+  BOOST_REQUIRE_EQUAL(publisher.items.size(), 1);
+  BOOST_CHECK_EQUAL(publisher.items[0], "time_range");
+  BOOST_REQUIRE_EQUAL(publisher.values[0].size(), 3);
+  BOOST_CHECK_EQUAL(publisher.values[0][0], 5);
+  BOOST_CHECK_EQUAL(publisher.values[0][1], 100);
+  BOOST_CHECK_EQUAL(publisher.values[0][2], 300);
+  coordinator.update_time_range(frames[1], no_job, 0);
+  BOOST_REQUIRE_EQUAL(publisher.items.size(), 2);
+  BOOST_CHECK_EQUAL(publisher.values[1][0], 6);
+  BOOST_CHECK_EQUAL(publisher.values[1][1], 120);
+  BOOST_CHECK_EQUAL(publisher.values[1][2], 400);
+
+  // A frame without events has no range to publish
+  coordinator.update_time_range(frames[2], no_job, 0);
+  BOOST_CHECK_EQUAL(publisher.items.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(CueEventIndexTest)
+{
+  // Rank 1 of 2 writes event frames 1, 3, 5, so a job spilling out of frame 1 continues in frame 3
+  FrameProcessor::LATRDProcessCoordinator coordinator;
+  coordinator.configure_process(2, 1);
+  std::vector<boost::shared_ptr<FrameProcessor::LATRDProcessJob> > jobs(1);
+  size_t filled = 0;
+  while (filled < LATRD::frame_size - 24){
+    jobs[0] = coordinator.getJob(0, 0);
+    jobs[0]->valid_results = (uint16_t)std::min((size_t)1000, LATRD::frame_size - 24 - filled);
+    filled += jobs[0]->valid_results;
+    coordinator.add_jobs_to_buffer(jobs);
+  }
+  // Control words before the 10th event, which fits frame 1, and the 50th, which lands in frame 3
+  jobs[0] = coordinator.getJob(0, 0);
+  jobs[0]->valid_results = 100;
+  jobs[0]->valid_control_words = 2;
+  jobs[0]->ctrl_index_ptr[0] = 10;
+  jobs[0]->ctrl_index_ptr[1] = 50;
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = coordinator.add_jobs_to_buffer(jobs);
+  BOOST_CHECK_EQUAL(frames.size(), 3);
+  frames = coordinator.purge_remaining_buffers();
+  boost::shared_ptr<FrameProcessor::Frame> cue_frame;
+  for (size_t index = 0; index < frames.size(); index++){
+    BOOST_CHECK(frames[index]->get_dataset_name() != "cue_byte_offset");
+    if (frames[index]->get_dataset_name() == "cue_event_index"){
+      cue_frame = frames[index];
+    }
+  }
+  BOOST_REQUIRE(cue_frame);
+  const uint64_t *cue_index = (const uint64_t *)cue_frame->get_data();
+  BOOST_CHECK_EQUAL(cue_index[0], LATRD::frame_size + LATRD::frame_size - 24 + 10);
+  BOOST_CHECK_EQUAL(cue_index[1], (3 * LATRD::frame_size) + 26);
+
+  // Varint control words index the byte offset of their block in a dataset of their own
+  coordinator.configure_process(1, 0);
+  coordinator.configure_event_format(FrameProcessor::VARINT_EVENT_FORMAT);
+  for (int job_index = 0; job_index < 2; job_index++){
+    jobs[0] = coordinator.getJob(0, 0);
+    jobs[0]->valid_results = 10;
+    jobs[0]->packed_size = 37;
+    jobs[0]->valid_control_words = 1;
+    jobs[0]->ctrl_index_ptr[0] = 5;
+    coordinator.add_jobs_to_buffer(jobs);
+  }
+  frames = coordinator.purge_remaining_buffers();
+  cue_frame.reset();
+  for (size_t index = 0; index < frames.size(); index++){
+    BOOST_CHECK(frames[index]->get_dataset_name() != "cue_event_index");
+    if (frames[index]->get_dataset_name() == "cue_byte_offset"){
+      cue_frame = frames[index];
+    }
+  }
+  BOOST_REQUIRE(cue_frame);
+  cue_index = (const uint64_t *)cue_frame->get_data();
+  BOOST_CHECK_EQUAL(cue_index[0], 0);
+  BOOST_CHECK_EQUAL(cue_index[1], 37);
+}
+
+BOOST_AUTO_TEST_CASE(FrameCounterResetTest)
+{
+  {
+    FrameProcessor::LATRDProcessCoordinator rank0;
+    rank0.configure_process(2, 0);
+    rank0.configure_frame_counter("latrd_test_reset");
+    {
+      FrameProcessor::LATRDProcessCoordinator rank1;
+      rank1.configure_process(2, 1);
+      rank1.configure_frame_counter("latrd_test_reset");
+      boost::shared_ptr<FrameProcessor::LATRDFrameCounter> counter = rank1.get_frame_counter();
+      BOOST_CHECK_EQUAL(counter->next(FrameProcessor::EVENT_FRAME_SLOT), 0);
+      BOOST_CHECK_EQUAL(rank0.get_frame_counter()->next(FrameProcessor::EVENT_FRAME_SLOT), 1);
+      // Configuring the same name again keeps the segment the ranks already share
+      rank1.configure_frame_counter("latrd_test_reset");
+      BOOST_CHECK(rank1.get_frame_counter() == counter);
+
+      // Only rank 0 may reset the numbers shared by every rank
+      rank1.reset_frame_counter();
+      BOOST_CHECK_EQUAL(counter->next(FrameProcessor::EVENT_FRAME_SLOT), 2);
+      rank0.reset_frame_counter();
+      BOOST_CHECK_EQUAL(counter->next(FrameProcessor::EVENT_FRAME_SLOT), 0);
+    }
+    // Other ranks leave the segment in place
+    int fd = shm_open("/latrd_test_reset", O_RDWR, 0);
+    BOOST_CHECK(fd != -1);
+    if (fd != -1){
+      close(fd);
+    }
+  }
+  // Rank 0 removes it, so the next acquisition starts from zero
+  BOOST_CHECK_EQUAL(shm_open("/latrd_test_reset", O_RDWR, 0), -1);
+}
+
+BOOST_AUTO_TEST_CASE(JobPoolExhaustedTest)
+{
+  // A pool of one frame of jobs is used up by the first frame, which is held in the current wrap
+  FrameProcessor::LATRDProcessCoordinator coordinator;
+  coordinator.configure_job_pool(LATRD::num_primary_packets);
+  uint32_t wraps[3] = {0, 1, 2};
+  uint64_t expected_dropped[3] = {0, LATRD::num_primary_packets, LATRD::num_primary_packets};
+  uint64_t expected_releases[3] = {0, 0, 1};
+  uint32_t size = 0;
+  uint32_t free_jobs = 0;
+  uint64_t exhausted = 0;
+  uint64_t releases = 0;
+  uint64_t dropped = 0;
+  for (int frame_index = 0; frame_index < 3; frame_index++){
+    std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+    LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+    for (size_t index = 0; index < LATRD::num_primary_packets; index++){
+      header->packet_state[index] = 1;
+      uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader) + (index * LATRD::primary_packet_size));
+      packet[1] = ((uint64_t)wraps[frame_index] << 18) | 3;
+      packet[2] = index;
+      packet[3] = LATRD::control_word_mask | 0x800;
+    }
+    boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+    frame->set_frame_number(frame_index);
+    frame->copy_data(&buffer[0], buffer.size());
+    // The previous wrap may still receive packets, so the second frame is dropped rather than
+    // releasing it.  The third frame shows the first wrap is complete, which frees its jobs
+    BOOST_CHECK_NO_THROW(coordinator.process_frame(frame));
+    coordinator.get_job_pool_statistics(&size, &free_jobs, &exhausted, &releases, &dropped);
+    BOOST_CHECK_EQUAL(size, LATRD::num_primary_packets);
+    BOOST_CHECK_EQUAL(free_jobs, 0);
+    BOOST_CHECK_EQUAL(dropped, expected_dropped[frame_index]);
+    BOOST_CHECK_EQUAL(releases, expected_releases[frame_index]);
+  }
+  BOOST_CHECK(exhausted > 0);
+
+  // Going idle writes out everything held and returns every job to the pool
+  std::vector<char> idle_buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  ((LATRD::FrameHeader *)&idle_buffer[0])->idle_frame = 1;
+  boost::shared_ptr<FrameProcessor::Frame> idle_frame(new FrameProcessor::Frame("raw"));
+  idle_frame->copy_data(&idle_buffer[0], idle_buffer.size());
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = coordinator.process_frame(idle_frame);
+  coordinator.get_job_pool_statistics(&size, &free_jobs, &exhausted, &releases, &dropped);
+  BOOST_CHECK_EQUAL(free_jobs, LATRD::num_primary_packets);
+  // The control words of the two frames that were processed are all written
+  boost::shared_ptr<FrameProcessor::Frame> ctrl_frame;
+  for (size_t index = 0; index < frames.size(); index++){
+    if (frames[index]->get_dataset_name() == "cue_timestamp_zero"){
+      ctrl_frame = frames[index];
+    }
+  }
+  BOOST_REQUIRE(ctrl_frame);
+  const uint64_t *cue_timestamp = (const uint64_t *)ctrl_frame->get_data();
+  for (size_t index = 0; index < 2 * LATRD::num_primary_packets; index++){
+    BOOST_CHECK_EQUAL(cue_timestamp[index], 0x800);
+  }
+  BOOST_CHECK_EQUAL(cue_timestamp[2 * LATRD::num_primary_packets], 0);
+}
+
+BOOST_AUTO_TEST_CASE(GeometryConsumersTest)
+{
+  // A 2x2 chip at raw pixels (10, 20) is rotated by 180 degrees and placed at (2, 1) of a 4x4 image
+  boost::shared_ptr<FrameProcessor::LATRDPixelGeometry> geometry(
+      new FrameProcessor::LATRDPixelGeometry(4, 4, FrameProcessor::GEOMETRY_XY));
+  geometry->add_chip(10, 20, 2, 2, 2, 1, 180);
+  geometry->build();
+  // The region of interest is the image column x = 3, which no raw position falls within
+  boost::shared_ptr<FrameProcessor::LATRDEventFilter> filter(new FrameProcessor::LATRDEventFilter(4, 4));
+  filter->set_roi(3, 0, 1, 4);
+  FrameProcessor::LATRDProcessCoordinator coordinator;
+  coordinator.configure_geometry(geometry);
+  coordinator.configure_filter(filter);
+  coordinator.configure_image_binning(true, 4, 4, 0x10000000000ULL);
+  coordinator.configure_clustering(true, 0x10000000000ULL);
+
+  // Raw pixels (10, 20) twice and (10, 21) map to (3, 2) and (3, 1), while (11, 20) maps to (2, 2)
+  uint32_t raw_x[4] = {10, 10, 10, 11};
+  uint32_t raw_y[4] = {20, 20, 21, 20};
+  std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+  header->packet_state[0] = 1;
+  uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader));
+  packet[1] = 7;
+  packet[2] = 0;
+  packet[3] = LATRD::control_word_mask | 0x800;
+  for (int index = 0; index < 4; index++){
+    uint64_t position = ((uint64_t)raw_x[index] << LATRD::position_x_shift) | raw_y[index];
+    packet[4 + index] = (position << 37) | ((uint64_t)(0x10 + index) << 14) | 100;
+  }
+  boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+  frame->set_frame_number(0);
+  frame->copy_data(&buffer[0], buffer.size());
+  coordinator.process_frame(frame);
+
+  std::vector<char> idle_buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  ((LATRD::FrameHeader *)&idle_buffer[0])->idle_frame = 1;
+  boost::shared_ptr<FrameProcessor::Frame> idle_frame(new FrameProcessor::Frame("raw"));
+  idle_frame->copy_data(&idle_buffer[0], idle_buffer.size());
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = coordinator.process_frame(idle_frame);
+  std::map<std::string, boost::shared_ptr<FrameProcessor::Frame> > datasets;
+  for (size_t index = 0; index < frames.size(); index++){
+    datasets[frames[index]->get_dataset_name()] = frames[index];
+  }
+
+  // The filter rejects only the event mapped outside of the region
+  uint64_t energy_rejects = 0;
+  uint64_t roi_rejects = 0;
+  uint64_t mask_rejects = 0;
+  coordinator.get_filter_statistics(&energy_rejects, &roi_rejects, &mask_rejects);
+  BOOST_CHECK_EQUAL(roi_rejects, 1);
+  BOOST_REQUIRE(datasets.count("event_x") > 0);
+  const uint16_t *event_x = (const uint16_t *)datasets["event_x"]->get_data();
+  const uint16_t *event_y = (const uint16_t *)datasets["event_y"]->get_data();
+  BOOST_CHECK_EQUAL(event_x[2], 3);
+  BOOST_CHECK_EQUAL(event_y[2], 1);
+
+  // The events are binned at their image pixels
+  BOOST_REQUIRE(datasets.count("image") > 0);
+  const uint32_t *image = (const uint32_t *)datasets["image"]->get_data();
+  BOOST_CHECK_EQUAL(image[2 * 4 + 3], 2);
+  BOOST_CHECK_EQUAL(image[1 * 4 + 3], 1);
+  BOOST_CHECK_EQUAL(image[2 * 4 + 2], 0);
+
+  // and the neighbouring image pixels form one cluster with its centroid in image coordinates
+  BOOST_CHECK_EQUAL(coordinator.get_cluster_count(), 1);
+  BOOST_REQUIRE(datasets.count("cluster_x") > 0);
+  const float *cluster_x = (const float *)datasets["cluster_x"]->get_data();
+  const float *cluster_y = (const float *)datasets["cluster_y"]->get_data();
+  BOOST_CHECK_CLOSE(cluster_x[0], 3.0f, 0.001);
+  BOOST_CHECK_CLOSE(cluster_y[0], 5.0f / 3.0f, 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(CalibrationChangeTest)
+{
+  // Every pixel of a 4x4 sensor is linear (ToT = 2E + 10), written with 4 fractional bits
+  std::vector<float> coefficients(4 * 4 * FrameProcessor::calibration_coefficients, 0.0f);
+  for (size_t pixel = 0; pixel < 4 * 4; pixel++){
+    coefficients[pixel * FrameProcessor::calibration_coefficients] = 2.0f;
+    coefficients[pixel * FrameProcessor::calibration_coefficients + 1] = 10.0f;
+  }
+  boost::shared_ptr<FrameProcessor::LATRDEnergyCalibration> fixed_calibration(
+      new FrameProcessor::LATRDEnergyCalibration(4, 4, FrameProcessor::FIXED_ENERGY, 4));
+  fixed_calibration->set_coefficients(coefficients);
+  boost::shared_ptr<FrameProcessor::LATRDEnergyCalibration> float_calibration(
+      new FrameProcessor::LATRDEnergyCalibration(4, 4, FrameProcessor::FLOAT_ENERGY, 0));
+  float_calibration->set_coefficients(coefficients);
+  FrameProcessor::LATRDProcessCoordinator coordinator;
+  BOOST_CHECK_NO_THROW(coordinator.configure_calibration(fixed_calibration));
+  coordinator.configure_clustering(true, 0x10000000000ULL);
+
+  // One event of raw energy 30 at pixel (1, 1) is held in its wrap
+  std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+  header->packet_state[0] = 1;
+  uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader));
+  packet[1] = 7;
+  packet[2] = 0;
+  packet[3] = LATRD::control_word_mask | 0x800;
+  uint64_t position = ((uint64_t)1 << LATRD::position_x_shift) | 1;
+  packet[4] = (position << 37) | ((uint64_t)0x10 << 14) | 30;
+  boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+  frame->set_frame_number(0);
+  frame->copy_data(&buffer[0], buffer.size());
+  coordinator.process_frame(frame);
+
+  // The energy dataset type cannot change until the held events are written
+  BOOST_CHECK_THROW(coordinator.configure_calibration(float_calibration), FrameProcessor::LATRDProcessingException);
+
+  std::vector<char> idle_buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  ((LATRD::FrameHeader *)&idle_buffer[0])->idle_frame = 1;
+  boost::shared_ptr<FrameProcessor::Frame> idle_frame(new FrameProcessor::Frame("raw"));
+  idle_frame->copy_data(&idle_buffer[0], idle_buffer.size());
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames = coordinator.process_frame(idle_frame);
+  std::map<std::string, boost::shared_ptr<FrameProcessor::Frame> > datasets;
+  for (size_t index = 0; index < frames.size(); index++){
+    datasets[frames[index]->get_dataset_name()] = frames[index];
+  }
+
+  // The fixed point energy of 10 keV is written as an integer, and the cluster energy is back in keV
+  BOOST_REQUIRE(datasets.count("event_energy") > 0);
+  BOOST_CHECK_EQUAL(datasets["event_energy"]->get_data_type(), 2);
+  BOOST_CHECK_EQUAL(((const uint32_t *)datasets["event_energy"]->get_data())[0], 160);
+  BOOST_REQUIRE(datasets.count("cluster_energy") > 0);
+  BOOST_CHECK_CLOSE(((const float *)datasets["cluster_energy"]->get_data())[0], 10.0f, 0.001);
+
+  // Once everything is written the calibration can be changed
+  BOOST_CHECK_NO_THROW(coordinator.configure_calibration(float_calibration));
+}
+
+BOOST_AUTO_TEST_CASE(CompressionFailureTest)
+{
+  if (FrameProcessor::LATRDCompressor::available()){
+    FrameProcessor::LATRDProcessCoordinator coordinator;
+    coordinator.configure_compression(FrameProcessor::BSLZ4_COMPRESSION, false);
+    uint64_t values[64];
+    for (int index = 0; index < 64; index++){
+      values[index] = index;
+    }
+    std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames;
+    frames.push_back(boost::shared_ptr<FrameProcessor::Frame>(new FrameProcessor::Frame("event_time_offset")));
+    frames.push_back(boost::shared_ptr<FrameProcessor::Frame>(new FrameProcessor::Frame("event_energy")));
+    for (int index = 0; index < 2; index++){
+      frames[index]->copy_data(values, sizeof(values));
+      frames[index]->set_frame_number(index);
+      frames[index]->set_data_type(3);
+    }
+    // An unknown data type cannot be compressed
+    frames[1]->set_data_type(9);
+
+    // The frame that failed is dropped rather than mixed uncompressed into a compressed dataset
+    std::vector<boost::shared_ptr<FrameProcessor::Frame> > compressed = coordinator.compress_frames(frames);
+    BOOST_REQUIRE_EQUAL(compressed.size(), 1);
+    BOOST_CHECK_EQUAL(compressed[0]->get_dataset_name(), "event_time_offset");
+    BOOST_CHECK(compressed[0] != frames[0]);
+    BOOST_CHECK_EQUAL(coordinator.get_compression_failures(), 1);
+    coordinator.reset_statistics();
+    BOOST_CHECK_EQUAL(coordinator.get_compression_failures(), 0);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END(); //CoordinatorUnitTest
 
 
@@ -230,5 +1578,178 @@ BOOST_AUTO_TEST_CASE(TimestampTest)
 
 }
 
+BOOST_AUTO_TEST_CASE(TimestampTrackerTest)
+{
+  FrameProcessor::LATRDTimestampTracker tracker;
+
+  // Without a delta the rollover is assumed
+  BOOST_CHECK_EQUAL(tracker.delta(3), 0);
+  BOOST_CHECK_EQUAL(tracker.previous(3, 10000000), 10000000 - LATRD::course_timestamp_rollover);
+
+  // Consecutive timestamps record the delta for that producer only
+  tracker.record(3, 1000, 1500);
+  tracker.record(3, 1500, 1500);
+  BOOST_CHECK_EQUAL(tracker.delta(3), 500);
+  BOOST_CHECK_EQUAL(tracker.delta(4), 0);
+  BOOST_CHECK_EQUAL(tracker.previous(3, 2000), 1500);
+  BOOST_CHECK_EQUAL(tracker.mismatches(), 0);
+
+  // An inconsistent delta is counted and does not replace the recorded delta
+  tracker.record(3, 1500, 1600);
+  BOOST_CHECK_EQUAL(tracker.delta(3), 500);
+  BOOST_CHECK_EQUAL(tracker.mismatches(), 1);
+
+  // A run of agreeing intervals replaces a wrong recorded delta
+  tracker.record(3, 1600, 1700);
+  tracker.record(3, 1700, 1800);
+  BOOST_CHECK_EQUAL(tracker.delta(3), 500);
+  tracker.record(3, 1800, 1900);
+  BOOST_CHECK_EQUAL(tracker.delta(3), 100);
+  BOOST_CHECK_EQUAL(tracker.mismatches(), 4);
+
+  // but a run broken by a consistent interval does not
+  for (int index = 0; index < 3; index++){
+    tracker.record(3, 2000, 2500);
+  }
+  tracker.record(3, 2500, 2600);
+  tracker.record(3, 2600, 3100);
+  BOOST_CHECK_EQUAL(tracker.delta(3), 100);
+
+  tracker.reset();
+  BOOST_CHECK_EQUAL(tracker.delta(3), 0);
+  BOOST_CHECK_EQUAL(tracker.mismatches(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END(); //TimestampUnitTest
 
+
+BOOST_AUTO_TEST_SUITE(PluginUnitTest);
+
+BOOST_AUTO_TEST_CASE(RawModeTest)
+{
+  FrameProcessor::LATRDProcessPlugin plugin;
+  boost::shared_ptr<TestFrameCallback> output(new TestFrameCallback());
+  plugin.register_callback("output", output, true);
+  OdinData::IpcMessage config;
+  OdinData::IpcMessage reply;
+  config.set_param("raw_mode", 1);
+  plugin.configure(config, reply);
+
+  // Packets 0, 3 and 7 arrive in the first frame and packet 1 in the second
+  int packet_frame[4] = {0, 0, 0, 1};
+  int packet_index[4] = {0, 3, 7, 1};
+  uint64_t word_counts[4] = {5, 12, 3, 7};
+  std::vector<std::vector<char> > buffers(2, std::vector<char>(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0));
+  std::vector<uint64_t> expected_headers;
+  for (int index = 0; index < 4; index++){
+    char *buffer = &buffers[packet_frame[index]][0];
+    LATRD::FrameHeader *header = (LATRD::FrameHeader *)buffer;
+    header->packet_state[packet_index[index]] = 1;
+    uint64_t *packet = (uint64_t *)(buffer + sizeof(LATRD::FrameHeader) + (packet_index[index] * LATRD::primary_packet_size));
+    packet[0] = 0xFFFFFFFFFFFFFFFF;
+    packet[1] = 0x0004000000000000 | word_counts[index];
+    packet[2] = 100 + index;
+    for (uint64_t word = 3; word < word_counts[index] + 2; word++){
+      packet[word] = (index << 16) | word;
+    }
+    expected_headers.push_back(packet[1]);
+    expected_headers.push_back(packet[2]);
+  }
+  std::vector<boost::shared_ptr<FrameProcessor::Frame> > frames;
+  for (int index = 0; index < 2; index++){
+    boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+    frame->set_frame_number(index + 10);
+    frame->copy_data(&buffers[index][0], buffers[index].size());
+    frames.push_back(frame);
+    static_cast<FrameProcessor::IFrameCallback&>(plugin).callback(frame);
+  }
+  // The received frames are forwarded as they arrive without being copied
+  BOOST_REQUIRE_EQUAL(output->frames.size(), 2);
+  for (int index = 0; index < 2; index++){
+    BOOST_CHECK(output->frames[index] == frames[index]);
+    BOOST_CHECK_EQUAL(output->frames[index]->get_dataset_name(), "raw_data");
+    BOOST_CHECK_EQUAL(output->frames[index]->get_frame_number(), index);
+  }
+
+  // The index is not written until its buffers fill or the acquisition goes idle
+  std::vector<char> idle_buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  ((LATRD::FrameHeader *)&idle_buffer[0])->idle_frame = 1;
+  boost::shared_ptr<FrameProcessor::Frame> idle_frame(new FrameProcessor::Frame("raw"));
+  idle_frame->copy_data(&idle_buffer[0], idle_buffer.size());
+  static_cast<FrameProcessor::IFrameCallback&>(plugin).callback(idle_frame);
+
+  BOOST_REQUIRE_EQUAL(output->frames.size(), 4);
+  BOOST_CHECK_EQUAL(output->frames[2]->get_dataset_name(), "raw_packet_offset");
+  BOOST_CHECK_EQUAL(output->frames[3]->get_dataset_name(), "raw_packet_header");
+  // Each packet is located by its offset into the raw dataset and described by its two header words
+  size_t frame_words = LATRD::total_frame_size / sizeof(uint64_t);
+  const uint64_t *offsets = (const uint64_t *)output->frames[2]->get_data();
+  for (int index = 0; index < 4; index++){
+    BOOST_CHECK_EQUAL(offsets[index] / frame_words, packet_frame[index]);
+    const uint64_t *raw_data = (const uint64_t *)output->frames[packet_frame[index]]->get_data();
+    const uint64_t *packet = raw_data + (offsets[index] % frame_words);
+    BOOST_CHECK_EQUAL(packet[0], 0xFFFFFFFFFFFFFFFF);
+    BOOST_CHECK_EQUAL(packet[1], expected_headers[index * 2]);
+    BOOST_CHECK_EQUAL(packet[2], expected_headers[index * 2 + 1]);
+    BOOST_CHECK_EQUAL(packet[word_counts[index] + 1], (uint64_t)((index << 16) | (word_counts[index] + 1)));
+  }
+  const uint64_t *headers = (const uint64_t *)output->frames[3]->get_data();
+  for (size_t index = 0; index < expected_headers.size(); index++){
+    BOOST_CHECK_EQUAL(headers[index], expected_headers[index]);
+  }
+  BOOST_CHECK_EQUAL(output->frames[2]->get_frame_number(), output->frames[3]->get_frame_number());
+}
+
+BOOST_AUTO_TEST_CASE(DualModeTest)
+{
+  FrameProcessor::LATRDProcessPlugin plugin;
+  boost::shared_ptr<TestFrameCallback> output(new TestFrameCallback());
+  plugin.register_callback("output", output, true);
+  OdinData::IpcMessage config;
+  OdinData::IpcMessage reply;
+  config.set_param("raw_mode", 2);
+  plugin.configure(config, reply);
+
+  // A single packet holding an extended timestamp followed by two events
+  std::vector<char> buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  LATRD::FrameHeader *header = (LATRD::FrameHeader *)&buffer[0];
+  header->packet_state[0] = 1;
+  uint64_t *packet = (uint64_t *)(&buffer[0] + sizeof(LATRD::FrameHeader));
+  packet[1] = 5;
+  packet[2] = 0;
+  packet[3] = LATRD::control_word_mask | 0x800;
+  packet[4] = ((uint64_t)12 << 37) | ((uint64_t)0x10 << 14) | 300;
+  packet[5] = ((uint64_t)34 << 37) | ((uint64_t)0x20 << 14) | 400;
+  boost::shared_ptr<FrameProcessor::Frame> frame(new FrameProcessor::Frame("raw"));
+  frame->set_frame_number(0);
+  frame->copy_data(&buffer[0], buffer.size());
+  static_cast<FrameProcessor::IFrameCallback&>(plugin).callback(frame);
+
+  std::vector<char> idle_buffer(sizeof(LATRD::FrameHeader) + LATRD::data_type_size, 0);
+  ((LATRD::FrameHeader *)&idle_buffer[0])->idle_frame = 1;
+  boost::shared_ptr<FrameProcessor::Frame> idle_frame(new FrameProcessor::Frame("raw"));
+  idle_frame->copy_data(&idle_buffer[0], idle_buffer.size());
+  static_cast<FrameProcessor::IFrameCallback&>(plugin).callback(idle_frame);
+
+  // The same input is recorded as raw packets and decoded into events
+  std::map<std::string, boost::shared_ptr<FrameProcessor::Frame> > datasets;
+  for (size_t index = 0; index < output->frames.size(); index++){
+    datasets[output->frames[index]->get_dataset_name()] = output->frames[index];
+  }
+  BOOST_REQUIRE(datasets.count("raw_data") > 0);
+  BOOST_REQUIRE(datasets.count("raw_packet_offset") > 0);
+  BOOST_REQUIRE(datasets.count("event_time_offset") > 0);
+  BOOST_REQUIRE(datasets.count("event_energy") > 0);
+  BOOST_CHECK(datasets["raw_data"] == frame);
+  const uint64_t *offsets = (const uint64_t *)datasets["raw_packet_offset"]->get_data();
+  BOOST_CHECK_EQUAL(offsets[0], sizeof(LATRD::FrameHeader) / sizeof(uint64_t));
+  const uint64_t *event_time = (const uint64_t *)datasets["event_time_offset"]->get_data();
+  BOOST_CHECK_EQUAL(event_time[0], 0x10);
+  BOOST_CHECK_EQUAL(event_time[1], 0x20);
+  const uint32_t *event_energy = (const uint32_t *)datasets["event_energy"]->get_data();
+  BOOST_CHECK_EQUAL(event_energy[0], 300);
+  BOOST_CHECK_EQUAL(event_energy[1], 400);
+  BOOST_CHECK_EQUAL(event_energy[2], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); //PluginUnitTest
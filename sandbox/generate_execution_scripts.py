@@ -79,7 +79,7 @@ def generate_fp_json(out_dir, total, number):
       "dataset": {
         "raw_data": {
           "datatype": 3,
-          "chunks": [524288]
+          "chunks": [102417]
         }
       }
     }
@@ -12,15 +12,24 @@ class RawH5StackReader(object):
         self.files.sort(key=lambda x: os.path.getmtime(x), reverse=True)
         os.chdir(cpath)
         self._current_file = h5py.File(self.files.pop(), 'r', libver='latest', swmr=True)
+        self.open_datasets()
+        self.buffer = self.read_lines(10000)
+
+    def open_datasets(self):
+        # Raw frames are written as received, so packets are found through the offset index
         self._raw_dset = self._current_file["/raw_data"]
+        self._offset_dset = self._current_file["/raw_packet_offset"]
+        self._header_dset = self._current_file["/raw_packet_header"]
         self._current_index = 0
-        self.buffer = self.read_lines(10000)
 
     def read_lines(self, no_of_lines):
         lines = []
-        for data in self._raw_dset[self._current_index:self._current_index+no_of_lines]:
-            lines.append("{:X}".format(data))
-        self._current_index += no_of_lines
+        while len(lines) < no_of_lines and self._current_index < len(self._offset_dset):
+            offset = int(self._offset_dset[self._current_index])
+            word_count = int(self._header_dset[self._current_index * 2]) & 0x7FF
+            for data in self._raw_dset[offset:offset+word_count+2]:
+                lines.append("{:X}".format(data))
+            self._current_index += 1
         return lines
 
     def read_next(self):
@@ -34,8 +43,7 @@ class RawH5StackReader(object):
                     filename = self.files.pop()
                     print("Moving to new file '%s'" %(filename))
                     self._current_file = h5py.File(self.files.pop(), 'r', libver='latest', swmr=True)
-                    self._raw_dset = self._current_file["/raw_data"]
-                    self._current_index = 0
+                    self.open_datasets()
                     self.buffer = self.read_lines(10000)
                 else :
                     # no more files, so return None to signify end of files
@@ -132,7 +132,7 @@ def main():
             "dataset": {
                 "raw_data": {
                     "datatype": 3,
-                    "chunks": [524288]
+                    "chunks": [102417]
                 }
             }
         }